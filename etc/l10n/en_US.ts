@@ -17,6 +17,11 @@
         <source />
         <translation>Open an image</translation>
     </message>
+    <message id="ui.save.description">
+        <location filename="../../src/widgetsgui/main/maineditorview.cpp" line="101" />
+        <source />
+        <translation>Save the image</translation>
+    </message>
     <message id="ui.new.description">
         <location filename="../../src/widgetsgui/main/maineditorview.cpp" line="105" />
         <source />
@@ -32,11 +37,46 @@
         <source />
         <translation>Redo</translation>
     </message>
+    <message id="ui.previous-image.name">
+        <location filename="../../src/widgetsgui/main/maineditorview.cpp" line="140" />
+        <source />
+        <translation>Previous</translation>
+    </message>
+    <message id="ui.previous-image.description">
+        <location filename="../../src/widgetsgui/main/maineditorview.cpp" line="141" />
+        <source />
+        <translation>Show the previous image in the folder</translation>
+    </message>
+    <message id="ui.next-image.name">
+        <location filename="../../src/widgetsgui/main/maineditorview.cpp" line="146" />
+        <source />
+        <translation>Next</translation>
+    </message>
+    <message id="ui.next-image.description">
+        <location filename="../../src/widgetsgui/main/maineditorview.cpp" line="147" />
+        <source />
+        <translation>Show the next image in the folder</translation>
+    </message>
+    <message id="ui.edit.name">
+        <location filename="../../src/widgetsgui/main/maineditorview.cpp" line="123" />
+        <source />
+        <translation>Edit</translation>
+    </message>
+    <message id="ui.edit.description">
+        <location filename="../../src/widgetsgui/main/maineditorview.cpp" line="124" />
+        <source />
+        <translation>Edit this image</translation>
+    </message>
     <message id="ui.open-document.title">
         <location filename="../../src/widgetsgui/main/maineditorview.cpp" line="195" />
         <source />
         <translation>Open a file</translation>
     </message>
+    <message id="ui.save-document.title">
+        <location filename="../../src/widgetsgui/main/maineditorview.cpp" line="217" />
+        <source />
+        <translation>Save as</translation>
+    </message>
     <message id="brush-tool.brush-selection.name">
         <location filename="../../src/widgetsgui/main/tooloptionsbars/brushtooloptionsbar.cpp" line="42" />
         <source />
@@ -339,6 +379,11 @@
         <source>You may not specify multiple modes to start Addle in.</source>
         <translation>You may not specify multiple modes to start Addle in.</translation>
     </message>
+    <message id="cli-messages.invalid-argument-error">
+        <location filename="../../src/common/exceptions/commandlineexceptions.hpp" line="84" />
+        <source>The value "%2" is not valid for the option "%1".</source>
+        <translation>The value "%2" is not valid for the option "%1".</translation>
+    </message>
     <message id="debug-messages.initialize-error.not-initialized">
         <location filename="../../src/common/exceptions/initializeexceptions.hpp" line="57" />
         <source>Attempted operation on object that was not yet initialized.</source>
@@ -403,6 +448,11 @@ Why code:    %2</translation>
         <source>Layer %1</source>
         <translation>Layer %1</translation>
     </message>
+    <message id="templates.background-layer-name">
+        <location filename="../../src/core/format/openrasterformatdriver.cpp" line="206" />
+        <source>Background</source>
+        <translation>Background</translation>
+    </message>
     <message id="templates.layer-group-name">
         <location filename="../../src/core/presenters/helpers/documentlayershelper.hpp" line="145" />
         <source>Layer Group %1</source>
@@ -438,11 +488,28 @@ Why code:    %2</translation>
         <extracomment>Displayed when the document failed to open, but the reason why could not be determined.</extracomment>
         <translation>An unknown error occurred attempting to open the document.</translation>
     </message>
+    <message id="ui.save-document.invalid-format-error">
+        <location filename="../../src/core/presenters/maineditorpresenter.cpp" line="342" />
+        <source />
+        <extracomment>Displayed after attempting to save a document to a file whose format is not recognized or cannot be written. %1 = the name of the file</extracomment>
+        <translation>The document could not be saved as "%1" because its format is unrecognized or unsupported.</translation>
+    </message>
+    <message id="ui.save-document.file-error">
+        <location filename="../../src/core/presenters/maineditorpresenter.cpp" line="350" />
+        <source />
+        <extracomment>Displayed after attempting to save a document to a file that could not be written, e.g., because permission was denied. %1 = the file path</extracomment>
+        <translation>The document could not be written to "%1".</translation>
+    </message>
     <message id="debug-messages.remote-url-not-supported">
         <location filename="../../src/core/presenters/maineditorpresenter.cpp" line="344" />
         <source>Loading a document from a remote URL is not yet supported.</source>
         <translation>Loading a document from a remote URL is not yet supported.</translation>
     </message>
+    <message id="debug-messages.remote-url-save-not-supported">
+        <location filename="../../src/core/presenters/maineditorpresenter.cpp" line="425" />
+        <source>Saving a document to a remote URL is not yet supported.</source>
+        <translation>Saving a document to a remote URL is not yet supported.</translation>
+    </message>
     <message id="debug-messages.application-service.starting">
         <location filename="../../src/core/services/applicationservice.cpp" line="43" />
         <source>Starting ApplicationService.</source>
@@ -479,6 +546,11 @@ Why code:    %2</translation>
         <source>Explicitly start Addle in browser mode.</source>
         <translation>Explicitly start Addle in browser mode.</translation>
     </message>
+    <message id="cli-messages.options.new-instance-description">
+        <location filename="../../src/core/services/applicationservice.cpp" line="189" />
+        <source>Start a new instance of Addle, rather than opening the file in one that is already running.</source>
+        <translation>Start a new instance of Addle, rather than opening the file in one that is already running.</translation>
+    </message>
     <message id="cli-messages.options.open-name">
         <location filename="../../src/core/services/applicationservice.cpp" line="155" />
         <source>open</source>
@@ -486,8 +558,113 @@ Why code:    %2</translation>
     </message>
     <message id="cli-messages.options.open.description">
         <location filename="../../src/core/services/applicationservice.cpp" line="157" />
-        <source>The file or url to open.</source>
-        <translation>The file or url to open.</translation>
+        <source>The file or url to open, or "convert" followed by files to convert.</source>
+        <translation>The file or url to open, or "convert" followed by files to convert.</translation>
+    </message>
+    <message id="cli-messages.options.to-description">
+        <location filename="../../src/core/services/applicationservice.cpp" line="168" />
+        <source>(convert) The format to convert files to, by file extension, e.g., "jpg".</source>
+        <translation>(convert) The format to convert files to, by file extension, e.g., "jpg".</translation>
+    </message>
+    <message id="cli-messages.options.to-value">
+        <location filename="../../src/core/services/applicationservice.cpp" line="170" />
+        <source>extension</source>
+        <translation>extension</translation>
+    </message>
+    <message id="cli-messages.options.resize-description">
+        <location filename="../../src/core/services/applicationservice.cpp" line="177" />
+        <source>(convert) Resize images to fit within WIDTHxHEIGHT, or by PERCENT%.</source>
+        <translation>(convert) Resize images to fit within WIDTHxHEIGHT, or by PERCENT%.</translation>
+    </message>
+    <message id="cli-messages.options.resize-value">
+        <location filename="../../src/core/services/applicationservice.cpp" line="179" />
+        <source>size</source>
+        <translation>size</translation>
+    </message>
+    <message id="cli-messages.options.output-description">
+        <location filename="../../src/core/services/applicationservice.cpp" line="189" />
+        <source>(convert) The directory to write converted files to. By default, they are written alongside the originals.</source>
+        <translation>(convert) The directory to write converted files to. By default, they are written alongside the originals.</translation>
+    </message>
+    <message id="cli-messages.options.output-value">
+        <location filename="../../src/core/services/applicationservice.cpp" line="191" />
+        <source>directory</source>
+        <translation>directory</translation>
+    </message>
+    <message id="cli-messages.options.jobs-description">
+        <location filename="../../src/core/services/applicationservice.cpp" line="201" />
+        <source>(convert) The number of files to convert at once. By default, one per processor core.</source>
+        <translation>(convert) The number of files to convert at once. By default, one per processor core.</translation>
+    </message>
+    <message id="cli-messages.options.jobs-value">
+        <location filename="../../src/core/services/applicationservice.cpp" line="203" />
+        <source>count</source>
+        <translation>count</translation>
+    </message>
+    <message id="cli-messages.options.trace-startup-description">
+        <location filename="../../src/core/services/applicationservice.cpp" line="211" />
+        <source>Write a timeline of startup to the given file, in Chrome trace format.</source>
+        <translation>Write a timeline of startup to the given file, in Chrome trace format.</translation>
+    </message>
+    <message id="cli-messages.options.trace-startup-value">
+        <location filename="../../src/core/services/applicationservice.cpp" line="213" />
+        <source>file</source>
+        <translation>file</translation>
+    </message>
+    <message id="cli-messages.trace-startup.write-error">
+        <location filename="../../src/common/utilities/debugging/startuptrace.cpp" line="162" />
+        <source>Could not write the startup trace to "%1".</source>
+        <translation>Could not write the startup trace to "%1".</translation>
+    </message>
+    <message id="cli-messages.convert.missing-to">
+        <location filename="../../src/core/services/applicationservice.cpp" line="225" />
+        <source>Missing option "--to" for "convert".</source>
+        <translation>Missing option "--to" for "convert".</translation>
+    </message>
+    <message id="cli-messages.convert.unsupported-format">
+        <location filename="../../src/core/services/batchconverter.cpp" line="129" />
+        <source>The output format "%1" is not supported.</source>
+        <translation>The output format "%1" is not supported.</translation>
+    </message>
+    <message id="cli-messages.convert.no-inputs">
+        <location filename="../../src/core/services/batchconverter.cpp" line="139" />
+        <source>No input files were found.</source>
+        <translation>No input files were found.</translation>
+    </message>
+    <message id="cli-messages.convert.output-directory-failed">
+        <location filename="../../src/core/services/batchconverter.cpp" line="149" />
+        <source>The output directory "%1" could not be created.</source>
+        <translation>The output directory "%1" could not be created.</translation>
+    </message>
+    <message id="cli-messages.convert.output-collision">
+        <location filename="../../src/core/services/batchconverter.cpp" line="172" />
+        <source>%1 and %2 would both be converted to %3.</source>
+        <translation>%1 and %2 would both be converted to %3.</translation>
+    </message>
+    <message id="cli-messages.convert.file-result">
+        <location filename="../../src/core/services/batchconverter.cpp" line="171" />
+        <source>%1 -&gt; %2: %3 ms (import %4 ms, transform %5 ms, export %6 ms)</source>
+        <translation>%1 -&gt; %2: %3 ms (import %4 ms, transform %5 ms, export %6 ms)</translation>
+    </message>
+    <message id="cli-messages.convert.file-error">
+        <location filename="../../src/core/services/batchconverter.cpp" line="184" />
+        <source>%1: conversion failed: %2</source>
+        <translation>%1: conversion failed: %2</translation>
+    </message>
+    <message id="cli-messages.convert.summary">
+        <location filename="../../src/core/services/batchconverter.cpp" line="195" />
+        <source>Converted %1 of %2 files in %3 s (%4 files/s, %5 megapixels/s)</source>
+        <translation>Converted %1 of %2 files in %3 s (%4 files/s, %5 megapixels/s)</translation>
+    </message>
+    <message id="cli-messages.convert.would-overwrite">
+        <location filename="../../src/core/services/batchconverter.cpp" line="215" />
+        <source>the output would overwrite the input.</source>
+        <translation>the output would overwrite the input.</translation>
+    </message>
+    <message id="cli-messages.convert.unknown-error">
+        <location filename="../../src/core/services/batchconverter.cpp" line="329" />
+        <source>an error occurred.</source>
+        <translation>an error occurred.</translation>
     </message>
     <message id="debug-messages.application-service.cli-open-url">
         <location filename="../../src/core/services/applicationservice.cpp" line="192" />
@@ -529,6 +706,21 @@ Why code:    %2</translation>
         <source>Quitting application service</source>
         <translation>Quitting application service</translation>
     </message>
+    <message id="debug-messages.application-service.forwarded-to-instance">
+        <location filename="../../src/core/services/applicationservice.cpp" line="476" />
+        <source>Forwarded startup to the running instance.</source>
+        <translation>Forwarded startup to the running instance.</translation>
+    </message>
+    <message id="debug-messages.application-service.instance-listen-error">
+        <location filename="../../src/core/services/applicationservice.cpp" line="505" />
+        <source>Could not listen for other instances: %1</source>
+        <translation>Could not listen for other instances: %1</translation>
+    </message>
+    <message id="debug-messages.application-service.instance-open">
+        <location filename="../../src/core/services/applicationservice.cpp" line="559" />
+        <source>Opening "%1" for another instance.</source>
+        <translation>Opening "%1" for another instance.</translation>
+    </message>
     <message id="debug-messages.assert-failed-m">
         <location filename="../../src/common/utilities/errors.cpp" line="24" />
         <source>%1
@@ -607,6 +799,11 @@ requestedInterfaceName: "%1"
         <oldsource>DebugBehavior initialized with these values:</oldsource>
         <translation>DebugBehavior initialized with these flags set:</translation>
     </message>
+    <message id="debug-messages.pixel-kernels.unsupported-override">
+        <location filename="../../src/common/utilities/image/pixelkernels.cpp" line="205" />
+        <source>The pixel kernels "%1" were requested, but are not supported. The best supported kernels will be used instead.</source>
+        <translation>The pixel kernels "%1" were requested, but are not supported. The best supported kernels will be used instead.</translation>
+    </message>
     <message id="debug-messages.qt-warning-as-exception">
         <location filename="../../src/common/utilities/debugging/messagehandler.hpp" line="48" />
         <source>A Qt warning was intercepted (%1):
@@ -647,9 +844,20 @@ requestedInterfaceName: "%1"
     </message>
     <message id="debug-messages.io-check.unknown-device-error">
         <location filename="../../src/common/utilities/iocheck.cpp" line="72" />
+        <location filename="../../src/common/utilities/iocheck.cpp" line="190" />
         <source>An error occurred but the device type is unknown / unsupported so it could not be diagnosed.</source>
         <translation>An error occurred but the device type is unknown / unsupported so it could not be diagnosed.</translation>
     </message>
+    <message id="debug-messages.cancelled">
+        <location filename="../../src/common/exceptions/cancelledexception.hpp" line="32" />
+        <source>The operation was cancelled.</source>
+        <translation>The operation was cancelled.</translation>
+    </message>
+    <message id="debug-messages.mapped-file-device.read-only">
+        <location filename="../../src/common/utilities/mappedfiledevice.cpp" line="30" />
+        <source>MappedFileDevice can only be opened for reading.</source>
+        <translation>MappedFileDevice can only be opened for reading.</translation>
+    </message>
     <message id="debug-messages.io-check.invalid-file-mode">
         <location filename="../../src/common/utilities/iocheck.cpp" line="105" />
         <source>The file mode was not understood.</source>
@@ -7,13 +7,16 @@
  */
 
 #include <QApplication>
+#include <QCoreApplication>
 #include <QTranslator>
+#include <QStringList>
 #include <vector>
 #include <memory>
 
 #include "serviceconfiguration.hpp"
 #include "utilities/configuration/registerqmetatypes.hpp"
 #include "utilities/qobject.hpp"
+#include "utilities/debugging/startuptrace.hpp"
 
 #include "interfaces/services/iapplicationsservice.hpp"
 
@@ -21,6 +24,7 @@
 #include "utils.hpp"
 
 #include "core/presenters/tools/navigatetoolpresenter.hpp"
+#include "core/services/applicationservice.hpp"
 
 #ifdef ADDLE_DEBUG
 #include "utilities/debugging/messagehandler.hpp"
@@ -30,27 +34,48 @@ using namespace Addle;
 
 int main(int argc, char *argv[])
 {
+    StartupTrace::enableFromArguments(argc, argv);
+
 #ifdef ADDLE_DEBUG
 #endif //ADDLE_DEBUG
     registerQMetaTypes();
 
-    QApplication a(argc, argv);
+    // Batch conversion runs without a graphical interface, so it does not
+    // connect to the windowing system. The application object that would
+    // otherwise provide the arguments does not exist yet.
+    QStringList arguments;
+    for (int i = 0; i < argc; ++i)
+        arguments.append(QString::fromLocal8Bit(argv[i]));
+
+    const bool headless = ApplicationService::isConvertCommand(arguments);
+
+    std::unique_ptr<QCoreApplication> app;
+    {
+        ADDLE_TRACE_STARTUP("QApplication");
+        app.reset(headless ? new QCoreApplication(argc, argv) : new QApplication(argc, argv));
+    }
+    QCoreApplication& a = *app;
     a.setApplicationName(ADDLE_NAME);
     a.setApplicationVersion(ADDLE_VERSION);
 
     QTranslator fallbackTranslator;
     QTranslator translator;
 
-    fallbackTranslator.load(":/l10n/en_US.qm");
-    a.installTranslator(&fallbackTranslator);
-
-    if (!QLocale().uiLanguages().contains("en_US"))
     {
-        translator.load(QLocale(), QString(), QString(), ":/l10n", ".qm");
-        a.installTranslator(&translator);
+        ADDLE_TRACE_STARTUP("translators");
+
+        fallbackTranslator.load(":/l10n/en_US.qm");
+        a.installTranslator(&fallbackTranslator);
+
+        if (!QLocale().uiLanguages().contains("en_US"))
+        {
+            translator.load(QLocale(), QString(), QString(), ":/l10n", ".qm");
+            a.installTranslator(&translator);
+        }
     }
 
-    a.setApplicationDisplayName(qtTrId(ADDLE_NAME_TRID));
+    if (!headless)
+        QGuiApplication::setApplicationDisplayName(qtTrId(ADDLE_NAME_TRID));
 
 #ifdef ADDLE_DEBUG
     //% "Starting Addle. This is a debug build."
@@ -58,7 +83,10 @@ int main(int argc, char *argv[])
 #endif
 
     ServiceConfiguration serviceConfiguration;
-    serviceConfiguration.initialize();
+    {
+        ADDLE_TRACE_STARTUP("ServiceConfiguration::initialize");
+        serviceConfiguration.initialize();
+    }
 
 #ifdef ADDLE_DEBUG
     DebugBehavior::get(); // initialize flags before installing message handler
@@ -73,10 +101,18 @@ int main(int argc, char *argv[])
         QObject::connect(&a, &QCoreApplication::aboutToQuit, [&] () {
             serviceConfiguration.destroy();
         });
+
+        // Normally the trace is finished by the first paint of the canvas,
+        // but not every startup paints one.
+        StartupTrace::mark("event-loop");
+        QObject::connect(&a, &QCoreApplication::aboutToQuit, &StartupTrace::finish);
+
         return a.exec();
     }
     else
     {
+        StartupTrace::finish();
+
         int exitCode = appService.exitCode();
         serviceConfiguration.destroy();
         return exitCode;
@@ -11,6 +11,7 @@
 
 #include "utilities/configuration/autofactory.hpp"
 #include "utilities/configuration/customfactory.hpp"
+#include "utilities/debugging/startuptrace.hpp"
 
 #include "interfaces/models/ibrush.hpp"
 
@@ -46,8 +47,11 @@
 #include "core/services/applicationservice.hpp"
 #include "core/services/errorservice.hpp"
 #include "core/services/formatservice.hpp"
+#include "core/services/thumbnailservice.hpp"
 
 #include "core/format/qtimageformatdriver.hpp"
+#include "core/format/openrasterformatdriver.hpp"
+#include "core/format/nativeformatdriver.hpp"
 
 #include "widgetsgui/main/maineditorview.hpp"
 #include "widgetsgui/main/applicationerrorview.hpp"
@@ -59,6 +63,7 @@ using namespace Addle;
 
 void ServiceConfiguration::configure()
 {
+    ADDLE_TRACE_STARTUP("ServiceConfiguration::configure");
 
     CONFIG_AUTOFACTORY_BY_ID(IBrushEngine, PathBrushEngine::ID, PathBrushEngine);
     CONFIG_AUTOFACTORY_BY_ID(IBrushEngine, RasterBrushEngine::ID, RasterBrushEngine);
@@ -110,6 +115,7 @@ void ServiceConfiguration::configure()
     CONFIG_AUTOFACTORY_BY_TYPE(IApplicationService, ApplicationService);
     CONFIG_AUTOFACTORY_BY_TYPE(IErrorService, ErrorService);
     CONFIG_AUTOFACTORY_BY_TYPE(IFormatService, FormatService);
+    CONFIG_AUTOFACTORY_BY_TYPE(IThumbnailService, ThumbnailService);
 
     // # Formats
     CONFIG_CUSTOMFACTORY_BY_ID(IFormatDriver<IDocument>, CoreFormats::JPEG, 
@@ -118,6 +124,15 @@ void ServiceConfiguration::configure()
     CONFIG_CUSTOMFACTORY_BY_ID(IFormatDriver<IDocument>, CoreFormats::PNG, 
         []() -> IFormatDriver<IDocument>* { return new QtImageFormatDriver(CoreFormats::PNG, "PNG"); }
     );
+    CONFIG_CUSTOMFACTORY_BY_ID(IFormatDriver<IDocument>, CoreFormats::GIF, 
+        []() -> IFormatDriver<IDocument>* { return new QtImageFormatDriver(CoreFormats::GIF, "GIF"); }
+    );
+    CONFIG_CUSTOMFACTORY_BY_ID(IFormatDriver<IDocument>, CoreFormats::ORA, 
+        []() -> IFormatDriver<IDocument>* { return new OpenRasterFormatDriver(); }
+    );
+    CONFIG_CUSTOMFACTORY_BY_ID(IFormatDriver<IDocument>, CoreFormats::Native, 
+        []() -> IFormatDriver<IDocument>* { return new NativeFormatDriver(); }
+    );
 
     // # Views
     CONFIG_AUTOFACTORY_BY_TYPE(IMainEditorView, MainEditorView);
@@ -97,6 +97,28 @@ DEFINE_STATIC_ID_METADATA_CUSTOM(CoreFormats::JPEG, DocumentFormatId::MetaData,
     /*file sig:*/   QByteArrayLiteral("\xFF\xD8\xFF")
 );
 
+// OpenRaster files are zip archives, and have no signature distinguishable
+// from any other zip archive by prefix alone.
+DEFINE_STATIC_ID_METADATA_CUSTOM(CoreFormats::ORA, DocumentFormatId::MetaData,
+                    QUuid(),
+    /*mime type:*/  QStringLiteral("image/openraster"),
+    /*file ext:*/   QStringLiteral("ora")
+);
+
+DEFINE_STATIC_ID_METADATA_CUSTOM(CoreFormats::Native, DocumentFormatId::MetaData,
+                    QUuid(),
+    /*mime type:*/  QStringLiteral("application/x-addle-document"),
+    /*file ext:*/   QStringLiteral("addle"),
+    /*file sig:*/   QByteArrayLiteral("\x89" "ADL\r\n\x1A\n")
+);
+
+DEFINE_STATIC_ID_METADATA_CUSTOM(CoreFormats::GIF, DocumentFormatId::MetaData,
+                    QUuid(),
+    /*mime type:*/  QStringLiteral("image/gif"),
+    /*file ext:*/   QStringLiteral("gif"),
+    /*file sig:*/   QByteArrayLiteral("GIF8")
+);
+
 DEFINE_STATIC_ID_METADATA(CorePalettes::BasicPalette);
 
 DEFINE_STATIC_ID_METADATA(CoreTools::Select);
@@ -124,6 +146,9 @@ QHash<AddleId, QSharedPointer<const AddleId::BaseMetaData>> AddleId::_dynamicMet
 
     STATIC_ID_METADATA_ENTRY(CoreFormats::PNG),
     STATIC_ID_METADATA_ENTRY(CoreFormats::JPEG),
+    STATIC_ID_METADATA_ENTRY(CoreFormats::ORA),
+    STATIC_ID_METADATA_ENTRY(CoreFormats::Native),
+    STATIC_ID_METADATA_ENTRY(CoreFormats::GIF),
 
     STATIC_ID_METADATA_ENTRY(CorePalettes::BasicPalette),
 
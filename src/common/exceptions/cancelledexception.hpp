@@ -0,0 +1,47 @@
+/**
+ * Addle source code
+ * @file
+ * @copyright Copyright 2020 Eleanor Hawk
+ * @copyright Modification and distribution permitted under the terms of the
+ * MIT License. See "LICENSE" for full details.
+ */
+
+#ifndef CANCELLEDEXCEPTION_HPP
+#define CANCELLEDEXCEPTION_HPP
+
+#include "addleexception.hpp"
+
+namespace Addle {
+
+DECL_RUNTIME_ERROR(CancelledException)
+
+/**
+ * @class CancelledException
+ * @brief Thrown from within a long-running operation to abandon it after its
+ * cancellation was requested, e.g., by AsyncTask::cancel().
+ *
+ * This is not an error, and is not reported as one by AsyncTask.
+ */
+class ADDLE_COMMON_EXPORT CancelledException : public AddleException
+{
+    ADDLE_EXCEPTION_BOILERPLATE(CancelledException)
+#ifdef ADDLE_DEBUG
+public:
+    CancelledException()
+        : AddleException(
+            //% "The operation was cancelled."
+            qtTrId("debug-messages.cancelled")
+        )
+    {
+    }
+#else
+public:
+    CancelledException() = default;
+#endif
+public:
+    virtual ~CancelledException() = default;
+};
+
+} // namespace Addle
+
+#endif // CANCELLEDEXCEPTION_HPP
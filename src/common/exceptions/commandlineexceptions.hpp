@@ -72,6 +72,20 @@ public:
     {
     }
 };
+
+DECL_RUNTIME_ERROR(InvalidArgumentException)
+class ADDLE_COMMON_EXPORT InvalidArgumentException : public CommandLineException
+{
+    ADDLE_EXCEPTION_BOILERPLATE(InvalidArgumentException)
+public: 
+    InvalidArgumentException(const QString option, const QString value)
+        : CommandLineException(
+            //% "The value \"%2\" is not valid for the option \"%1\"."
+            qtTrId("cli-messages.invalid-argument-error").arg(option, value)
+        )
+    {
+    }
+};
 } // namespace Addle
 
 #endif // COMMANDLINEEXCEPTIONS_HPP
\ No newline at end of file
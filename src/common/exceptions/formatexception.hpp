@@ -28,7 +28,9 @@ public:
     {
         FormatNotRecognized,
         EmptyResource,
-        WrongModelType
+        WrongModelType,
+        EncodingFailed,
+        DecodingFailed
     };
     Q_ENUM(Why)
 
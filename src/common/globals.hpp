@@ -81,9 +81,15 @@ namespace CoreFormats
 {
     constexpr DocumentFormatId PNG  = START_CORE_FORMAT_IDS + 0x00;
     constexpr DocumentFormatId JPEG = START_CORE_FORMAT_IDS + 0x01;
+    constexpr DocumentFormatId ORA  = START_CORE_FORMAT_IDS + 0x02;
+    constexpr DocumentFormatId Native = START_CORE_FORMAT_IDS + 0x03;
+    constexpr DocumentFormatId GIF  = START_CORE_FORMAT_IDS + 0x04;
 }
 DECLARE_STATIC_FORMAT_ID_METADATA(CoreFormats::PNG,    "format-png");
 DECLARE_STATIC_FORMAT_ID_METADATA(CoreFormats::JPEG,   "format-jpeg");
+DECLARE_STATIC_FORMAT_ID_METADATA(CoreFormats::ORA,    "format-openraster");
+DECLARE_STATIC_FORMAT_ID_METADATA(CoreFormats::Native, "format-addle");
+DECLARE_STATIC_FORMAT_ID_METADATA(CoreFormats::GIF,    "format-gif");
 
 #undef START_CORE_FORMAT
 
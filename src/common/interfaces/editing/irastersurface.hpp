@@ -16,9 +16,13 @@
 
 #include "utilities/image/rasterpainthandle.hpp"
 #include "utilities/image/rasterbithandles.hpp"
+#include "utilities/image/rastertilesource.hpp"
+#include "utilities/hashfunctions.hpp"
 
 #include <QPainter>
 #include <QImage>
+#include <QSet>
+#include <QSharedPointer>
 namespace Addle {
 
 //class IRasterPreview;
@@ -59,6 +63,11 @@ public:
         QPainter::CompositionMode compositionMode = QPainter::CompositionMode_SourceOver,
         InitFlags flags = None
     ) = 0;
+    virtual void initialize(
+        QSharedPointer<RasterTileSource> tileSource,
+        QPainter::CompositionMode compositionMode = QPainter::CompositionMode_SourceOver,
+        InitFlags flags = None
+    ) = 0;
 
     virtual void setCompositionMode(QPainter::CompositionMode mode) = 0;
     virtual QPainter::CompositionMode compositionMode() const = 0;
@@ -73,6 +82,38 @@ public:
 
     //virtual void render(QPainter& painter, QRect area) const = 0;
 
+    // Returns a copy of `area` (or the whole surface if area is null) as an
+    // image. If `offset` is not null, it receives the position of the
+    // image's top left corner on the surface.
+    //
+    // Where possible, the copy shares the surface's data copy-on-write, so it
+    // is inexpensive to take and remains unaffected by later changes to the
+    // surface.
+    //
+    // Throws FormatException if tiles of the tile source in `area` can't be
+    // decoded.
+    virtual QImage copy(QRect area = QRect(), QPoint* offset = nullptr) const = 0;
+
+    // If the surface was initialized from a tile source, this is that source
+    // (or the one most recently given to setTileSource).
+    virtual QSharedPointer<RasterTileSource> tileSource() const = 0;
+
+    // The indices of tiles of the tile source that have been changed on the
+    // surface since it was initialized, or since they were last marked clean
+    // by setTileSource. If `generation` is not null, it receives a counter
+    // that can be passed to setTileSource to mark clean only the tiles
+    // modified up to this point.
+    virtual QSet<QPoint> modifiedTiles(quint64* generation = nullptr) const = 0;
+
+    // Replaces the tile source, e.g., after the surface has been saved, and
+    // marks clean the tiles modified up to `cleanGeneration`. Tiles that
+    // have not yet been decoded will be decoded from the new source.
+    //
+    // If the surface has no tile source, or one of a different tile size,
+    // its changes are not tracked by tile. In that case the new source is
+    // only installed if the surface has not changed since `cleanGeneration`.
+    virtual void setTileSource(QSharedPointer<RasterTileSource> tileSource, quint64 cleanGeneration) = 0;
+
     virtual void clear() = 0;
 
     virtual int alpha() const = 0;
@@ -36,6 +36,12 @@ public:
 
     virtual FormatId<ModelType> id() const = 0;
 
+    // Whether the driver opens files itself when exporting to a QFile, e.g.,
+    // to update an existing file in place. If not, the format service writes
+    // the export to a temporary file, which replaces the original only once
+    // the export has succeeded.
+    virtual bool opensFiles() const { return false; }
+
     virtual ModelType* importModel(QIODevice& device, ImportExportInfo<ModelType> info) = 0;
     virtual void exportModel(ModelType* model, QIODevice& device, ImportExportInfo<ModelType> info) = 0;
 };
@@ -44,6 +44,10 @@ public:
     virtual QString filename() const = 0;
     
     virtual QList<QSharedPointer<ILayer>> layers() const = 0;
+    virtual QList<LayerGroupInfo> layerGroups() const = 0;
+
+    // The frames of the document, if it is an animated image.
+    virtual QSharedPointer<AnimationSource> animation() const = 0;
 
 public slots:
     virtual void setFilename(QString filename) = 0;
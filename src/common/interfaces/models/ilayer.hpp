@@ -33,6 +33,12 @@ public:
     virtual void initialize(const LayerBuilder& builder) = 0;
 
     virtual bool isEmpty() const = 0;
+
+    virtual QString name() const = 0;
+
+    // Indices into IDocument::layerGroups() of the groups containing this
+    // layer, outermost first.
+    virtual QList<int> groupPath() const = 0;
     
     virtual QRect boundary() const = 0;
     virtual QPoint topLeft() const = 0;
@@ -11,6 +11,7 @@
 
 #include <QObject>
 #include <QHash>
+#include <QList>
 
 #include "compat.hpp"
 
@@ -57,6 +58,10 @@ public:
     virtual IViewPortPresenter& viewPortPresenter() const = 0;
     virtual IColorSelectionPresenter& colorSelection() const = 0;
 
+    // Switches between Viewer and Editor mode. The document is kept, so a
+    // viewer can be switched into an editor without reloading it. The
+    // color selection is only available once the presenter has been in
+    // Editor mode.
     virtual void setMode(Mode mode) = 0;
     virtual Mode mode() const = 0;
 
@@ -69,15 +74,29 @@ public:
     virtual ToolId currentTool() const = 0;
     virtual void setCurrentTool(ToolId tool) = 0;
 
-    virtual QHash<ToolId, QSharedPointer<IToolPresenter>> tools() const = 0;
+    // The tools offered in the current mode.
+    virtual QList<ToolId> tools() const = 0;
+
+    // Returns the presenter of `tool`, building it if this is the first time
+    // it has been needed, or null if the tool is not offered in the current
+    // mode.
+    virtual QSharedPointer<IToolPresenter> toolPresenter(ToolId tool) = 0;
 
     virtual QSharedPointer<IToolPresenter> currentToolPresenter() const = 0;
 
     virtual void newDocument() = 0;
     virtual void loadDocument(QUrl url) = 0;
+    virtual void saveDocument(QUrl url) = 0;
+
+    // In Viewer mode, opens the next or previous file in the directory of the
+    // current one.
+    virtual void browseNext() = 0;
+    virtual void browsePrevious() = 0;
 
 signals:
 
+    virtual void modeChanged(IMainEditorPresenter::Mode mode) = 0;
+
     virtual void currentToolChanged(ToolId tool) = 0;
 
     virtual void topSelectedLayerChanged(QSharedPointer<ILayerPresenter>) = 0;
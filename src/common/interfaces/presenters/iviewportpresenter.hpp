@@ -179,6 +179,11 @@ public:
     virtual QPoint globalOffset() const = 0;
     virtual QPointF center() const = 0;
 
+    // True while an interactive gesture (e.g., a grip pan or pivot) is moving
+    // the viewport. Views may trade quality for speed in the meantime, and
+    // should refine when this becomes false.
+    virtual bool isNavigating() const = 0;
+
 public slots:
     virtual void resetTransforms() = 0;
     virtual void fitWidth() = 0;
@@ -187,8 +192,11 @@ public slots:
     virtual void setSize(QSize size) = 0;
     virtual void setGlobalOffset(QPoint offset) = 0;
 
+    virtual void setNavigating(bool navigating) = 0;
+
 signals:
     virtual void transformsChanged() = 0;
+    virtual void navigatingChanged(bool navigating) = 0;
 };
 
 DECL_INTERFACE_META_PROPERTIES(
@@ -24,9 +24,18 @@ public:
     {
         editor,
         browser,
-        terminal
+        terminal,
+
+        // Runs a batch job (e.g., `addle convert ...`) without a graphical
+        // interface, and exits.
+        batch
     };
 
+    // The first command-line argument that starts a batch conversion. The
+    // application is started without a connection to the windowing system
+    // if this is given.
+    static constexpr const char* CONVERT_COMMAND = "convert";
+
     virtual ~IApplicationService() = default;
 
     virtual bool start() = 0;
@@ -38,8 +38,22 @@ public:
         return QSharedPointer<FormatModel>(boost::get<FormatModel*>(importModel_p(device, info).variant()));
     }
 
+    template<class FormatModel>
+    void exportModel(FormatModel& model, QIODevice& device, const ImportExportInfo<FormatModel>& info)
+    {
+        exportModel_p(GenericFormatModel(&model), device, info);
+    }
+
+    // Exports the snapshot set on `info`, without access to the document it
+    // was taken from, e.g., from a thread other than the one that owns it.
+    void exportSnapshot(QIODevice& device, const DocumentImportExportInfo& info)
+    {
+        exportModel_p(GenericFormatModel(static_cast<IDocument*>(nullptr)), device, info);
+    }
+
 protected:
     virtual GenericFormatModel importModel_p(QIODevice& device, const GenericImportExportInfo& info) = 0;
+    virtual void exportModel_p(GenericFormatModel model, QIODevice& device, const GenericImportExportInfo& info) = 0;
 };
 
 DECL_SERVICE(IFormatService)
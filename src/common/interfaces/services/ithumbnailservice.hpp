@@ -0,0 +1,68 @@
+/**
+ * Addle source code
+ * @file
+ * @copyright Copyright 2020 Eleanor Hawk
+ * @copyright Modification and distribution permitted under the terms of the
+ * MIT License. See "LICENSE" for full details.
+ */
+
+#ifndef ITHUMBNAILSERVICE_HPP
+#define ITHUMBNAILSERVICE_HPP
+
+#include <QImage>
+#include <QString>
+
+#include "interfaces/traits.hpp"
+#include "interfaces/iamqobject.hpp"
+
+namespace Addle {
+
+/**
+ * @class IThumbnailService
+ * Provides thumbnails of image files, e.g., for browsing and file pickers.
+ *
+ * Thumbnails are generated in the background and stored in a persistent cache
+ * on disk, which is shared with other applications that follow the
+ * freedesktop.org thumbnail specification. A cached thumbnail is served
+ * without reading the file it was made from.
+ */
+class IThumbnailService : public virtual IAmQObject
+{
+public:
+    // The sizes of thumbnail defined by the freedesktop.org specification.
+    // Thumbnails fit in a square of the given number of pixels.
+    enum Size
+    {
+        Normal = 128,
+        Large = 256,
+        XLarge = 512,
+        XXLarge = 1024
+    };
+
+    virtual ~IThumbnailService() = default;
+
+    // Returns the cached thumbnail of `filename`, or a null image if there is
+    // no thumbnail of the file as it is now. Never generates a thumbnail.
+    virtual QImage cachedThumbnail(const QString& filename, Size size = Normal) const = 0;
+
+    // Asks for a thumbnail of `filename`. `thumbnailReady()` or
+    // `thumbnailFailed()` is emitted once it is available, which may be
+    // soon after, if it is already cached. The most recent requests are
+    // served first.
+    virtual void requestThumbnail(const QString& filename, Size size = Normal) = 0;
+
+    // Abandons requests that have not yet been started.
+    virtual void cancelRequests() = 0;
+
+signals:
+    virtual void thumbnailReady(QString filename, int size, QImage thumbnail) = 0;
+    virtual void thumbnailFailed(QString filename, int size) = 0;
+};
+
+DECL_SERVICE(IThumbnailService)
+
+} // namespace Addle
+
+Q_DECLARE_INTERFACE(Addle::IThumbnailService, "org.addle.IThumbnailService")
+
+#endif // ITHUMBNAILSERVICE_HPP
@@ -46,11 +46,70 @@ namespace Addle {
  * @note
  * Accessing ServiceLocator uses runtime type checking and QHash accessors. It 
  * is expected to be used infrequently by persistent objects. Be mindful of
- * situations where this may be too expensive.
+ * situations where this may be too expensive. Hot paths should resolve a
+ * Handle once, and use it thereafter.
  */
 class ADDLE_COMMON_EXPORT ServiceLocator
 {
 public:
+    /**
+     * @brief A resolved reference to a service or persistent object.
+     * 
+     * Services and persistent objects are owned by the ServiceLocator and
+     * live as long as it does. A handle obtained from resolve() can therefore
+     * be kept and dereferenced any number of times, from any thread, without
+     * the hashing and locking of get().
+     */
+    template<class Interface>
+    class Handle
+    {
+    public:
+        Handle() = default;
+
+        inline Interface& operator*() const { return *_object; }
+        inline Interface* operator->() const { return _object; }
+
+        inline bool isNull() const { return !_object; }
+        explicit inline operator bool() const { return _object; }
+
+        inline bool operator==(const Handle& other) const { return _object == other._object; }
+        inline bool operator!=(const Handle& other) const { return _object != other._object; }
+
+    private:
+        explicit Handle(Interface* object)
+            : _object(object)
+        {
+        }
+
+        Interface* _object = nullptr;
+
+        friend class ServiceLocator;
+    };
+
+    /**
+     * @brief Resolve a service to a Handle.
+     * 
+     * Equivalent to get(), but the result can be kept and used without
+     * further lookups.
+     */
+    template<class Interface>
+    static Handle<Interface> resolve()
+    {
+        return Handle<Interface>(&get<Interface>());
+    }
+
+    /**
+     * @brief Resolve a persistent object to a Handle.
+     * 
+     * Equivalent to get(id), but the result can be kept and used without
+     * further lookups.
+     */
+    template<class Interface, class IdType>
+    static Handle<Interface> resolve(IdType id)
+    {
+        return Handle<Interface>(&get<Interface>(id));
+    }
+
     /**
      * @brief Get a service.
      * 
@@ -6,9 +6,10 @@
  * MIT License. See "LICENSE" for full details.
  */
 
-#include <QThreadPool>
+#include <QDeadlineTimer>
 
 #include "asynctask.hpp"
+#include "exceptions/cancelledexception.hpp"
 
 using namespace Addle;
 
@@ -25,50 +26,68 @@ AsyncTask::Worker::~Worker()
     _owner->_worker = nullptr;
 }
 
+// Expects the owner's state mutex to be locked.
 void AsyncTask::Worker::orphan()
 {
-    if (!_owner) return;
-    const QMutexLocker lock(&_owner->_stateMutex);
     _owner = nullptr;
 }
 
 void AsyncTask::Worker::run()
 {
-    try
     {
-        {
-            if (!_owner) return;
-            const QMutexLocker lock(&_owner->_stateMutex);
-            _owner->_isRunning = true;
-            _owner->_hasCompleted = false;
-            _owner->_hasFailed = false;
-            _owner->_error = QSharedPointer<AddleException>();
-        }
+        if (!_owner) return;
+        const QMutexLocker lock(&_owner->_stateMutex);
+        _owner->_hasCompleted = false;
+        _owner->_hasFailed = false;
+        _owner->_wasCancelled = false;
+        _owner->_error = QSharedPointer<AddleException>();
+    }
 
+    // Once the final signals have been emitted, the owner may be deleted at
+    // any time (e.g., by a connection to `stopped`), so the worker lets go of
+    // it while the state mutex is still locked.
+    const auto finish = [this]() {
+        _owner->_isRunning = false;
+        _owner->_worker = nullptr;
+        _owner->_stoppedCondition.wakeAll();
+        _owner = nullptr;
+    };
+
+    try
+    {
         _owner->doTask();
 
-        {
-            if (!_owner) return;
-            const QMutexLocker lock(&_owner->_stateMutex);
-            _owner->_isRunning = false;
-            _owner->_hasCompleted = true;
+        if (!_owner) return;
+        _owner->flushProgress();
+        const QMutexLocker lock(&_owner->_stateMutex);
+        _owner->_hasCompleted = true;
 
-            emit _owner->stopped();
-            emit _owner->completed();
-        }
+        emit _owner->stopped();
+        emit _owner->completed();
+        finish();
+    }
+    catch (CancelledException&)
+    {
+        if (!_owner) return;
+        _owner->flushProgress();
+        const QMutexLocker lock(&_owner->_stateMutex);
+        _owner->_wasCancelled = true;
+
+        emit _owner->stopped();
+        emit _owner->cancelled();
+        finish();
     }
     catch (AddleException& ex)
     {
-        {
-            if (!_owner) return;
-            const QMutexLocker lock(&_owner->_stateMutex);
-            _owner->_isRunning = false;
-            _owner->_hasFailed = true;
-            _owner->_error = QSharedPointer<AddleException>(ex.clone());
-
-            emit _owner->stopped();
-            emit _owner->failed(_owner->_error);
-        }
+        if (!_owner) return;
+        _owner->flushProgress();
+        const QMutexLocker lock(&_owner->_stateMutex);
+        _owner->_hasFailed = true;
+        _owner->_error = QSharedPointer<AddleException>(ex.clone());
+
+        emit _owner->stopped();
+        emit _owner->failed(_owner->_error);
+        finish();
     }
     // catch(...) ?
 }
@@ -80,18 +99,122 @@ AsyncTask::AsyncTask(QObject* parent)
 
 AsyncTask::~AsyncTask()
 {
+    const QMutexLocker lock(&_stateMutex);
     if (_worker) _worker->orphan();
 }
 
 void AsyncTask::start()
 {
+    TaskScheduler::Lane lane;
     {
         const QMutexLocker lock(&_stateMutex);
 
         if (_isRunning || _worker) return;
 
+        _isRunning = true;
+        _cancelRequested.storeRelease(false);
         _worker = new Worker(this);
+        lane = _lane;
+    }
+    {
+        const QMutexLocker lock(&_ioMutex);
+        _progressTimer.invalidate();
+        _progressPending = false;
+    }
+
+    TaskScheduler::pool(lane).start(_worker);
+}
+
+void AsyncTask::sync()
+{
+    const QMutexLocker lock(&_stateMutex);
+    while (_isRunning)
+        _stoppedCondition.wait(&_stateMutex);
+}
+
+bool AsyncTask::trySync(int timeout)
+{
+    const QDeadlineTimer deadline(timeout);
+
+    const QMutexLocker lock(&_stateMutex);
+    while (_isRunning)
+    {
+        if (!_stoppedCondition.wait(&_stateMutex, deadline))
+            break;
+    }
+    return !_isRunning;
+}
+
+void AsyncTask::cancel()
+{
+    const QMutexLocker lock(&_stateMutex);
+    if (_isRunning)
+        _cancelRequested.storeRelease(true);
+}
+
+void AsyncTask::checkCancelled() const
+{
+    if (isCancelRequested())
+        ADDLE_THROW(CancelledException());
+}
+
+double AsyncTask::setMaxProgress(double maxProgress)
+{
+    {
+        const QMutexLocker lock(&_ioMutex);
+        if (_maxProgress == maxProgress) return maxProgress;
+        _maxProgress = maxProgress;
+    }
+
+    emit maxProgressChanged(maxProgress);
+    return maxProgress;
+}
+
+double AsyncTask::setMinProgress(double minProgress)
+{
+    {
+        const QMutexLocker lock(&_ioMutex);
+        if (_minProgress == minProgress) return minProgress;
+        _minProgress = minProgress;
     }
 
-    QThreadPool::globalInstance()->start(_worker);
-}
\ No newline at end of file
+    emit minProgressChanged(minProgress);
+    return minProgress;
+}
+
+double AsyncTask::setProgress(double progress)
+{
+    {
+        const QMutexLocker lock(&_ioMutex);
+        progress = qBound(_minProgress, progress, _maxProgress);
+        if (_progress == progress) return progress;
+        _progress = progress;
+
+        if (progress != _minProgress && progress != _maxProgress
+            && _progressTimer.isValid() && !_progressTimer.hasExpired(PROGRESS_INTERVAL))
+        {
+            _progressPending = true;
+            return progress;
+        }
+
+        _progressTimer.start();
+        _progressPending = false;
+    }
+
+    emit progressChanged(progress);
+    return progress;
+}
+
+void AsyncTask::flushProgress()
+{
+    double progress;
+    {
+        const QMutexLocker lock(&_ioMutex);
+        if (!_progressPending) return;
+
+        _progressPending = false;
+        progress = _progress;
+    }
+
+    emit progressChanged(progress);
+}
@@ -18,6 +18,11 @@
 #include <QObject>
 #include <QRunnable>
 #include <QMutex>
+#include <QWaitCondition>
+#include <QElapsedTimer>
+#include <QAtomicInt>
+
+#include "taskscheduler.hpp"
 namespace Addle {
 
 /**
@@ -42,18 +47,20 @@ namespace Addle {
  * In the future, we may want some kind of task pool that can aggregate the
  * progress of multiple parallel tasks for the benefit of the UI.
  * 
- * @todo
- * Tools like QFuture and AsyncFuture that may be useful in the future if
- * complex async logic like daisy-chaining or parallel computation are desired. 
+ * Tasks are run in a lane of TaskScheduler, by default the IO lane. Simpler
+ * work that needs neither progress nor cancellation can use
+ * TaskScheduler::run() and TaskScheduler::then() instead.
+ * 
+ * Cancellation is cooperative: `cancel()` only makes a request, and
+ * `doTask()` should call `checkCancelled()` (or pass `isCancelRequested` along
+ * to the operations it performs) at reasonable intervals. A task that stops
+ * because of a cancellation neither completes nor fails.
+ * 
+ * A task must not be deleted while it is running. To abandon a running task,
+ * cancel it and delete it once it has stopped.
  * 
  * @todo
- * The user is likely to want the ability to cancel tasks if they're very long-
- * running, and/or tasks should support a timeout. This will be a challenge to
- * generalize gracefully, but conservative mutex locking and frequent checking
- * against interrupt requests, could be a start. It may be possible to design
- * some low-level operations for safe thread termination, i.e., by leaning
- * heavily on the stack and atomics, or exposing post-termination cleanup
- * functions.
+ * Tasks should support a timeout.
  */
 class ADDLE_COMMON_EXPORT AsyncTask : public QObject
 {
@@ -80,9 +87,16 @@ public:
     double minProgress() const { const QMutexLocker lock(&_ioMutex); return _minProgress; }
     double progress() const { const QMutexLocker lock(&_ioMutex); return _progress; }
 
-    // The task has started and has not yet stopped.
+    // The task has started (or is queued to start) and has not yet stopped.
     bool isRunning() const { const QMutexLocker lock(&_stateMutex); return _isRunning; }
 
+    // Cancellation of the current run of the task has been requested. Safe to
+    // call from any thread.
+    bool isCancelRequested() const { return _cancelRequested.loadAcquire(); }
+
+    // The most recent run of the task stopped because it was cancelled.
+    bool wasCancelled() const { const QMutexLocker lock(&_stateMutex); return _wasCancelled; }
+
     /**
      * The most recent run of the task completed successfully (and stopped). If
      * the task has output data, it should be available now.
@@ -101,14 +115,27 @@ public:
      */
     QSharedPointer<AddleException> error() const { const QMutexLocker lock(&_stateMutex); return _error; }
 
-    void sync() { const QMutexLocker lock(&_stateMutex); while (_isRunning); }
+    // The lane of TaskScheduler the task is run in. Changes take effect the
+    // next time the task is started.
+    TaskScheduler::Lane lane() const { const QMutexLocker lock(&_stateMutex); return _lane; }
+    void setLane(TaskScheduler::Lane lane) { const QMutexLocker lock(&_stateMutex); _lane = lane; }
 
-    //todo trySync(int timeout = 0);
+    // Blocks until the task is not running. Must not be called from a direct
+    // connection to the task's own signals.
+    void sync();
+
+    // Like sync(), but gives up after `timeout` milliseconds. Returns true if
+    // the task is not running.
+    bool trySync(int timeout = 0);
 
 public slots:
     // Starts the task.
     void start();
 
+    // Requests that the task stop as soon as possible. Does nothing if the
+    // task is not running.
+    void cancel();
+
 signals: 
     // The task has started. 
     void started();
@@ -122,7 +149,12 @@ signals:
     // The task has stopped because of an error.
     void failed(QSharedPointer<AddleException>);
 
-    // todo: Rate-limit these signals like QFuture does
+    // The task has stopped because it was cancelled.
+    void cancelled();
+
+    // progressChanged is emitted at most once every PROGRESS_INTERVAL,
+    // except when progress reaches its minimum or maximum. The latest progress
+    // is always emitted before the task stops.
     void maxProgressChanged(double maxProgress);
     void minProgressChanged(double minProgress);
     void progressChanged(double progress);
@@ -134,6 +166,9 @@ protected:
     double setMinProgress(double minProgress);
     double setProgress(double progress);
 
+    // Throws CancelledException if cancellation has been requested.
+    void checkCancelled() const;
+
     inline std::unique_ptr<QMutexLocker> lockIO() const
     {
         return std::unique_ptr<QMutexLocker>(new QMutexLocker(&_ioMutex));
@@ -143,10 +178,20 @@ protected:
     // completed successfully.
     virtual void doTask() = 0;
 
+public:
+    static constexpr int PROGRESS_INTERVAL = 50; // ms
+
 private:
+    // Emits progressChanged if a change of progress was held back by the
+    // rate limit.
+    void flushProgress();
+
     bool _isRunning = false;
     bool _hasCompleted = false;
     bool _hasFailed = false;
+    bool _wasCancelled = false;
+
+    QAtomicInt _cancelRequested;
 
     QSharedPointer<AddleException> _error;
 
@@ -154,8 +199,14 @@ private:
     double _minProgress = 0.0;
     double _progress = 0.0;
 
+    QElapsedTimer _progressTimer;
+    bool _progressPending = false;
+
+    TaskScheduler::Lane _lane = TaskScheduler::IO;
+
     mutable QMutex _ioMutex;
     mutable QMutex _stateMutex;
+    QWaitCondition _stoppedCondition;
 
     Worker* _worker = nullptr;
     friend class Worker;
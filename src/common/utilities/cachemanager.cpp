@@ -0,0 +1,276 @@
+/**
+ * Addle source code
+ * @file
+ * @copyright Copyright 2020 Eleanor Hawk
+ * @copyright Modification and distribution permitted under the terms of the
+ * MIT License. See "LICENSE" for full details.
+ */
+
+#include "cachemanager.hpp"
+
+#include <algorithm>
+
+#include <QAtomicInteger>
+#include <QMutex>
+#include <QVector>
+
+#include "utilities/collections.hpp"
+#include "utilities/image/tilepool.hpp"
+
+using namespace Addle;
+
+struct CacheManager::Entry
+{
+    QString name;
+    Priority priority;
+    CostFunction cost;
+    EvictFunction evict;
+
+    QAtomicInteger<quint64> lastUsed;
+
+    // Guarded by the manager's lock.
+    qint64 evicted = 0;
+};
+
+namespace {
+
+struct ManagerState
+{
+    ManagerState()
+    {
+        bool ok;
+        const int budgetMiB = qEnvironmentVariableIntValue(CacheManager::BUDGET_ENV_VARIABLE_NAME, &ok);
+        if (ok && budgetMiB > 0)
+            budget = (qint64)budgetMiB * 1024 * 1024;
+    }
+
+    // Recursive, so that a cache may call into the manager from its evict
+    // function.
+    QMutex mutex { QMutex::Recursive };
+    QList<QSharedPointer<CacheManager::Entry>> entries;
+
+    qint64 budget = CacheManager::DEFAULT_BUDGET;
+    bool enforcing = false;
+
+    bool tilePoolRegistered = false;
+    CacheManager::Registration tilePool;
+};
+
+// The logical clock by which caches are ordered from least to most recently
+// used.
+QAtomicInteger<quint64> useClock;
+
+ManagerState& state()
+{
+    // Deliberately never deleted, so that caches can still unregister while
+    // static objects are destroyed.
+    static ManagerState* const state = new ManagerState;
+    return *state;
+}
+
+// Freed blocks held by the tile pool are the cheapest memory to give back,
+// so the pool is registered as a cache of its own.
+void registerTilePool(ManagerState& s)
+{
+    if (s.tilePoolRegistered) return;
+    s.tilePoolRegistered = true;
+
+    s.tilePool = CacheManager::add(
+        QStringLiteral("tile-pool"),
+        CacheManager::Low,
+        []() { return TilePool::stats().bytesPooled; },
+        [](qint64) {
+            const qint64 before = TilePool::stats().bytesPooled;
+            TilePool::trim();
+            return before - TilePool::stats().bytesPooled;
+        }
+    );
+}
+
+// Clears ManagerState::enforcing, even if an evict function throws.
+struct EnforcingGuard
+{
+    EnforcingGuard(ManagerState& s) : _s(s) { _s.enforcing = true; }
+    ~EnforcingGuard() { _s.enforcing = false; }
+
+    ManagerState& _s;
+};
+
+struct Candidate
+{
+    CacheManager::Entry* entry;
+    qint64 bytes;
+};
+
+// Lowest priority first, then least recently used.
+QVector<Candidate> candidates(ManagerState& s, qint64* total)
+{
+    QVector<Candidate> result;
+    result.reserve(s.entries.size());
+
+    *total = 0;
+    for (const auto& entry : s.entries)
+    {
+        const qint64 bytes = entry->cost();
+        result.append({ entry.data(), bytes });
+        *total += bytes;
+    }
+
+    std::stable_sort(result.begin(), result.end(),
+        [](const Candidate& a, const Candidate& b) {
+            if (a.entry->priority != b.entry->priority)
+                return a.entry->priority < b.entry->priority;
+            return a.entry->lastUsed.loadAcquire() < b.entry->lastUsed.loadAcquire();
+        }
+    );
+
+    return result;
+}
+
+qint64 evictFrom(CacheManager::Entry& entry, qint64 bytes)
+{
+    const qint64 freed = qMax(entry.evict(bytes), (qint64)0);
+    entry.evicted += freed;
+    return freed;
+}
+
+} // namespace
+
+CacheManager::Registration& CacheManager::Registration::operator=(Registration&& other)
+{
+    if (this != &other)
+    {
+        reset();
+        _entry = std::move(other._entry);
+    }
+    return *this;
+}
+
+void CacheManager::Registration::touch() const
+{
+    if (_entry)
+        _entry->lastUsed.storeRelease(useClock.fetchAndAddRelaxed(1) + 1);
+}
+
+void CacheManager::Registration::changed() const
+{
+    if (_entry)
+        CacheManager::enforce();
+}
+
+void CacheManager::Registration::reset()
+{
+    if (!_entry) return;
+
+    // Waits for any eviction in progress, after which the cache's functions
+    // are not called again.
+    ManagerState& s = state();
+    const QMutexLocker lock(&s.mutex);
+    s.entries.removeOne(_entry);
+    _entry.clear();
+}
+
+CacheManager::Registration CacheManager::add(
+        const QString& name,
+        Priority priority,
+        CostFunction cost,
+        EvictFunction evict
+    )
+{
+    QSharedPointer<Entry> entry(new Entry);
+    entry->name = name;
+    entry->priority = priority;
+    entry->cost = cost;
+    entry->evict = evict;
+    entry->lastUsed.storeRelease(useClock.fetchAndAddRelaxed(1) + 1);
+
+    ManagerState& s = state();
+    const QMutexLocker lock(&s.mutex);
+    s.entries.append(entry);
+    registerTilePool(s);
+
+    return Registration(entry);
+}
+
+qint64 CacheManager::budget()
+{
+    ManagerState& s = state();
+    const QMutexLocker lock(&s.mutex);
+    return s.budget;
+}
+
+void CacheManager::setBudget(qint64 bytes)
+{
+    {
+        ManagerState& s = state();
+        const QMutexLocker lock(&s.mutex);
+        s.budget = qMax(bytes, (qint64)0);
+    }
+    enforce();
+}
+
+QList<CacheManager::Usage> CacheManager::usage()
+{
+    ManagerState& s = state();
+    const QMutexLocker lock(&s.mutex);
+
+    QList<Usage> result;
+    for (const auto& entry : noDetach(s.entries))
+        result.append({ entry->name, entry->priority, entry->cost(), entry->evicted });
+
+    return result;
+}
+
+qint64 CacheManager::totalBytes()
+{
+    ManagerState& s = state();
+    const QMutexLocker lock(&s.mutex);
+
+    qint64 total = 0;
+    for (const auto& entry : noDetach(s.entries))
+        total += entry->cost();
+
+    return total;
+}
+
+void CacheManager::enforce()
+{
+    ManagerState& s = state();
+    const QMutexLocker lock(&s.mutex);
+
+    // A cache that reports a change from its evict function is already
+    // being dealt with.
+    if (s.enforcing) return;
+    const EnforcingGuard guard(s);
+
+    qint64 total;
+    const QVector<Candidate> order = candidates(s, &total);
+
+    for (const Candidate& candidate : order)
+    {
+        if (total <= s.budget) break;
+        if (candidate.bytes <= 0) continue;
+
+        total -= evictFrom(*candidate.entry, qMin(total - s.budget, candidate.bytes));
+    }
+}
+
+void CacheManager::releaseMemory()
+{
+    ManagerState& s = state();
+    const QMutexLocker lock(&s.mutex);
+
+    if (s.enforcing) return;
+    const EnforcingGuard guard(s);
+
+    qint64 total;
+    const QVector<Candidate> order = candidates(s, &total);
+
+    for (const Candidate& candidate : order)
+    {
+        if (candidate.bytes > 0)
+            evictFrom(*candidate.entry, candidate.bytes);
+    }
+
+    TilePool::trim();
+}
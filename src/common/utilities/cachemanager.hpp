@@ -0,0 +1,132 @@
+/**
+ * Addle source code
+ * @file
+ * @copyright Copyright 2020 Eleanor Hawk
+ * @copyright Modification and distribution permitted under the terms of the
+ * MIT License. See "LICENSE" for full details.
+ */
+
+#ifndef CACHEMANAGER_HPP
+#define CACHEMANAGER_HPP
+
+#include "compat.hpp"
+
+#include <functional>
+
+#include <QList>
+#include <QSharedPointer>
+#include <QString>
+
+namespace Addle {
+
+/**
+ * Keeps the memory held by Addle's caches, together, within one budget.
+ *
+ * A cache registers a function that reports how many bytes it holds, and one
+ * that frees at least a given number of bytes where it can. When the caches
+ * together exceed the budget, the manager asks them to free memory, starting
+ * with the lowest priority and least recently used, until they fit again.
+ *
+ * The budget is DEFAULT_BUDGET unless set in MiB by the environment variable
+ * ADDLE_CACHE_BUDGET, or by setBudget().
+ *
+ * The cost and evict functions may be called from any thread, while the
+ * manager holds its lock, and until the registration is destroyed. A cache
+ * must not call into the manager while holding a lock that either function
+ * takes.
+ */
+class ADDLE_COMMON_EXPORT CacheManager
+{
+public:
+    // A registered cache. Defined in cachemanager.cpp.
+    struct Entry;
+
+    enum Priority
+    {
+        // Speculative data, e.g., prefetched images.
+        Low,
+        // Data that is expensive, but possible, to make again.
+        Normal,
+        High
+    };
+
+    // Returns the number of bytes the cache holds.
+    typedef std::function<qint64()> CostFunction;
+
+    // Frees at least the given number of bytes if it can, returning the
+    // number of bytes actually freed.
+    typedef std::function<qint64(qint64)> EvictFunction;
+
+    struct Usage
+    {
+        QString name;
+        Priority priority;
+        qint64 bytes;
+
+        // The total number of bytes the cache has been asked to free, and
+        // has freed.
+        qint64 evicted;
+    };
+
+    // Registers a cache with the manager until it is destroyed. Should be
+    // the last member of the cache it registers, so that it is destroyed
+    // first.
+    class ADDLE_COMMON_EXPORT Registration
+    {
+    public:
+        Registration() = default;
+        Registration(Registration&& other) : _entry(std::move(other._entry)) {}
+        Registration& operator=(Registration&& other);
+        ~Registration() { reset(); }
+
+        Registration(const Registration&) = delete;
+        Registration& operator=(const Registration&) = delete;
+
+        inline bool isNull() const { return !_entry; }
+
+        // Marks the cache as recently used. Does not lock.
+        void touch() const;
+
+        // Tells the manager that the cache has grown, so that the budget is
+        // enforced.
+        void changed() const;
+
+        void reset();
+
+    private:
+        explicit Registration(QSharedPointer<Entry> entry) : _entry(entry) {}
+
+        QSharedPointer<Entry> _entry;
+
+        friend class CacheManager;
+    };
+
+    CacheManager() = delete;
+
+    static Registration add(
+        const QString& name,
+        Priority priority,
+        CostFunction cost,
+        EvictFunction evict
+    );
+
+    static qint64 budget();
+    static void setBudget(qint64 bytes);
+
+    static QList<Usage> usage();
+    static qint64 totalBytes();
+
+    // Evicts from the caches until they fit in the budget.
+    static void enforce();
+
+    // Evicts everything that can be evicted, e.g., in response to a warning
+    // of low memory.
+    static void releaseMemory();
+
+    static constexpr qint64 DEFAULT_BUDGET = 512 * 1024 * 1024;
+    static constexpr const char* BUDGET_ENV_VARIABLE_NAME = "ADDLE_CACHE_BUDGET";
+};
+
+} // namespace Addle
+
+#endif // CACHEMANAGER_HPP
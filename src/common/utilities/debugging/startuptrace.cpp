@@ -0,0 +1,190 @@
+/**
+ * Addle source code
+ * @file
+ * @copyright Copyright 2020 Eleanor Hawk
+ * @copyright Modification and distribution permitted under the terms of the
+ * MIT License. See "LICENSE" for full details.
+ */
+
+#include "startuptrace.hpp"
+
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QThread>
+
+using namespace Addle;
+
+QAtomicInt StartupTrace::_enabled = QAtomicInt(0);
+
+namespace {
+
+struct TraceEvent
+{
+    const char* name;
+    qint64 start;
+    qint64 duration;
+    bool instant;
+    int thread;
+};
+
+struct TraceState
+{
+    QMutex mutex;
+    QElapsedTimer timer;
+    QString filename;
+    std::vector<TraceEvent> events;
+
+    // Threads are numbered in the order they are first seen, with the main
+    // thread first.
+    QHash<Qt::HANDLE, int> threads;
+};
+
+TraceState& state()
+{
+    static TraceState instance;
+    return instance;
+}
+
+} // namespace
+
+StartupTrace::Scope::Scope(const char* name, bool finishes)
+    : _name(name), _start(isEnabled() ? now() : 0), _finishes(finishes)
+{
+}
+
+StartupTrace::Scope::~Scope()
+{
+    if (!isEnabled())
+        return;
+
+    record(_name, _start, now() - _start, false);
+    if (_finishes)
+        finish();
+}
+
+void StartupTrace::enableFromArguments(int argc, char* argv[])
+{
+    const QByteArray option = QByteArray("--") + COMMAND_LINE_OPTION;
+
+    QString filename;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (option == argv[i] && i + 1 < argc)
+        {
+            filename = QString::fromLocal8Bit(argv[i + 1]);
+            break;
+        }
+        else if (std::strncmp(argv[i], option.constData(), option.size()) == 0
+            && argv[i][option.size()] == '=')
+        {
+            filename = QString::fromLocal8Bit(argv[i] + option.size() + 1);
+            break;
+        }
+    }
+
+    if (filename.isEmpty())
+        return;
+
+    TraceState& s = state();
+    {
+        const QMutexLocker lock(&s.mutex);
+        s.filename = filename;
+        s.events.reserve(64);
+        s.timer.start();
+    }
+    _enabled.storeRelease(1);
+}
+
+void StartupTrace::mark(const char* name)
+{
+    if (isEnabled())
+        record(name, now(), 0, true);
+}
+
+void StartupTrace::finish()
+{
+    if (!isEnabled())
+        return;
+
+    mark("startup-finished");
+
+    TraceState& s = state();
+    const QMutexLocker lock(&s.mutex);
+
+    // Only the first call writes the trace.
+    if (!_enabled.testAndSetOrdered(1, 0))
+        return;
+
+    QJsonArray events;
+    for (const TraceEvent& event : s.events)
+    {
+        QJsonObject object {
+            { "name", QString::fromUtf8(event.name) },
+            { "cat", "startup" },
+            { "ph", event.instant ? "i" : "X" },
+            { "ts", (double)event.start },
+            { "pid", (double)QCoreApplication::applicationPid() },
+            { "tid", event.thread }
+        };
+
+        if (event.instant)
+            object.insert("s", "g");
+        else
+            object.insert("dur", (double)event.duration);
+
+        events.append(object);
+    }
+
+    const QJsonObject trace {
+        { "traceEvents", events },
+        { "displayTimeUnit", "ms" }
+    };
+
+    QFile file(s.filename);
+    if (file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        file.write(QJsonDocument(trace).toJson(QJsonDocument::Compact));
+    }
+    else
+    {
+        std::cerr << qPrintable(
+            //% "Could not write the startup trace to \"%1\"."
+            qtTrId("cli-messages.trace-startup.write-error").arg(s.filename)
+        ) << std::endl;
+    }
+
+    s.events.clear();
+}
+
+void StartupTrace::record(const char* name, qint64 start, qint64 duration, bool instant)
+{
+    TraceState& s = state();
+    const QMutexLocker lock(&s.mutex);
+
+    // Checked again, in case the trace was finished in the meantime.
+    if (!isEnabled())
+        return;
+
+    const Qt::HANDLE threadId = QThread::currentThreadId();
+    auto i = s.threads.find(threadId);
+    if (i == s.threads.end())
+        i = s.threads.insert(threadId, s.threads.size() + 1);
+
+    s.events.push_back({ name, start, duration, instant, *i });
+}
+
+qint64 StartupTrace::now()
+{
+    // Microseconds, as Chrome traces expect.
+    return state().timer.nsecsElapsed() / 1000;
+}
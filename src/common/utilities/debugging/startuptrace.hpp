@@ -0,0 +1,84 @@
+/**
+ * Addle source code
+ * @file
+ * @copyright Copyright 2020 Eleanor Hawk
+ * @copyright Modification and distribution permitted under the terms of the
+ * MIT License. See "LICENSE" for full details.
+ */
+
+#ifndef STARTUPTRACE_HPP
+#define STARTUPTRACE_HPP
+
+#include "compat.hpp"
+
+#include <QAtomicInt>
+#include <QString>
+
+namespace Addle {
+
+/**
+ * Records a timeline of Addle's startup, from `main()` to the first paint of
+ * the canvas, and writes it as a Chrome trace JSON file (viewable with
+ * chrome://tracing or Perfetto).
+ *
+ * Tracing is enabled by the `--trace-startup <file>` command line option. When
+ * it is not enabled, recording costs a single atomic load.
+ */
+class ADDLE_COMMON_EXPORT StartupTrace
+{
+public:
+    static constexpr const char* COMMAND_LINE_OPTION = "trace-startup";
+
+    // Records a span from its construction to its destruction. If `finishes`
+    // is true, the trace is finished once the span ends.
+    class Scope
+    {
+    public:
+        Scope(const char* name, bool finishes = false);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        const char* const _name;
+        const qint64 _start;
+        const bool _finishes;
+    };
+
+    // Looks for the command line option and, if it is given, begins tracing
+    // at once. Called first thing in `main()`, before the command line is
+    // otherwise parsed.
+    static void enableFromArguments(int argc, char* argv[]);
+
+    inline static bool isEnabled() { return _enabled.loadAcquire(); }
+
+    // Records a point in time.
+    static void mark(const char* name);
+
+    // Records the end of startup and writes the trace. Nothing is recorded
+    // afterward.
+    static void finish();
+
+private:
+    static void record(const char* name, qint64 start, qint64 duration, bool instant);
+    static qint64 now();
+
+    static QAtomicInt _enabled;
+};
+
+} // namespace Addle
+
+#define ADDLE_TRACE_STARTUP_CONCAT_(a, b) a##b
+#define ADDLE_TRACE_STARTUP_CONCAT(a, b) ADDLE_TRACE_STARTUP_CONCAT_(a, b)
+
+// Records the startup time spent in the enclosing scope under `name`.
+#define ADDLE_TRACE_STARTUP(name) \
+    const ::Addle::StartupTrace::Scope ADDLE_TRACE_STARTUP_CONCAT(_startupTraceScope_, __LINE__)(name)
+
+// As ADDLE_TRACE_STARTUP, and startup is considered finished at the end of the
+// enclosing scope.
+#define ADDLE_TRACE_STARTUP_END(name) \
+    const ::Addle::StartupTrace::Scope ADDLE_TRACE_STARTUP_CONCAT(_startupTraceScope_, __LINE__)(name, true)
+
+#endif // STARTUPTRACE_HPP
@@ -19,7 +19,10 @@ BrushStroke::BrushStroke(BrushId id,
         QColor color,
         double size,
         QSharedPointer<IRasterSurface> buffer)
-    : _id(id), _brush(ServiceLocator::get<IBrush>(id)), _buffer(buffer)
+    : _id(id),
+    _brush(ServiceLocator::get<IBrush>(id)),
+    _engine(ServiceLocator::resolve<IBrushEngine>(_brush.engineId())),
+    _buffer(buffer)
 {
     _painterStates.push(PainterState(color, size));
 }
@@ -155,5 +158,5 @@ QVariantHash& BrushStroke::engineState()
 
 void BrushStroke::paint()
 {
-    ServiceLocator::get<IBrushEngine>(_brush.engineId()).paint(*this);
+    _engine->paint(*this);
 }
\ No newline at end of file
@@ -12,6 +12,7 @@
 #include "compat.hpp"
 
 #include "interfaces/models/ibrush.hpp"
+#include "servicelocator.hpp"
 
 #include <QObject>
 
@@ -23,6 +24,7 @@
 namespace Addle {
 
 class IRasterSurface;
+class IBrushEngine;
 class ADDLE_COMMON_EXPORT BrushStroke : public QObject
 {
     Q_OBJECT
@@ -84,6 +86,7 @@ public:
 private:
     BrushId _id;
     IBrush& _brush;
+    ServiceLocator::Handle<IBrushEngine> _engine;
     QSharedPointer<IRasterSurface> _buffer;
 
     struct PainterState
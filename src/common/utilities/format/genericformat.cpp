@@ -59,4 +59,64 @@ struct visitor_supportsImport
 bool GenericFormatDriver::supportsImport() const
 {
     return boost::apply_visitor(visitor_supportsImport(), _value);
-}
\ No newline at end of file
+}
+
+struct visitor_supportsExport
+{
+    typedef bool result_type;
+
+    template<typename ModelType>
+    bool operator()(IFormatDriver<ModelType>* driver) const
+    {
+        return driver->supportsExport();
+    }
+};
+
+bool GenericFormatDriver::supportsExport() const
+{
+    return boost::apply_visitor(visitor_supportsExport(), _value);
+}
+
+struct visitor_opensFiles
+{
+    typedef bool result_type;
+
+    template<typename ModelType>
+    bool operator()(IFormatDriver<ModelType>* driver) const
+    {
+        return driver->opensFiles();
+    }
+};
+
+bool GenericFormatDriver::opensFiles() const
+{
+    return boost::apply_visitor(visitor_opensFiles(), _value);
+}
+
+struct visitor_exportModel
+{
+    typedef void result_type;
+
+    visitor_exportModel(const GenericFormatModel& genericModel_, QIODevice& device_, const GenericImportExportInfo& genericInfo_)
+        : genericModel(genericModel_), device(device_), genericInfo(genericInfo_)
+    {
+    }
+
+    template<typename ModelType>
+    void operator()(IFormatDriver<ModelType>* driver)
+    {
+        auto model = boost::get<ModelType*>(genericModel.variant());
+        auto info = genericInfo.get<ModelType>();
+        driver->exportModel(model, device, info);
+    }
+
+    const GenericFormatModel& genericModel;
+    QIODevice& device;
+    const GenericImportExportInfo& genericInfo;
+};
+
+void GenericFormatDriver::exportModel(GenericFormatModel model, QIODevice& device, GenericImportExportInfo info)
+{
+    visitor_exportModel visitor(model, device, info);
+    boost::apply_visitor(visitor, _value);
+}
@@ -236,6 +236,7 @@ public:
 
     bool supportsImport() const;
     bool supportsExport() const;
+    bool opensFiles() const;
 
     GenericFormatModel importModel(QIODevice& device, GenericImportExportInfo info);
     void exportModel(GenericFormatModel model, QIODevice& device, GenericImportExportInfo info);
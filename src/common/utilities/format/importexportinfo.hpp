@@ -11,17 +11,22 @@
 
 #include "compat.hpp"
 #include <typeinfo>
+#include <functional>
 
 #include "idtypes/formatid.hpp"
+#include "exceptions/cancelledexception.hpp"
 
 #include <QSharedData>
 #include <QSharedDataPointer>
+#include <QSharedPointer>
 
 #include <QString>
 #include <QUrl>
 #include <QFileInfo>
 namespace Addle {
 
+class DocumentSnapshot;
+
 enum ImportExportDirection
 {
     unassigned,
@@ -55,6 +60,39 @@ public:
     QUrl url() const { return _data->url; }
     void setUrl(const QUrl& url) { _data->url = url; }
 
+    // Optional. Format drivers may call this with values from 0.0 to 1.0 to
+    // report the progress of a lengthy import or export.
+    std::function<void(double)> progressCallback() const { return _data->progressCallback; }
+    void setProgressCallback(std::function<void(double)> callback) { _data->progressCallback = callback; }
+
+    inline void reportProgress(double progress) const
+    {
+        if (_data->progressCallback) _data->progressCallback(progress);
+    }
+
+    // Optional. If set, format drivers call `checkCancelled()` periodically
+    // during a lengthy import or export, which throws CancelledException once
+    // the cancellation check returns true. The check must be safe to call
+    // from any thread.
+    std::function<bool()> cancellationCheck() const { return _data->cancellationCheck; }
+    void setCancellationCheck(std::function<bool()> check) { _data->cancellationCheck = check; }
+
+    inline bool isCancelled() const
+    {
+        return _data->cancellationCheck && _data->cancellationCheck();
+    }
+
+    inline void checkCancelled() const
+    {
+        if (isCancelled()) ADDLE_THROW(CancelledException());
+    }
+
+    // Optional, for exporting documents. A snapshot of the document taken in
+    // advance on the thread that owns it, which drivers export in place of
+    // the document itself.
+    QSharedPointer<const DocumentSnapshot> snapshot() const { return _data->snapshot; }
+    void setSnapshot(QSharedPointer<const DocumentSnapshot> snapshot) { _data->snapshot = snapshot; }
+
 private:
     struct Data : QSharedData
     {
@@ -62,7 +100,9 @@ private:
         FormatId<ModelType> format;
         QUrl url;
         QFileInfo fileInfo;
-        
+        std::function<void(double)> progressCallback;
+        std::function<bool()> cancellationCheck;
+        QSharedPointer<const DocumentSnapshot> snapshot;
     };
     QSharedDataPointer<Data> _data;
 };
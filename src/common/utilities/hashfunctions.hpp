@@ -10,6 +10,8 @@
 #define HASHFUNCTIONS_HPP
 
 #include <QHash>
+#include <QPair>
+#include <QPoint>
 
 #include <typeindex>
 
@@ -24,4 +26,11 @@ namespace std
 	}
 }
 
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+inline uint qHash(const QPoint& key, uint seed = 0)
+{
+	return qHash(qMakePair(key.x(), key.y()), seed);
+}
+#endif
+
 #endif // HASHFUNCTIONS_HPP
\ No newline at end of file
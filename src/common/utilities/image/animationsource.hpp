@@ -0,0 +1,49 @@
+/**
+ * Addle source code
+ * @file
+ * @copyright Copyright 2020 Eleanor Hawk
+ * @copyright Modification and distribution permitted under the terms of the
+ * MIT License. See "LICENSE" for full details.
+ */
+
+#ifndef ANIMATIONSOURCE_HPP
+#define ANIMATIONSOURCE_HPP
+
+#include "compat.hpp"
+#include <QImage>
+#include <QSize>
+
+namespace Addle {
+
+/**
+ * A source of the frames of an animated image, e.g., a GIF, decoded one at a
+ * time in order.
+ *
+ * A document with an animation source has the first frame as its layer. The
+ * source is only used to play the animation, by a viewer.
+ *
+ * An animation source is not thread-safe, and should be used by one thread
+ * at a time.
+ */
+class AnimationSource
+{
+public:
+    virtual ~AnimationSource() = default;
+
+    virtual QSize size() const = 0;
+
+    // The number of times the animation is repeated after it is first
+    // played, or -1 if it is repeated indefinitely.
+    virtual int loopCount() const = 0;
+
+    // Returns to the first frame.
+    virtual void rewind() = 0;
+
+    // Decodes the next frame in full, in QImage::Format_ARGB32, and the time
+    // in ms to show it. Returns a null image after the last frame.
+    virtual QImage nextFrame(int& delay) = 0;
+};
+
+} // namespace Addle
+
+#endif // ANIMATIONSOURCE_HPP
@@ -0,0 +1,269 @@
+/**
+ * Addle source code
+ * @file
+ * @copyright Copyright 2020 Eleanor Hawk
+ * @copyright Modification and distribution permitted under the terms of the
+ * MIT License. See "LICENSE" for full details.
+ */
+
+#include "pixelkernels.hpp"
+
+#include <QByteArray>
+#include <QtDebug>
+
+#if defined(Q_PROCESSOR_X86)
+#include <immintrin.h>
+#ifdef Q_CC_MSVC
+#include <intrin.h>
+#endif
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+using namespace Addle;
+
+// GCC and Clang only emit vector instructions beyond the build's baseline in
+// functions marked for them. MSVC emits any intrinsic without marking.
+#if defined(Q_PROCESSOR_X86) && defined(Q_CC_GNU)
+#define ADDLE_KERNEL_TARGET(isa) __attribute__((target(isa)))
+#define ADDLE_X86_KERNELS
+#elif defined(Q_PROCESSOR_X86) && defined(Q_CC_MSVC)
+#define ADDLE_KERNEL_TARGET(isa)
+#define ADDLE_X86_KERNELS
+#endif
+
+namespace {
+
+void xorBytes_scalar(uchar* dest, const uchar* src, int length)
+{
+    for (int i = 0; i < length; ++i)
+        dest[i] ^= src[i];
+}
+
+const PixelKernels::Table scalarTable = {
+    PixelKernels::Scalar,
+    &xorBytes_scalar
+};
+
+#ifdef ADDLE_X86_KERNELS
+
+ADDLE_KERNEL_TARGET("sse2")
+void xorBytes_sse2(uchar* dest, const uchar* src, int length)
+{
+    int i = 0;
+    for (; i + 16 <= length; i += 16)
+    {
+        const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dest + i));
+        const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), _mm_xor_si128(d, s));
+    }
+    xorBytes_scalar(dest + i, src + i, length - i);
+}
+
+ADDLE_KERNEL_TARGET("avx2")
+void xorBytes_avx2(uchar* dest, const uchar* src, int length)
+{
+    int i = 0;
+    for (; i + 32 <= length; i += 32)
+    {
+        const __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dest + i));
+        const __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + i), _mm256_xor_si256(d, s));
+    }
+    xorBytes_sse2(dest + i, src + i, length - i);
+}
+
+ADDLE_KERNEL_TARGET("avx512f")
+void xorBytes_avx512(uchar* dest, const uchar* src, int length)
+{
+    int i = 0;
+    for (; i + 64 <= length; i += 64)
+    {
+        const __m512i d = _mm512_loadu_si512(dest + i);
+        const __m512i s = _mm512_loadu_si512(src + i);
+        _mm512_storeu_si512(dest + i, _mm512_xor_si512(d, s));
+    }
+    xorBytes_avx2(dest + i, src + i, length - i);
+}
+
+const PixelKernels::Table sse2Table = {
+    PixelKernels::SSE2,
+    &xorBytes_sse2
+};
+
+const PixelKernels::Table avx2Table = {
+    PixelKernels::AVX2,
+    &xorBytes_avx2
+};
+
+const PixelKernels::Table avx512Table = {
+    PixelKernels::AVX512,
+    &xorBytes_avx512
+};
+
+#endif // ADDLE_X86_KERNELS
+
+#ifdef __ARM_NEON
+
+void xorBytes_neon(uchar* dest, const uchar* src, int length)
+{
+    int i = 0;
+    for (; i + 16 <= length; i += 16)
+        vst1q_u8(dest + i, veorq_u8(vld1q_u8(dest + i), vld1q_u8(src + i)));
+    xorBytes_scalar(dest + i, src + i, length - i);
+}
+
+const PixelKernels::Table neonTable = {
+    PixelKernels::NEON,
+    &xorBytes_neon
+};
+
+#endif // __ARM_NEON
+
+bool isSupported(PixelKernels::InstructionSet instructionSet)
+{
+    switch (instructionSet)
+    {
+    case PixelKernels::Scalar:
+        return true;
+
+#if defined(ADDLE_X86_KERNELS) && defined(Q_CC_GNU)
+    case PixelKernels::SSE2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("sse2");
+    case PixelKernels::AVX2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+    case PixelKernels::AVX512:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx512f");
+
+#elif defined(ADDLE_X86_KERNELS) && defined(Q_CC_MSVC)
+    case PixelKernels::SSE2:
+    case PixelKernels::AVX2:
+    case PixelKernels::AVX512:
+    {
+        int info[4];
+        __cpuid(info, 0);
+        const int maxLeaf = info[0];
+
+        __cpuid(info, 1);
+        const bool sse2 = info[3] & (1 << 26);
+        const bool osxsave = info[2] & (1 << 27);
+        const bool avx = info[2] & (1 << 28);
+
+        if (instructionSet == PixelKernels::SSE2)
+            return sse2;
+        if (!osxsave || !avx || maxLeaf < 7)
+            return false;
+
+        // The OS must also save the vector registers on context switches.
+        const unsigned long long xcr0 = _xgetbv(0);
+
+        __cpuidex(info, 7, 0);
+        if (instructionSet == PixelKernels::AVX2)
+            return (info[1] & (1 << 5)) && (xcr0 & 0x06) == 0x06;
+        else
+            return (info[1] & (1 << 16)) && (xcr0 & 0xE6) == 0xE6;
+    }
+#endif
+
+#ifdef __ARM_NEON
+    case PixelKernels::NEON:
+        return true;
+#endif
+
+    default:
+        return false;
+    }
+}
+
+const PixelKernels::Table& chooseTable()
+{
+    const PixelKernels::InstructionSet preferred[] = {
+        PixelKernels::AVX512,
+        PixelKernels::AVX2,
+        PixelKernels::SSE2,
+        PixelKernels::NEON
+    };
+
+    if (qEnvironmentVariableIsSet(PixelKernels::ENV_VARIABLE_NAME))
+    {
+        const QByteArray requested = qgetenv(PixelKernels::ENV_VARIABLE_NAME).toLower();
+
+        for (int i = PixelKernels::Scalar; i <= PixelKernels::NEON; ++i)
+        {
+            const auto instructionSet = (PixelKernels::InstructionSet)i;
+            if (requested != QByteArray(PixelKernels::name(instructionSet)).toLower())
+                continue;
+
+            if (const PixelKernels::Table* table = PixelKernels::table(instructionSet))
+                return *table;
+        }
+
+        //% "The pixel kernels \"%1\" were requested, but are not supported. The best supported kernels will be used instead."
+        qWarning() << qUtf8Printable(qtTrId("debug-messages.pixel-kernels.unsupported-override")
+            .arg(QString::fromLatin1(requested)));
+    }
+
+    for (PixelKernels::InstructionSet instructionSet : preferred)
+    {
+        if (const PixelKernels::Table* table = PixelKernels::table(instructionSet))
+            return *table;
+    }
+
+    return scalarTable;
+}
+
+} // namespace
+
+const PixelKernels::Table& PixelKernels::get()
+{
+    static const Table& table = chooseTable();
+    return table;
+}
+
+const PixelKernels::Table* PixelKernels::table(InstructionSet instructionSet)
+{
+    if (!isSupported(instructionSet))
+        return nullptr;
+
+    switch (instructionSet)
+    {
+    case Scalar:
+        return &scalarTable;
+#ifdef ADDLE_X86_KERNELS
+    case SSE2:
+        return &sse2Table;
+    case AVX2:
+        return &avx2Table;
+    case AVX512:
+        return &avx512Table;
+#endif
+#ifdef __ARM_NEON
+    case NEON:
+        return &neonTable;
+#endif
+    default:
+        return nullptr;
+    }
+}
+
+const char* PixelKernels::name(InstructionSet instructionSet)
+{
+    switch (instructionSet)
+    {
+    case Scalar:
+        return "Scalar";
+    case SSE2:
+        return "SSE2";
+    case AVX2:
+        return "AVX2";
+    case AVX512:
+        return "AVX512";
+    case NEON:
+        return "NEON";
+    default:
+        return "";
+    }
+}
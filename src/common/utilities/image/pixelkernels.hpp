@@ -0,0 +1,67 @@
+/**
+ * Addle source code
+ * @file
+ * @copyright Copyright 2020 Eleanor Hawk
+ * @copyright Modification and distribution permitted under the terms of the
+ * MIT License. See "LICENSE" for full details.
+ */
+
+#ifndef PIXELKERNELS_HPP
+#define PIXELKERNELS_HPP
+
+#include "compat.hpp"
+
+#include <QtGlobal>
+
+namespace Addle {
+
+/**
+ * Tables of pixel kernels, with one table per instruction set that the
+ * kernels are written for, so that a single build can use the widest vector
+ * instructions the CPU supports.
+ *
+ * The table for the CPU is chosen once, the first time get() is called. It
+ * can be forced for testing by setting the environment variable
+ * ADDLE_PIXEL_KERNELS to the name of an instruction set, e.g., "scalar" or
+ * "sse2". The scalar table is always available and is the reference that the
+ * others must agree with.
+ */
+class ADDLE_COMMON_EXPORT PixelKernels
+{
+public:
+    enum InstructionSet
+    {
+        Scalar,
+        SSE2,
+        AVX2,
+        AVX512,
+        NEON
+    };
+
+    // XORs `length` bytes of `src` into `dest`.
+    typedef void (*XorBytes)(uchar* dest, const uchar* src, int length);
+
+    struct Table
+    {
+        InstructionSet instructionSet;
+
+        XorBytes xorBytes;
+    };
+
+    // The table chosen for this CPU.
+    static const Table& get();
+
+    // The table for `instructionSet`, or null if it is not built for this
+    // platform or not supported by this CPU.
+    static const Table* table(InstructionSet instructionSet);
+
+    static const char* name(InstructionSet instructionSet);
+
+    static constexpr const char* ENV_VARIABLE_NAME = "ADDLE_PIXEL_KERNELS";
+
+    PixelKernels() = delete;
+};
+
+} // namespace Addle
+
+#endif // PIXELKERNELS_HPP
@@ -0,0 +1,62 @@
+/**
+ * Addle source code
+ * @file
+ * @copyright Copyright 2020 Eleanor Hawk
+ * @copyright Modification and distribution permitted under the terms of the
+ * MIT License. See "LICENSE" for full details.
+ */
+
+#ifndef RASTERTILESOURCE_HPP
+#define RASTERTILESOURCE_HPP
+
+#include "compat.hpp"
+#include <QRect>
+#include <QImage>
+#include <QList>
+#include <QPoint>
+
+namespace Addle {
+
+/**
+ * A source of raster data that is divided into square tiles that can be
+ * decoded individually, e.g., from a file.
+ *
+ * A raster surface initialized from a tile source decodes tiles from it only
+ * as they are needed. Tiles are addressed by index on a grid of `tileSize()`
+ * squares anchored at the surface's origin, so tile (i, j) covers the area
+ * `QRect(i * tileSize(), j * tileSize(), tileSize(), tileSize())`.
+ */
+class RasterTileSource
+{
+public:
+    virtual ~RasterTileSource() = default;
+
+    virtual int tileSize() const = 0;
+
+    // The area of the surface described by the source. Any tile within this
+    // area that is not listed by `tiles()` is transparent.
+    virtual QRect area() const = 0;
+
+    virtual QList<QPoint> tiles() const = 0;
+
+    // Decodes the given tile, returning a `tileSize()` square image in
+    // QImage::Format_ARGB32, or a null image if the tile is transparent.
+    // Throws FormatException if the tile can't be decoded. Must be safe to
+    // call from any thread.
+    virtual QImage decodeTile(QPoint index) const = 0;
+
+    // Optionally decodes the whole area at reduced resolution, fitting within
+    // `size`, in QImage::Format_ARGB32. Sources for which this is not
+    // substantially cheaper than decoding every tile return a null image.
+    // Must be safe to call from any thread.
+    virtual QImage preview(QSize size) const { Q_UNUSED(size); return QImage(); }
+
+    inline QRect tileRect(QPoint index) const
+    {
+        return QRect(index * tileSize(), QSize(tileSize(), tileSize()));
+    }
+};
+
+} // namespace Addle
+
+#endif // RASTERTILESOURCE_HPP
@@ -0,0 +1,346 @@
+/**
+ * Addle source code
+ * @file
+ * @copyright Copyright 2020 Eleanor Hawk
+ * @copyright Modification and distribution permitted under the terms of the
+ * MIT License. See "LICENSE" for full details.
+ */
+
+#include "tilepool.hpp"
+
+#include <new>
+
+#include <QAtomicInteger>
+#include <QMutex>
+#include <QPixelFormat>
+
+using namespace Addle;
+
+namespace {
+
+// Every block is preceded by a header, padded to ALIGNMENT so that the data
+// after it stays aligned.
+struct BlockHeader
+{
+    BlockHeader* next;
+    std::size_t size;
+    int sizeClass; // -1 if the block is not pooled
+};
+
+static_assert(sizeof(BlockHeader) <= TilePool::ALIGNMENT, "BlockHeader does not fit in its padding");
+
+inline uchar* dataOf(BlockHeader* header)
+{
+    return reinterpret_cast<uchar*>(header) + TilePool::ALIGNMENT;
+}
+
+inline BlockHeader* headerOf(uchar* data)
+{
+    return reinterpret_cast<BlockHeader*>(data - TilePool::ALIGNMENT);
+}
+
+inline std::size_t classSize(int sizeClass)
+{
+    return TilePool::MIN_BLOCK_SIZE << sizeClass;
+}
+
+int sizeClassOf(std::size_t size)
+{
+    for (int sizeClass = 0; sizeClass < TilePool::SIZE_CLASSES; ++sizeClass)
+    {
+        if (size <= classSize(sizeClass))
+            return sizeClass;
+    }
+    return -1;
+}
+
+void freeBlock(BlockHeader* header)
+{
+    header->~BlockHeader();
+    qFreeAligned(header);
+}
+
+// An intrusive list of free blocks of one size class.
+struct FreeList
+{
+    BlockHeader* head = nullptr;
+
+    void push(BlockHeader* header)
+    {
+        header->next = head;
+        head = header;
+    }
+
+    BlockHeader* pop()
+    {
+        BlockHeader* header = head;
+        if (header)
+            head = header->next;
+        return header;
+    }
+};
+
+struct FreeLists
+{
+    FreeList lists[TilePool::SIZE_CLASSES];
+    std::size_t bytes = 0;
+};
+
+struct Counters
+{
+    QAtomicInteger<qint64> bytesInUse;
+    QAtomicInteger<qint64> bytesPooled;
+    QAtomicInteger<qint64> highWaterMark;
+    QAtomicInteger<qint64> allocations;
+    QAtomicInteger<qint64> reuses;
+};
+
+// The shared lists and counters are deliberately never deleted, so that
+// blocks can still be released while static objects are destroyed.
+Counters& counters()
+{
+    static Counters* const counters = new Counters;
+    return *counters;
+}
+
+QMutex& sharedMutex()
+{
+    static QMutex* const mutex = new QMutex;
+    return *mutex;
+}
+
+FreeLists& sharedLists()
+{
+    static FreeLists* const lists = new FreeLists;
+    return *lists;
+}
+
+// Adds `header` to the shared lists if there is room, or frees it.
+void pushShared(BlockHeader* header)
+{
+    {
+        const QMutexLocker lock(&sharedMutex());
+        FreeLists& shared = sharedLists();
+        if (shared.bytes + header->size <= TilePool::SHARED_CACHE_BYTES)
+        {
+            shared.lists[header->sizeClass].push(header);
+            shared.bytes += header->size;
+            return;
+        }
+    }
+
+    counters().bytesPooled.fetchAndAddRelaxed(-(qint64)header->size);
+    freeBlock(header);
+}
+
+void flush(FreeLists& lists, bool toShared)
+{
+    for (FreeList& list : lists.lists)
+    {
+        while (BlockHeader* header = list.pop())
+        {
+            if (toShared)
+            {
+                pushShared(header);
+            }
+            else
+            {
+                counters().bytesPooled.fetchAndAddRelaxed(-(qint64)header->size);
+                freeBlock(header);
+            }
+        }
+    }
+    lists.bytes = 0;
+}
+
+// The free lists of the current thread are reached through a trivially
+// destructible pointer, which is cleared when the thread exits, so that
+// blocks released later in the thread's teardown go to the shared lists.
+thread_local FreeLists* t_lists = nullptr;
+thread_local bool t_exited = false;
+
+struct ThreadLists
+{
+    FreeLists lists;
+
+    ThreadLists() { t_lists = &lists; }
+    ~ThreadLists()
+    {
+        t_lists = nullptr;
+        t_exited = true;
+        flush(lists, true);
+    }
+};
+
+FreeLists* threadLists()
+{
+    if (t_exited) return nullptr;
+
+    thread_local ThreadLists threadLists;
+    return t_lists;
+}
+
+void releaseImage(void* data)
+{
+    TilePool::release(static_cast<uchar*>(data));
+}
+
+} // namespace
+
+TilePool::Block& TilePool::Block::operator=(Block&& other)
+{
+    if (this != &other)
+    {
+        reset();
+        _data = other._data;
+        other._data = nullptr;
+    }
+    return *this;
+}
+
+std::size_t TilePool::Block::size() const
+{
+    return _data ? headerOf(_data)->size : 0;
+}
+
+void TilePool::Block::reset()
+{
+    if (_data)
+    {
+        TilePool::release(_data);
+        _data = nullptr;
+    }
+}
+
+TilePool::Block TilePool::allocate(std::size_t size)
+{
+    if (size == 0) return Block();
+
+    const int sizeClass = sizeClassOf(size);
+    BlockHeader* header = nullptr;
+
+    if (sizeClass != -1)
+    {
+        if (FreeLists* lists = threadLists())
+        {
+            header = lists->lists[sizeClass].pop();
+            if (header)
+                lists->bytes -= header->size;
+        }
+
+        if (!header)
+        {
+            const QMutexLocker lock(&sharedMutex());
+            FreeLists& shared = sharedLists();
+            header = shared.lists[sizeClass].pop();
+            if (header)
+                shared.bytes -= header->size;
+        }
+    }
+
+    Counters& c = counters();
+
+    if (header)
+    {
+        c.bytesPooled.fetchAndAddRelaxed(-(qint64)header->size);
+        c.reuses.fetchAndAddRelaxed(1);
+    }
+    else
+    {
+        const std::size_t blockSize = sizeClass != -1
+            ? classSize(sizeClass)
+            : (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+
+        void* memory = qMallocAligned(ALIGNMENT + blockSize, ALIGNMENT);
+        if (!memory) throw std::bad_alloc();
+
+        header = new (memory) BlockHeader;
+        header->next = nullptr;
+        header->size = blockSize;
+        header->sizeClass = sizeClass;
+
+        c.allocations.fetchAndAddRelaxed(1);
+    }
+
+    const qint64 inUse = c.bytesInUse.fetchAndAddRelaxed(header->size) + header->size;
+
+    qint64 highWaterMark = c.highWaterMark.loadAcquire();
+    while (inUse > highWaterMark
+        && !c.highWaterMark.testAndSetRelaxed(highWaterMark, inUse, highWaterMark))
+    {
+    }
+
+    return Block(dataOf(header));
+}
+
+void TilePool::release(uchar* data)
+{
+    if (!data) return;
+
+    BlockHeader* header = headerOf(data);
+    Counters& c = counters();
+    c.bytesInUse.fetchAndAddRelaxed(-(qint64)header->size);
+
+    if (header->sizeClass == -1)
+    {
+        freeBlock(header);
+        return;
+    }
+
+    c.bytesPooled.fetchAndAddRelaxed(header->size);
+
+    FreeLists* lists = threadLists();
+    if (lists && lists->bytes + header->size <= THREAD_CACHE_BYTES)
+    {
+        lists->lists[header->sizeClass].push(header);
+        lists->bytes += header->size;
+    }
+    else
+    {
+        pushShared(header);
+    }
+}
+
+QImage TilePool::image(QSize size, QImage::Format format)
+{
+    if (size.isEmpty() || format == QImage::Format_Invalid)
+        return QImage();
+
+    // Scan lines are padded to 32 bits, as QImage does for its own buffers.
+    const int depth = QImage::toPixelFormat(format).bitsPerPixel();
+    const int bytesPerLine = (size.width() * depth + 31) / 32 * 4;
+
+    uchar* data = allocate((std::size_t)bytesPerLine * size.height()).take();
+
+    QImage result(data, size.width(), size.height(), bytesPerLine, format, &releaseImage, data);
+    if (result.isNull())
+        release(data);
+
+    return result;
+}
+
+TilePool::Stats TilePool::stats()
+{
+    const Counters& c = counters();
+    return Stats {
+        c.bytesInUse.loadAcquire(),
+        c.bytesPooled.loadAcquire(),
+        c.highWaterMark.loadAcquire(),
+        c.allocations.loadAcquire(),
+        c.reuses.loadAcquire()
+    };
+}
+
+void TilePool::trim()
+{
+    if (FreeLists* lists = threadLists())
+        flush(*lists, false);
+
+    FreeLists shared;
+    {
+        const QMutexLocker lock(&sharedMutex());
+        shared = sharedLists();
+        sharedLists() = FreeLists();
+    }
+    flush(shared, false);
+}
@@ -0,0 +1,115 @@
+/**
+ * Addle source code
+ * @file
+ * @copyright Copyright 2020 Eleanor Hawk
+ * @copyright Modification and distribution permitted under the terms of the
+ * MIT License. See "LICENSE" for full details.
+ */
+
+#ifndef TILEPOOL_HPP
+#define TILEPOOL_HPP
+
+#include "compat.hpp"
+
+#include <cstddef>
+
+#include <QImage>
+#include <QSize>
+
+namespace Addle {
+
+/**
+ * A pool of 64-byte-aligned memory blocks for pixel buffers, so that buffers
+ * which are made and discarded for every operation (e.g., by every brush dab)
+ * reuse the same memory instead of going back to the heap each time.
+ *
+ * Requests are rounded up to one of SIZE_CLASSES fixed block sizes, which
+ * double from MIN_BLOCK_SIZE. A freed block goes to a free list of the thread
+ * that freed it, or to a shared list once that is full, and is handed out
+ * again for the next request of its size. Requests larger than the largest
+ * size class are not pooled.
+ *
+ * Since a block may be up to twice the size requested, the pool is meant for
+ * short-lived scratch buffers. Buffers that live as long as a layer or an
+ * undo step are allocated normally.
+ */
+class ADDLE_COMMON_EXPORT TilePool
+{
+public:
+    static constexpr std::size_t ALIGNMENT = 64;
+    static constexpr std::size_t MIN_BLOCK_SIZE = 4 * 1024;
+    static constexpr int SIZE_CLASSES = 13; // up to 16 MiB
+
+    // The most memory kept on each thread's free lists, and on the shared
+    // free lists, before freed blocks are returned to the heap.
+    static constexpr std::size_t THREAD_CACHE_BYTES = 8 * 1024 * 1024;
+    static constexpr std::size_t SHARED_CACHE_BYTES = 64 * 1024 * 1024;
+
+    // Owns a block of the pool, returning it to the pool when destroyed.
+    class ADDLE_COMMON_EXPORT Block
+    {
+    public:
+        Block() = default;
+        Block(Block&& other) : _data(other._data) { other._data = nullptr; }
+        Block& operator=(Block&& other);
+        ~Block() { reset(); }
+
+        Block(const Block&) = delete;
+        Block& operator=(const Block&) = delete;
+
+        inline uchar* data() const { return _data; }
+        inline bool isNull() const { return !_data; }
+
+        // The usable size of the block, which may be more than was requested.
+        std::size_t size() const;
+
+        void reset();
+
+        // Gives up ownership of the block, which must later be passed to
+        // TilePool::release().
+        uchar* take() { uchar* data = _data; _data = nullptr; return data; }
+
+    private:
+        explicit Block(uchar* data) : _data(data) {}
+
+        uchar* _data = nullptr;
+
+        friend class TilePool;
+    };
+
+    struct Stats
+    {
+        // Bytes of blocks currently handed out.
+        qint64 bytesInUse;
+        // Bytes of blocks waiting on free lists.
+        qint64 bytesPooled;
+        // The most bytes that have been in use at once.
+        qint64 highWaterMark;
+
+        // Blocks taken from the heap, and blocks reused from a free list.
+        qint64 allocations;
+        qint64 reuses;
+    };
+
+    TilePool() = delete;
+
+    // Returns a block of at least `size` bytes. Its contents are undefined.
+    static Block allocate(std::size_t size);
+
+    static void release(uchar* data);
+
+    // Returns an image of `size` and `format` whose pixels are held in a
+    // block of the pool, which is released when the image (and all copies
+    // of it) are destroyed. The contents of the image are undefined.
+    static QImage image(QSize size, QImage::Format format);
+
+    static Stats stats();
+
+    // Returns the blocks on the shared free lists, and on those of the
+    // calling thread, to the heap.
+    static void trim();
+};
+
+} // namespace Addle
+
+#endif // TILEPOOL_HPP
@@ -9,6 +9,7 @@
 #include "iocheck.hpp"
 
 #include <QDir>
+#include <QBuffer>
 #include "utils.hpp"
 
 using namespace Addle;
@@ -85,6 +86,120 @@ QByteArray IOCheck::peek(QIODevice& device, int maxSize, bool* eof) const
     }
 }
 
+QByteArray IOCheck::readAll(QIODevice& device) const
+{
+    ADDLE_ASSERT(device.isOpen() && device.openMode() & QIODevice::ReadOnly);
+
+    const FileValidator validator = deviceValidator(device, FileException::Read);
+
+    QByteArray result = device.readAll();
+
+    // Sequential devices other than files (e.g., pipes and sockets) are read
+    // until they are closed.
+    if (device.isSequential() && !validator.file)
+    {
+        while (device.waitForReadyRead(-1))
+            result.append(device.readAll());
+    }
+
+    if (validator.file && validator.file->error() != QFileDevice::NoError)
+        onDeviceError(validator);
+
+    return result;
+}
+
+QByteArray IOCheck::readAllShared(QIODevice& device) const
+{
+    QBuffer* buffer = qobject_cast<QBuffer*>(&device);
+    if (!buffer)
+        return readAll(device);
+
+    ADDLE_ASSERT(device.isOpen() && device.openMode() & QIODevice::ReadOnly);
+
+    const QByteArray& data = buffer->data();
+    const qint64 pos = buffer->pos();
+    buffer->seek(data.size());
+
+    if (pos == 0)
+        return data; // implicitly shared
+    else
+        return QByteArray::fromRawData(data.constData() + pos, data.size() - pos);
+}
+
+void IOCheck::write(QIODevice& device, const QByteArray& data) const
+{
+    write(device, data.constData(), data.size());
+}
+
+void IOCheck::write(QIODevice& device, const char* data, int maxSize) const
+{
+    ADDLE_ASSERT(device.isOpen() && device.openMode() & QIODevice::WriteOnly);
+
+    const FileValidator validator = deviceValidator(device, FileException::Write);
+
+    qint64 written = 0;
+    while (written < maxSize)
+    {
+        const qint64 result = device.write(data + written, maxSize - written);
+        if (result <= 0)
+        {
+            onDeviceError(validator);
+            return;
+        }
+        written += result;
+    }
+}
+
+void IOCheck::flush(QIODevice& device) const
+{
+    const FileValidator validator = deviceValidator(device, FileException::Write);
+
+    if (validator.file && !validator.file->flush())
+        onDeviceError(validator);
+}
+
+void IOCheck::seek(QIODevice& device, qint64 pos) const
+{
+    ADDLE_ASSERT(device.isOpen() && !device.isSequential());
+
+    const FileValidator validator = deviceValidator(
+        device,
+        device.openMode() & QIODevice::WriteOnly ? FileException::Write : FileException::Read
+    );
+
+    if (!device.seek(pos))
+        onDeviceError(validator);
+}
+
+IOCheck::FileValidator IOCheck::deviceValidator(QIODevice& device, FileException::Operation operation) const
+{
+    FileValidator validator(*this);
+    validator.operation = operation;
+
+    validator.file = qobject_cast<QFile*>(&device);
+    if (validator.file)
+    {
+        validator.info = QFileInfo(*validator.file);
+        validator.reading = (operation == FileException::Read);
+        validator.writing = (operation == FileException::Write);
+    }
+
+    return validator;
+}
+
+void IOCheck::onDeviceError(const FileValidator& validator) const
+{
+    if (validator.file)
+    {
+        validator.onFileDeviceError();
+    }
+    else
+    {
+        //% "An error occurred but the device type is unknown / unsupported so it could not be diagnosed."
+        ADDLE_LOGIC_ERROR_M(qtTrId("debug-messages.io-check.unknown-device-error"));
+    }
+}
+
 IOCheck::FileValidator::FileValidator(const IOCheck& owner, QFile* file_, QIODevice::OpenMode mode)
     : _owner(owner), file(file_), info(*file_)
 {
@@ -83,6 +83,13 @@ public:
     QByteArray readAll(QIODevice& device) const;
     QByteArray peek(QIODevice& device, int maxSize, bool* eof = nullptr) const;
 
+    /**
+     * Like readAll, but if `device` is a QBuffer (including a
+     * MappedFileDevice), the result refers to the buffer's data rather than
+     * copying it. The result must not be kept longer than the device.
+     */
+    QByteArray readAllShared(QIODevice& device) const;
+
     void write(QIODevice& device, const QByteArray& data) const;
     void write(QIODevice& device, const char* data, int maxSize) const;
     void flush(QIODevice& device) const;
@@ -125,6 +132,10 @@ private:
         const IOCheck& _owner;
     };
 
+    // The file validator, if any, for an operation on an open device.
+    FileValidator deviceValidator(QIODevice& device, FileException::Operation operation) const;
+    void onDeviceError(const FileValidator& validator) const;
+
     void throw_(FileException&& ex, QIODevice* device = nullptr) const;
 
     Problems _filter;
@@ -0,0 +1,60 @@
+/**
+ * Addle source code
+ * @file
+ * @copyright Copyright 2020 Eleanor Hawk
+ * @copyright Modification and distribution permitted under the terms of the
+ * MIT License. See "LICENSE" for full details.
+ */
+
+#include "mappedfiledevice.hpp"
+
+#include "utilities/iocheck.hpp"
+#include "utilities/errors.hpp"
+
+using namespace Addle;
+
+MappedFileDevice::MappedFileDevice(const QString& filename, QObject* parent)
+    : QBuffer(parent), _file(filename)
+{
+}
+
+MappedFileDevice::~MappedFileDevice()
+{
+    close();
+}
+
+bool MappedFileDevice::open(OpenMode mode)
+{
+    ADDLE_ASSERT_M(
+        (mode & ReadWrite) == ReadOnly,
+        //% "MappedFileDevice can only be opened for reading."
+        qtTrId("debug-messages.mapped-file-device.read-only")
+    );
+
+    if (isOpen()) return true;
+
+    IOCheck().openFile(_file, QIODevice::ReadOnly);
+
+    _map = _file.map(0, _file.size());
+    if (_map)
+        setData(QByteArray::fromRawData(reinterpret_cast<const char*>(_map), _file.size()));
+    else
+        setData(IOCheck().readAll(_file));
+
+    return QBuffer::open(mode);
+}
+
+void MappedFileDevice::close()
+{
+    if (!isOpen()) return;
+
+    QBuffer::close();
+    setData(QByteArray());
+
+    if (_map)
+    {
+        _file.unmap(_map);
+        _map = nullptr;
+    }
+    _file.close();
+}
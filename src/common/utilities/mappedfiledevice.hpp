@@ -0,0 +1,52 @@
+/**
+ * Addle source code
+ * @file
+ * @copyright Copyright 2020 Eleanor Hawk
+ * @copyright Modification and distribution permitted under the terms of the
+ * MIT License. See "LICENSE" for full details.
+ */
+
+#ifndef MAPPEDFILEDEVICE_HPP
+#define MAPPEDFILEDEVICE_HPP
+
+#include "compat.hpp"
+
+#include <QBuffer>
+#include <QFile>
+
+namespace Addle {
+
+/**
+ * @class MappedFileDevice
+ * @brief A read-only device over a memory-mapped file.
+ *
+ * Being a QBuffer, the device is random-access and its contents are available
+ * through `data()` without copying (see also IOCheck::readAllShared). If the
+ * file cannot be mapped, it is read into memory instead.
+ *
+ * The mapping is released when the device is closed, so data obtained from
+ * it must not be kept longer than that.
+ */
+class ADDLE_COMMON_EXPORT MappedFileDevice : public QBuffer
+{
+    Q_OBJECT
+public:
+    MappedFileDevice(const QString& filename, QObject* parent = nullptr);
+    virtual ~MappedFileDevice();
+
+    QString fileName() const { return _file.fileName(); }
+    bool isMapped() const { return _map != nullptr; }
+
+    // Only QIODevice::ReadOnly is supported. Errors opening the file are
+    // thrown as FileException by IOCheck.
+    bool open(OpenMode mode) override;
+    void close() override;
+
+private:
+    QFile _file;
+    uchar* _map = nullptr;
+};
+
+} // namespace Addle
+
+#endif // MAPPEDFILEDEVICE_HPP
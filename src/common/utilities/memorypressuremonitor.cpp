@@ -0,0 +1,147 @@
+/**
+ * Addle source code
+ * @file
+ * @copyright Copyright 2020 Eleanor Hawk
+ * @copyright Modification and distribution permitted under the terms of the
+ * MIT License. See "LICENSE" for full details.
+ */
+
+#include "memorypressuremonitor.hpp"
+
+#if defined(Q_OS_LINUX)
+#include <QSocketNotifier>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#elif defined(Q_OS_WIN)
+#include <QWinEventNotifier>
+#include <windows.h>
+#elif defined(Q_OS_MACOS)
+#include <dispatch/dispatch.h>
+#endif
+
+using namespace Addle;
+
+struct MemoryPressureMonitor::Source
+{
+#if defined(Q_OS_LINUX)
+    int fd = -1;
+    QSocketNotifier* notifier = nullptr;
+#elif defined(Q_OS_WIN)
+    HANDLE handle = nullptr;
+    QWinEventNotifier* notifier = nullptr;
+#elif defined(Q_OS_MACOS)
+    dispatch_source_t source = nullptr;
+#endif
+};
+
+MemoryPressureMonitor::MemoryPressureMonitor(QObject* parent)
+    : QObject(parent), _source(new Source)
+{
+    _cooldown.setSingleShot(true);
+    _cooldown.setInterval(COOLDOWN);
+    connect(&_cooldown, &QTimer::timeout, this, &MemoryPressureMonitor::onCooldownFinished);
+
+#if defined(Q_OS_LINUX)
+    // The kernel signals the file once tasks have stalled waiting for memory
+    // for 150 ms within a 2 s window (given in microseconds). Shorter windows
+    // are only allowed to privileged processes.
+    const int fd = ::open("/proc/pressure/memory", O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (fd >= 0)
+    {
+        const char trigger[] = "some 150000 2000000";
+        if (::write(fd, trigger, std::strlen(trigger) + 1) > 0)
+        {
+            _source->fd = fd;
+            _source->notifier = new QSocketNotifier(fd, QSocketNotifier::Exception, this);
+            connect(_source->notifier, SIGNAL(activated(int)), this, SLOT(onNotified()));
+        }
+        else
+        {
+            ::close(fd);
+        }
+    }
+#elif defined(Q_OS_WIN)
+    // The notification stays signaled for as long as memory is low, so the
+    // notifier is disabled during the cooldown.
+    _source->handle = CreateMemoryResourceNotification(LowMemoryResourceNotification);
+    if (_source->handle)
+    {
+        _source->notifier = new QWinEventNotifier(_source->handle, this);
+        connect(_source->notifier, &QWinEventNotifier::activated, this, &MemoryPressureMonitor::onNotified);
+    }
+#elif defined(Q_OS_MACOS)
+    // The handler is called on the main queue, which is run by the GUI
+    // thread's event loop.
+    _source->source = dispatch_source_create(
+        DISPATCH_SOURCE_TYPE_MEMORYPRESSURE,
+        0,
+        DISPATCH_MEMORYPRESSURE_WARN | DISPATCH_MEMORYPRESSURE_CRITICAL,
+        dispatch_get_main_queue()
+    );
+    if (_source->source)
+    {
+        dispatch_set_context(_source->source, this);
+        dispatch_source_set_event_handler_f(_source->source, [](void* context) {
+            static_cast<MemoryPressureMonitor*>(context)->onNotified();
+        });
+        dispatch_resume(_source->source);
+    }
+#endif
+}
+
+MemoryPressureMonitor::~MemoryPressureMonitor()
+{
+#if defined(Q_OS_LINUX)
+    if (_source->fd >= 0)
+    {
+        delete _source->notifier;
+        ::close(_source->fd);
+    }
+#elif defined(Q_OS_WIN)
+    if (_source->handle)
+    {
+        delete _source->notifier;
+        CloseHandle(_source->handle);
+    }
+#elif defined(Q_OS_MACOS)
+    if (_source->source)
+    {
+        dispatch_source_cancel(_source->source);
+        dispatch_release(_source->source);
+    }
+#endif
+}
+
+bool MemoryPressureMonitor::isSupported() const
+{
+#if defined(Q_OS_LINUX)
+    return _source->fd >= 0;
+#elif defined(Q_OS_WIN)
+    return _source->handle;
+#elif defined(Q_OS_MACOS)
+    return _source->source;
+#else
+    return false;
+#endif
+}
+
+void MemoryPressureMonitor::onNotified()
+{
+    if (_cooldown.isActive()) return;
+
+#if defined(Q_OS_LINUX) || defined(Q_OS_WIN)
+    _source->notifier->setEnabled(false);
+#endif
+    _cooldown.start();
+
+    emit pressure();
+}
+
+void MemoryPressureMonitor::onCooldownFinished()
+{
+#if defined(Q_OS_LINUX) || defined(Q_OS_WIN)
+    if (_source->notifier)
+        _source->notifier->setEnabled(true);
+#endif
+}
@@ -0,0 +1,61 @@
+/**
+ * Addle source code
+ * @file
+ * @copyright Copyright 2020 Eleanor Hawk
+ * @copyright Modification and distribution permitted under the terms of the
+ * MIT License. See "LICENSE" for full details.
+ */
+
+#ifndef MEMORYPRESSUREMONITOR_HPP
+#define MEMORYPRESSUREMONITOR_HPP
+
+#include "compat.hpp"
+
+#include <QObject>
+#include <QScopedPointer>
+#include <QTimer>
+
+namespace Addle {
+
+/**
+ * Emits `pressure()` when the operating system reports that memory is running
+ * low, which Qt does not do on the desktop.
+ *
+ * The source is pressure stall information on Linux (5.2 and later), a
+ * low-memory resource notification on Windows, and a memory pressure dispatch
+ * source on macOS. Where none is available, `isSupported()` is false and the
+ * signal is never emitted.
+ *
+ * Low memory may persist for some time, so after emitting the signal the
+ * monitor waits COOLDOWN milliseconds before it emits it again.
+ *
+ * Must be created and used on the GUI thread.
+ */
+class ADDLE_COMMON_EXPORT MemoryPressureMonitor : public QObject
+{
+    Q_OBJECT
+public:
+    MemoryPressureMonitor(QObject* parent = nullptr);
+    virtual ~MemoryPressureMonitor();
+
+    bool isSupported() const;
+
+    static constexpr int COOLDOWN = 10000; // ms
+
+signals:
+    void pressure();
+
+private slots:
+    void onNotified();
+    void onCooldownFinished();
+
+private:
+    struct Source;
+
+    QScopedPointer<Source> _source;
+    QTimer _cooldown;
+};
+
+} // namespace Addle
+
+#endif // MEMORYPRESSUREMONITOR_HPP
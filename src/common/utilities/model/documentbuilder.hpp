@@ -11,9 +11,13 @@
 
 #include "compat.hpp"
 #include <QString>
+#include <QSize>
 #include <QSharedData>
 #include <QSharedDataPointer>
+#include <QSharedPointer>
 #include "layerbuilder.hpp"
+#include "utilities/image/animationsource.hpp"
+#include "layergroupinfo.hpp"
 namespace Addle {
 
 class DocumentBuilder
@@ -22,7 +26,10 @@ class DocumentBuilder
     {
         QString filename;
         QList<LayerBuilder> layers;
+        QList<LayerGroupInfo> layerGroups;
         QColor backgroundColor = Qt::transparent;
+        QSize size;
+        QSharedPointer<AnimationSource> animation;
     };
 public:
     DocumentBuilder() { _data = new DocumentBuilderData; }
@@ -34,9 +41,25 @@ public:
     QColor backgroundColor() const { return _data->backgroundColor; }
     void setBackgroundColor(QColor backgroundColor) { _data->backgroundColor = backgroundColor; }
 
+    // If not set, the size of the document is taken from the boundaries of
+    // its layers.
+    QSize size() const { return _data->size; }
+    void setSize(QSize size) { _data->size = size; }
+
+    // Layers are ordered top-most first.
     QList<LayerBuilder> layers() const { return _data->layers; }
     void addLayer(LayerBuilder& layer) { _data->layers.append(layer); }
 
+    QList<LayerGroupInfo> layerGroups() const { return _data->layerGroups; }
+
+    // For an animated image, the source of its frames. The first frame should
+    // also be given as the document's only layer.
+    QSharedPointer<AnimationSource> animation() const { return _data->animation; }
+    void setAnimation(QSharedPointer<AnimationSource> animation) { _data->animation = animation; }
+
+    // Returns the index of the new group, for use in LayerBuilder::groupPath
+    int addLayerGroup(LayerGroupInfo group) { _data->layerGroups.append(group); return _data->layerGroups.size() - 1; }
+
 private:
     QSharedDataPointer<DocumentBuilderData> _data;
 };
@@ -0,0 +1,115 @@
+/**
+ * Addle source code
+ * @file
+ * @copyright Copyright 2020 Eleanor Hawk
+ * @copyright Modification and distribution permitted under the terms of the
+ * MIT License. See "LICENSE" for full details.
+ */
+
+#include "documentsnapshot.hpp"
+
+#include "interfaces/models/idocument.hpp"
+#include "interfaces/models/ilayer.hpp"
+#include "interfaces/editing/irastersurface.hpp"
+
+#include "utilities/errors.hpp"
+#include "utilities/parallel.hpp"
+
+#include <QMutex>
+
+using namespace Addle;
+
+DocumentSnapshot::DocumentSnapshot(IDocument& document)
+    : _size(document.size()),
+    _backgroundColor(document.backgroundColor()),
+    _layerGroups(document.layerGroups())
+{
+    for (const auto& layer : document.layers())
+    {
+        auto surface = layer->rasterSurface();
+
+        Layer snapshot;
+        snapshot.surface = surface;
+
+        // Taken before the image, so that a change made in between is
+        // counted as modified, and saved again next time.
+        snapshot.modifiedTiles = surface->modifiedTiles(&snapshot.generation);
+        snapshot.tileSource = surface->tileSource();
+
+        snapshot.image = surface->copy(QRect(), &snapshot.offset);
+        snapshot.name = layer->name();
+        snapshot.compositionMode = surface->compositionMode();
+        snapshot.opacity = surface->alpha() / 255.0;
+        snapshot.groupPath = layer->groupPath();
+
+        _layers.append(snapshot);
+    }
+}
+
+QSharedPointer<const DocumentSnapshot> DocumentSnapshot::forExport(IDocument* model, const DocumentImportExportInfo& info)
+{
+    if (info.snapshot())
+        return info.snapshot();
+
+    ADDLE_ASSERT(model);
+    return QSharedPointer<const DocumentSnapshot>(new DocumentSnapshot(*model));
+}
+
+QImage DocumentSnapshot::composite(std::function<void(double)> progress) const
+{
+    const QRect documentRect(QPoint(), _size);
+
+    QImage result(documentRect.size(), QImage::Format_ARGB32_Premultiplied);
+    result.fill(_backgroundColor);
+
+    uchar* const bits = result.bits();
+    const int bytesPerLine = result.bytesPerLine();
+
+    // The document is composited one band at a time, so that each band is
+    // drawn only from the layers that intersect it and so that progress can
+    // be reported as it goes. Bands do not overlap, so they are drawn in
+    // parallel, each by its own painter.
+    const int bandCount = (documentRect.height() + BAND_HEIGHT - 1) / BAND_HEIGHT;
+
+    QMutex progressMutex;
+    int bandsFinished = 0;
+
+    parallelFor(0, bandCount, [&](int i) {
+        const QRect band = QRect(
+                0, i * BAND_HEIGHT,
+                documentRect.width(), BAND_HEIGHT
+            ).intersected(documentRect);
+
+        QImage bandImage(
+            bits + band.top() * bytesPerLine,
+            band.width(), band.height(),
+            bytesPerLine,
+            result.format()
+        );
+        QPainter painter(&bandImage);
+        painter.translate(-band.topLeft());
+
+        // Bottom-most first
+        for (auto layer = _layers.crbegin(); layer != _layers.crend(); ++layer)
+        {
+            const QRect layerArea = QRect(layer->offset, layer->image.size()).intersected(band);
+            if (layerArea.isEmpty()) continue;
+
+            painter.setCompositionMode(layer->compositionMode);
+            painter.setOpacity(layer->opacity);
+            painter.drawImage(
+                layerArea.topLeft(),
+                layer->image,
+                layerArea.translated(-layer->offset)
+            );
+        }
+
+        if (progress)
+        {
+            const QMutexLocker lock(&progressMutex);
+            progress((double)(++bandsFinished) / bandCount);
+        }
+    });
+
+    return result;
+}
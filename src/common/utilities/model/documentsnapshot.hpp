@@ -0,0 +1,94 @@
+/**
+ * Addle source code
+ * @file
+ * @copyright Copyright 2020 Eleanor Hawk
+ * @copyright Modification and distribution permitted under the terms of the
+ * MIT License. See "LICENSE" for full details.
+ */
+
+#ifndef DOCUMENTSNAPSHOT_HPP
+#define DOCUMENTSNAPSHOT_HPP
+
+#include "compat.hpp"
+#include <functional>
+
+#include <QImage>
+#include <QList>
+#include <QPainter>
+#include <QColor>
+#include <QSet>
+#include <QSize>
+#include <QSharedPointer>
+
+#include "utilities/hashfunctions.hpp"
+#include "utilities/format/importexportinfo.hpp"
+#include "utilities/model/layergroupinfo.hpp"
+
+namespace Addle {
+
+class IDocument;
+class IRasterSurface;
+class RasterTileSource;
+
+/**
+ * A frozen copy of the contents of a document, for use by format drivers
+ * while exporting.
+ *
+ * The snapshot must be taken on the thread that owns the document, e.g.,
+ * before starting a task that saves it. Layer images share data with the
+ * document copy-on-write, so the snapshot is inexpensive to take, and the
+ * document may continue to be edited while the snapshot is in use on another
+ * thread.
+ */
+class ADDLE_COMMON_EXPORT DocumentSnapshot
+{
+public:
+    struct Layer
+    {
+        QImage image;
+        QPoint offset;
+        QString name;
+        QPainter::CompositionMode compositionMode = QPainter::CompositionMode_SourceOver;
+        double opacity = 1.0;
+        QList<int> groupPath;
+
+        // For drivers that save incrementally. The surface the layer was
+        // taken from, its tile source, and the tiles that differ from the
+        // tile source, as of `generation` (see IRasterSurface::modifiedTiles).
+        QSharedPointer<IRasterSurface> surface;
+        QSharedPointer<RasterTileSource> tileSource;
+        QSet<QPoint> modifiedTiles;
+        quint64 generation = 0;
+    };
+
+    DocumentSnapshot(IDocument& document);
+
+    // The snapshot set on `info`, if any, or else a new snapshot of `model`.
+    static QSharedPointer<const DocumentSnapshot> forExport(IDocument* model, const DocumentImportExportInfo& info);
+
+    QSize size() const { return _size; }
+    QColor backgroundColor() const { return _backgroundColor; }
+
+    // Top-most first
+    const QList<Layer>& layers() const { return _layers; }
+    const QList<LayerGroupInfo>& layerGroups() const { return _layerGroups; }
+
+    // Composites the layers over the background color into a single image of
+    // the document. The image is drawn in horizontal bands, in parallel, and
+    // `progress` (if set) is called with values from 0.0 to 1.0 as each is
+    // finished. Calls to `progress` may come from any thread, but never more
+    // than one at a time.
+    QImage composite(std::function<void(double)> progress = nullptr) const;
+
+    static constexpr int BAND_HEIGHT = 256;
+
+private:
+    QSize _size;
+    QColor _backgroundColor;
+    QList<Layer> _layers;
+    QList<LayerGroupInfo> _layerGroups;
+};
+
+} // namespace Addle
+
+#endif // DOCUMENTSNAPSHOT_HPP
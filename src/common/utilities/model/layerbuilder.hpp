@@ -12,8 +12,14 @@
 #include "compat.hpp"
 #include <QRect>
 #include <QImage>
+#include <QList>
+#include <QString>
+#include <QPainter>
 #include <QSharedData>
 #include <QSharedDataPointer>
+#include <QSharedPointer>
+
+#include "utilities/image/rastertilesource.hpp"
 namespace Addle {
 
 class LayerBuilder
@@ -22,6 +28,11 @@ class LayerBuilder
     {
         QRect boundary;
         QImage image;
+        QString name;
+        double opacity = 1.0;
+        QPainter::CompositionMode compositionMode = QPainter::CompositionMode_SourceOver;
+        QList<int> groupPath;
+        QSharedPointer<RasterTileSource> tileSource;
     };
 public:
     LayerBuilder() { _data = new LayerBuilderData; }
@@ -33,6 +44,25 @@ public:
     void setImage(QImage image) { _data->image = image; }
     QImage image() const { return _data->image; }
 
+    void setName(QString name) { _data->name = name; }
+    QString name() const { return _data->name; }
+
+    void setOpacity(double opacity) { _data->opacity = opacity; }
+    double opacity() const { return _data->opacity; }
+
+    void setCompositionMode(QPainter::CompositionMode mode) { _data->compositionMode = mode; }
+    QPainter::CompositionMode compositionMode() const { return _data->compositionMode; }
+
+    // The layer groups containing this layer, outermost first, as indices
+    // into the layer groups of the document builder.
+    void setGroupPath(QList<int> groupPath) { _data->groupPath = groupPath; }
+    QList<int> groupPath() const { return _data->groupPath; }
+
+    // If set, the layer's raster data is decoded from this source as needed,
+    // instead of being taken from `image()`.
+    void setTileSource(QSharedPointer<RasterTileSource> source) { _data->tileSource = source; }
+    QSharedPointer<RasterTileSource> tileSource() const { return _data->tileSource; }
+
 private:
     QSharedDataPointer<LayerBuilderData> _data;
 };
@@ -0,0 +1,271 @@
+/**
+ * Addle source code
+ * @file
+ * @copyright Copyright 2020 Eleanor Hawk
+ * @copyright Modification and distribution permitted under the terms of the
+ * MIT License. See "LICENSE" for full details.
+ */
+
+#include "parallel.hpp"
+
+#include <exception>
+#include <memory>
+#include <vector>
+
+#include <QAtomicInt>
+#include <QMutex>
+#include <QRunnable>
+#include <QThread>
+#include <QWaitCondition>
+
+#include "taskscheduler.hpp"
+
+using namespace Addle;
+
+namespace {
+
+// A range of chunk indices belonging to one worker. The worker takes chunks
+// from the front, and other workers steal from the back.
+struct WorkRange
+{
+    QMutex mutex;
+    int begin = 0;
+    int end = 0;
+};
+
+class ParallelJob
+{
+public:
+    ParallelJob(
+            int begin,
+            int end,
+            int grain,
+            int workerCount,
+            const std::function<void(int)>& kernel,
+            const std::function<bool()>& isCancelled
+        )
+        : _begin(begin),
+        _end(end),
+        _grain(grain),
+        _kernel(kernel),
+        _isCancelled(isCancelled)
+    {
+        const int chunkCount = (end - begin + grain - 1) / grain;
+
+        _ranges.reserve(workerCount);
+        for (int i = 0; i < workerCount; ++i)
+        {
+            std::unique_ptr<WorkRange> range(new WorkRange);
+            range->begin = (int)((qint64)chunkCount * i / workerCount);
+            range->end = (int)((qint64)chunkCount * (i + 1) / workerCount);
+            _ranges.push_back(std::move(range));
+        }
+    }
+
+    void work(int self)
+    {
+        int chunk;
+        while (!_stop.loadAcquire() && take(self, chunk))
+        {
+            if (_isCancelled && _isCancelled())
+            {
+                _cancelled.storeRelease(true);
+                _stop.storeRelease(true);
+                break;
+            }
+
+            try
+            {
+                const int chunkBegin = _begin + chunk * _grain;
+                const int chunkEnd = qMin(chunkBegin + _grain, _end);
+                for (int i = chunkBegin; i < chunkEnd; ++i)
+                    _kernel(i);
+            }
+            catch (...)
+            {
+                const QMutexLocker lock(&_errorMutex);
+                if (!_error)
+                    _error = std::current_exception();
+                _stop.storeRelease(true);
+            }
+        }
+    }
+
+    void addHelper() { const QMutexLocker lock(&_helperMutex); ++_helpers; }
+
+    void helperFinished()
+    {
+        const QMutexLocker lock(&_helperMutex);
+        --_helpers;
+        _helpersFinished.wakeAll();
+    }
+
+    void waitForHelpers()
+    {
+        const QMutexLocker lock(&_helperMutex);
+        while (_helpers > 0)
+            _helpersFinished.wait(&_helperMutex);
+    }
+
+    bool wasCancelled() const { return _cancelled.loadAcquire(); }
+    std::exception_ptr error() const { const QMutexLocker lock(&_errorMutex); return _error; }
+
+private:
+    bool take(int self, int& chunk)
+    {
+        WorkRange& own = *_ranges[self];
+        {
+            const QMutexLocker lock(&own.mutex);
+            if (own.begin < own.end)
+            {
+                chunk = own.begin++;
+                return true;
+            }
+        }
+
+        const int count = (int)_ranges.size();
+        for (int offset = 1; offset < count; ++offset)
+        {
+            WorkRange& victim = *_ranges[(self + offset) % count];
+
+            int stolenBegin;
+            int stolenEnd;
+            {
+                const QMutexLocker lock(&victim.mutex);
+                const int remaining = victim.end - victim.begin;
+                if (remaining <= 0) continue;
+
+                stolenEnd = victim.end;
+                stolenBegin = victim.end - (remaining + 1) / 2;
+                victim.end = stolenBegin;
+            }
+
+            // The worker's own range is empty, so other workers will not
+            // have taken anything from it in the meantime.
+            {
+                const QMutexLocker lock(&own.mutex);
+                own.begin = stolenBegin + 1;
+                own.end = stolenEnd;
+            }
+
+            chunk = stolenBegin;
+            return true;
+        }
+
+        return false;
+    }
+
+    const int _begin;
+    const int _end;
+    const int _grain;
+
+    const std::function<void(int)>& _kernel;
+    const std::function<bool()>& _isCancelled;
+
+    std::vector<std::unique_ptr<WorkRange>> _ranges;
+
+    QAtomicInt _stop;
+    QAtomicInt _cancelled;
+
+    mutable QMutex _errorMutex;
+    std::exception_ptr _error;
+
+    QMutex _helperMutex;
+    QWaitCondition _helpersFinished;
+    int _helpers = 0;
+};
+
+class ParallelHelper : public QRunnable
+{
+public:
+    ParallelHelper(ParallelJob& job, int index)
+        : _job(job), _index(index)
+    {
+    }
+    virtual ~ParallelHelper() = default;
+
+    void run() override
+    {
+        _job.work(_index);
+        _job.helperFinished();
+    }
+
+private:
+    ParallelJob& _job;
+    const int _index;
+};
+
+} // namespace
+
+bool Addle::parallelFor(
+        int begin,
+        int end,
+        const std::function<void(int)>& kernel,
+        const std::function<bool()>& isCancelled,
+        int grain
+    )
+{
+    if (end <= begin) return true;
+
+    grain = qMax(grain, 1);
+    const int chunkCount = (end - begin + grain - 1) / grain;
+    const int workerCount = qMin(chunkCount, qMax(QThread::idealThreadCount(), 1));
+
+    ParallelJob job(begin, end, grain, workerCount, kernel, isCancelled);
+
+    if (workerCount > 1)
+    {
+        QThreadPool& pool = TaskScheduler::pool(TaskScheduler::Interactive);
+        for (int i = 1; i < workerCount; ++i)
+        {
+            ParallelHelper* helper = new ParallelHelper(job, i);
+
+            job.addHelper();
+            if (!pool.tryStart(helper))
+            {
+                // There are no free threads, e.g., because this is a nested
+                // loop. The remaining ranges are left to be stolen.
+                job.helperFinished();
+                delete helper;
+                break;
+            }
+        }
+    }
+
+    job.work(0);
+    job.waitForHelpers();
+
+    if (job.error())
+        std::rethrow_exception(job.error());
+
+    return !job.wasCancelled();
+}
+
+bool Addle::parallelForTiles(
+        QRect area,
+        const std::function<void(QRect)>& kernel,
+        const std::function<bool()>& isCancelled,
+        int tileSize
+    )
+{
+    if (area.isEmpty()) return true;
+
+    tileSize = qMax(tileSize, 1);
+    const int columns = (area.width() + tileSize - 1) / tileSize;
+    const int rows = (area.height() + tileSize - 1) / tileSize;
+
+    return parallelFor(
+        0, columns * rows,
+        [&](int i) {
+            const QRect tile = QRect(
+                area.left() + (i % columns) * tileSize,
+                area.top() + (i / columns) * tileSize,
+                tileSize,
+                tileSize
+            ).intersected(area);
+
+            kernel(tile);
+        },
+        isCancelled
+    );
+}
@@ -0,0 +1,63 @@
+/**
+ * Addle source code
+ * @file
+ * @copyright Copyright 2020 Eleanor Hawk
+ * @copyright Modification and distribution permitted under the terms of the
+ * MIT License. See "LICENSE" for full details.
+ */
+
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include "compat.hpp"
+
+#include <functional>
+
+#include <QRect>
+
+namespace Addle {
+
+/**
+ * Calls `kernel` once for every index in [begin, end), on as many threads as
+ * are useful, and returns once all calls have finished.
+ *
+ * The indices are divided among the workers up front, in contiguous ranges
+ * of `grain` indices, and a worker that runs out takes half of the remainder
+ * of another's. The calling thread is one of the workers, and the others are
+ * taken from TaskScheduler's Interactive lane only if threads are free there.
+ * So parallelFor can be nested, or called from a pool thread, without
+ * waiting on work that cannot start.
+ *
+ * If `isCancelled` is given, it is checked before each range of indices, and
+ * no more are started once it returns true. If the kernel throws, no more are
+ * started, and the first exception is rethrown on the calling thread.
+ *
+ * Returns false if the loop was cancelled before finishing.
+ */
+ADDLE_COMMON_EXPORT bool parallelFor(
+    int begin,
+    int end,
+    const std::function<void(int)>& kernel,
+    const std::function<bool()>& isCancelled = std::function<bool()>(),
+    int grain = 1
+);
+
+// The default side length of the tiles of parallelForTiles. A tile of
+// ARGB32 pixels is 64 KiB, so it fits in a typical L2 cache.
+constexpr int PARALLEL_TILE_SIZE = 128;
+
+/**
+ * Divides `area` into square tiles of `tileSize`, aligned to the top-left
+ * corner of `area` and clipped to it, and calls `kernel` with each tile as
+ * parallelFor() does.
+ */
+ADDLE_COMMON_EXPORT bool parallelForTiles(
+    QRect area,
+    const std::function<void(QRect)>& kernel,
+    const std::function<bool()>& isCancelled = std::function<bool()>(),
+    int tileSize = PARALLEL_TILE_SIZE
+);
+
+} // namespace Addle
+
+#endif // PARALLEL_HPP
@@ -0,0 +1,88 @@
+/**
+ * Addle source code
+ * @file
+ * @copyright Copyright 2020 Eleanor Hawk
+ * @copyright Modification and distribution permitted under the terms of the
+ * MIT License. See "LICENSE" for full details.
+ */
+
+#ifndef DIRTYREGION_HPP
+#define DIRTYREGION_HPP
+
+#include <QRect>
+#include <QRegion>
+
+namespace Addle {
+
+/**
+ * Accumulates invalidated areas as a set of grid-aligned tiles, so that many
+ * small overlapping changes (e.g., the segments of a brush stroke) collapse
+ * into one region covering only the tiles that were actually touched, rather
+ * than their common bounding rect.
+ *
+ * Consumers add changed areas as they are reported and take() the region once
+ * per frame.
+ */
+class DirtyRegion
+{
+public:
+    DirtyRegion(int tileSize = DEFAULT_TILE_SIZE)
+        : _tileSize(qMax(tileSize, 1))
+    {
+    }
+
+    inline int tileSize() const { return _tileSize; }
+
+    inline bool isEmpty() const { return _region.isEmpty(); }
+    inline QRegion region() const { return _region; }
+    inline QRect boundingRect() const { return _region.boundingRect(); }
+
+    inline void add(QRect area)
+    {
+        if (area.isEmpty()) return;
+        _region += snapToTiles(area);
+    }
+
+    inline void add(const QRegion& region)
+    {
+        for (QRect rect : region)
+            add(rect);
+    }
+
+    inline void clear() { _region = QRegion(); }
+
+    inline QRegion take()
+    {
+        QRegion result;
+        result.swap(_region);
+        return result;
+    }
+
+    // Expands `area` outward to the nearest tile boundaries.
+    inline QRect snapToTiles(QRect area) const
+    {
+        const int left = floorTo(area.left());
+        const int top = floorTo(area.top());
+        const int right = floorTo(area.right()) + _tileSize;
+        const int bottom = floorTo(area.bottom()) + _tileSize;
+
+        return QRect(left, top, right - left, bottom - top);
+    }
+
+    static constexpr int DEFAULT_TILE_SIZE = 64;
+
+private:
+    inline int floorTo(int x) const
+    {
+        // Round toward negative infinity -- layer areas may have negative
+        // coordinates.
+        return (x >= 0 ? x / _tileSize : (x + 1) / _tileSize - 1) * _tileSize;
+    }
+
+    int _tileSize;
+    QRegion _region;
+};
+
+} // namespace Addle
+
+#endif // DIRTYREGION_HPP
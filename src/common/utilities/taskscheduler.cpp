@@ -0,0 +1,133 @@
+/**
+ * Addle source code
+ * @file
+ * @copyright Copyright 2020 Eleanor Hawk
+ * @copyright Modification and distribution permitted under the terms of the
+ * MIT License. See "LICENSE" for full details.
+ */
+
+#include "taskscheduler.hpp"
+
+#include <QThread>
+
+using namespace Addle;
+
+namespace {
+
+QThreadPool* makePool(int maxThreadCount)
+{
+    QThreadPool* pool = new QThreadPool;
+    pool->setMaxThreadCount(maxThreadCount);
+    return pool;
+}
+
+} // namespace
+
+QThreadPool& TaskScheduler::pool(Lane lane)
+{
+    // The pools are made on first use, and deliberately never deleted, so
+    // that work can still be queued while static objects are destroyed.
+    static QThreadPool* const ioPool = makePool(threadCount(IO));
+    static QThreadPool* const backgroundPool = makePool(threadCount(Background));
+
+    switch (lane)
+    {
+    case IO:
+        return *ioPool;
+    case Background:
+        return *backgroundPool;
+    case Interactive:
+    default:
+        return *QThreadPool::globalInstance();
+    }
+}
+
+int TaskScheduler::threadCount(Lane lane)
+{
+    const int cores = qMax(QThread::idealThreadCount(), 1);
+
+    switch (lane)
+    {
+    case IO:
+        return qMax(cores, (int)MIN_IO_THREADS);
+    case Background:
+        return qMax(cores / 2, 1);
+    case Interactive:
+    default:
+        return QThreadPool::globalInstance()->maxThreadCount();
+    }
+}
+
+class TaskGroup::Task : public QRunnable
+{
+public:
+    Task(TaskGroup& group, std::function<void()> function)
+        : _group(group), _function(function)
+    {
+    }
+    virtual ~Task() = default;
+
+    void run() override
+    {
+        {
+            const QMutexLocker lock(&_group._mutex);
+            _group._queued.remove(this);
+        }
+
+        _function();
+
+        // The group may be destroyed as soon as this is done, so it is the
+        // last use of it.
+        const QMutexLocker lock(&_group._mutex);
+        --_group._pending;
+        _group._finished.wakeAll();
+    }
+
+private:
+    TaskGroup& _group;
+    const std::function<void()> _function;
+};
+
+TaskGroup::~TaskGroup()
+{
+    clear();
+    waitForDone();
+}
+
+void TaskGroup::start(std::function<void()> function, int priority)
+{
+    Task* task = new Task(*this, function);
+    {
+        const QMutexLocker lock(&_mutex);
+        _queued.insert(task);
+        ++_pending;
+    }
+    TaskScheduler::pool(_lane).start(task, priority);
+}
+
+void TaskGroup::clear()
+{
+    const QMutexLocker lock(&_mutex);
+
+    QThreadPool& pool = TaskScheduler::pool(_lane);
+    for (Task* task : qAsConst(_queued))
+    {
+        // A task that can't be taken has just been started, and removes
+        // itself from the queue once it gets the lock.
+        if (pool.tryTake(task))
+        {
+            delete task;
+            --_pending;
+        }
+    }
+    _queued.clear();
+
+    _finished.wakeAll();
+}
+
+void TaskGroup::waitForDone()
+{
+    const QMutexLocker lock(&_mutex);
+    while (_pending > 0)
+        _finished.wait(&_mutex);
+}
@@ -0,0 +1,134 @@
+/**
+ * Addle source code
+ * @file
+ * @copyright Copyright 2020 Eleanor Hawk
+ * @copyright Modification and distribution permitted under the terms of the
+ * MIT License. See "LICENSE" for full details.
+ */
+
+#ifndef TASKSCHEDULER_HPP
+#define TASKSCHEDULER_HPP
+
+#include "compat.hpp"
+
+#include <functional>
+#include <type_traits>
+
+#include <QObject>
+#include <QPointer>
+#include <QMutex>
+#include <QSet>
+#include <QWaitCondition>
+#include <QThreadPool>
+#include <QFuture>
+#include <QFutureWatcher>
+#include <QtConcurrent>
+
+namespace Addle {
+
+/**
+ * Distributes asynchronous work among thread pools ("lanes") by priority, so
+ * that long-running work cannot take every thread from work the user is
+ * waiting on.
+ *
+ * Continuations are run on the thread of a context object (usually the GUI
+ * thread) once a future finishes, and are dropped if the context is destroyed
+ * first. Blocking waits and cancellation are those of QFuture, or of
+ * AsyncTask for tasks that report progress or can be cancelled.
+ */
+class ADDLE_COMMON_EXPORT TaskScheduler
+{
+public:
+    enum Lane
+    {
+        // Short work that the user is waiting on, e.g., rendering and tile
+        // decoding. This is Qt's global thread pool, which is also used by
+        // QtConcurrent's map and filter functions.
+        Interactive,
+
+        // Loading and saving documents.
+        IO,
+
+        // Speculative or deferred work, e.g., compression and thumbnails.
+        Background
+    };
+
+    TaskScheduler() = delete;
+
+    static QThreadPool& pool(Lane lane);
+
+    // Runs `function` in `lane`, returning a future of its result.
+    template<typename Function>
+    static auto run(Lane lane, Function function) -> QFuture<decltype(function())>
+    {
+        return QtConcurrent::run(&pool(lane), function);
+    }
+
+    // Calls `continuation` with `future` on the thread of `context`, once the
+    // future has finished. Nothing is called if `context` is destroyed first.
+    // May be called from any thread.
+    template<typename T, typename Continuation>
+    static void then(const QFuture<T>& future, QObject* context, Continuation continuation)
+    {
+        // The watcher cannot be made a child of a context on another thread,
+        // so it is moved to the context's thread and deleted alongside it.
+        auto watcher = new QFutureWatcher<T>;
+        QObject::connect(watcher, &QFutureWatcherBase::finished, context,
+            [watcher, continuation]() {
+                continuation(watcher->future());
+                watcher->deleteLater();
+            }
+        );
+        QObject::connect(context, &QObject::destroyed, watcher, &QObject::deleteLater);
+        watcher->moveToThread(context->thread());
+        watcher->setFuture(future);
+    }
+
+    // The IO lane has a thread for each core (and at least MIN_IO_THREADS),
+    // so that loads which have been superseded, and are still winding down,
+    // do not hold up the latest one. The Background lane has half as many.
+    static int threadCount(Lane lane);
+
+    static constexpr int MIN_IO_THREADS = 2;
+};
+
+/**
+ * Tasks started in a lane of TaskScheduler on behalf of one owner, which can
+ * be cleared and waited on without affecting the lane's other work.
+ *
+ * The group is cleared and waited on when it is destroyed, so tasks may refer
+ * to an owner that holds the group as a member.
+ */
+class ADDLE_COMMON_EXPORT TaskGroup
+{
+public:
+    explicit TaskGroup(TaskScheduler::Lane lane) : _lane(lane) {}
+    ~TaskGroup();
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    // Starts `function` in the group's lane. Tasks of higher priority are
+    // started first.
+    void start(std::function<void()> function, int priority = 0);
+
+    // Removes tasks that have not yet started from the lane.
+    void clear();
+
+    // Waits for every task that has not been cleared to finish.
+    void waitForDone();
+
+private:
+    class Task;
+
+    const TaskScheduler::Lane _lane;
+
+    QMutex _mutex;
+    QWaitCondition _finished;
+    QSet<Task*> _queued;
+    int _pending = 0;
+};
+
+} // namespace Addle
+
+#endif // TASKSCHEDULER_HPP
@@ -14,6 +14,7 @@
 #include <QPen>
 #include <QtDebug>
 #include "utils.hpp"
+#include "utilities/image/tilepool.hpp"
 
 #include <QColor>
 using namespace Addle;
@@ -83,7 +84,7 @@ void PathBrushEngine::paint(BrushStroke& brushStroke) const
             auto bitReader = brushStroke.buffer()->bitReader(bound);
             alphaBound = bitReader.area();
 
-            destAlpha = QImage(alphaBound.size(), QImage::Format_Alpha8);
+            destAlpha = TilePool::image(alphaBound.size(), QImage::Format_Alpha8);
             destAlpha.fill(Qt::transparent);
 
             for (int line = 0; line < alphaBound.height(); line++)
@@ -109,7 +110,7 @@ void PathBrushEngine::paint(BrushStroke& brushStroke) const
                 ? QPainter::CompositionMode_DestinationOut
                 : QPainter::CompositionMode_Source);
 
-            sourceAlpha = QImage(alphaBound.size(), QImage::Format_Alpha8);
+            sourceAlpha = TilePool::image(alphaBound.size(), QImage::Format_Alpha8);
             sourceAlpha.fill(Qt::transparent);
 
             QPainter alphaPainter(&sourceAlpha);
@@ -39,7 +39,7 @@ QPainterPath RasterBrushEngine::indicatorShape(const BrushStroke& painter) const
 
 void RasterBrushEngine::paint(BrushStroke& brushStroke) const
 {
-    RasterEngineParams params(ServiceLocator::get<IBrush>(brushStroke.id()));
+    RasterEngineParams params(brushStroke.brush());
 
     QPointF pos = brushStroke.positions().last();
     double size = brushStroke.size();
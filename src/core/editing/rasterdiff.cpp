@@ -9,9 +9,13 @@
 #include "rasterdiff.hpp"
 #include <cstring>
 
+#include <QVector>
+
 #include "interfaces/editing/irastersurface.hpp"
 #include "interfaces/rendering/irenderstack.hpp"
 
+#include "utilities/parallel.hpp"
+#include "utilities/image/pixelkernels.hpp"
 #include "utilities/render/renderutils.hpp"
 
 #include "servicelocator.hpp"
@@ -55,23 +59,22 @@ void RasterDiff::initialize(
         const int readerWidth = surfaceReader.area().width() * PIXEL_DEPTH;
         const int fullWidth = _area.width() * PIXEL_DEPTH;
 
-        int line = 0;
-
-        while (line < height)
-        {
-            int column = 0;
-
-            uchar* merged = reinterpret_cast<uchar*>(_uncompressed.data()) + (fullWidth * (line + padTop)) + padLeft;
-            const uchar* surface = surfaceReader.scanLine(line);
-
-            while (column < readerWidth)
-            {
-                *merged++ ^= *surface++;
-                column++;
-            }
-
-            line++;
-        }
+        // Scan lines are looked up on this thread, since the bit reader's
+        // image may not be accessed from several threads at once.
+        QVector<const uchar*> surfaceLines(height);
+        for (int line = 0; line < height; ++line)
+            surfaceLines[line] = surfaceReader.scanLine(line);
+
+        uchar* const mergedBits = reinterpret_cast<uchar*>(_uncompressed.data());
+        const PixelKernels::XorBytes xorBytes = PixelKernels::get().xorBytes;
+
+        parallelFor(0, height, [&](int line) {
+            xorBytes(
+                mergedBits + (fullWidth * (line + padTop)) + padLeft,
+                surfaceLines[line],
+                readerWidth
+            );
+        }, nullptr, LINE_GRAIN);
     }
 }
 
@@ -87,22 +90,15 @@ void RasterDiff::apply()
         const int width = _area.width() * PIXEL_DEPTH;
         const int height = _area.height();
 
-        int line = 0;
-        
-        while (line < height)
-        {
-            int column = 0;
-
-            uchar* surface = writer.scanLine(line);
-            const uchar* diff = reinterpret_cast<const uchar*>(_uncompressed.data()) + (width * line);
+        QVector<uchar*> surfaceLines(height);
+        for (int line = 0; line < height; ++line)
+            surfaceLines[line] = writer.scanLine(line);
 
-            while (column < width)
-            {
-                *surface++ ^= *diff++;
-                column++;
-            }
+        const uchar* const diffBits = reinterpret_cast<const uchar*>(_uncompressed.constData());
+        const PixelKernels::XorBytes xorBytes = PixelKernels::get().xorBytes;
 
-            line++;
-        }
+        parallelFor(0, height, [&](int line) {
+            xorBytes(surfaceLines[line], diffBits + (width * line), width);
+        }, nullptr, LINE_GRAIN);
     }
 }
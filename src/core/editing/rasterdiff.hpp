@@ -37,6 +37,9 @@ public:
 private: 
     static const int PIXEL_DEPTH = 4;
 
+    // Scan lines are XORed in parallel, in runs of this many lines.
+    static const int LINE_GRAIN = 32;
+
     QWeakPointer<IRasterSurface> _destination;
 
     QRect _area;
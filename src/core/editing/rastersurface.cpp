@@ -7,11 +7,37 @@
  */
 
 #include "rastersurface.hpp"
+#include <cmath>
 #include <QtDebug>
+#include <QRegion>
+#include <QVector>
 
+#include <exception>
+
+#include "exceptions/formatexception.hpp"
+#include "utilities/parallel.hpp"
 #include "utilities/render/renderutils.hpp"
+#include "utilities/errors.hpp"
 using namespace Addle;
 
+namespace {
+
+inline int floorDiv(int a, int b)
+{
+    return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+// The range of indices of the tiles intersecting `area`
+inline QRect tileSpan(QRect area, int tileSize)
+{
+    return QRect(
+        QPoint(floorDiv(area.left(), tileSize), floorDiv(area.top(), tileSize)),
+        QPoint(floorDiv(area.right(), tileSize), floorDiv(area.bottom(), tileSize))
+    );
+}
+
+} // namespace
+
 void RasterSurface::initialize(
         QRect area,
         QPainter::CompositionMode compositionMode,
@@ -21,6 +47,8 @@ void RasterSurface::initialize(
     const QWriteLocker lock(&_lock);
     const Initializer init(_initHelper);
 
+    _compositionMode = compositionMode;
+
     if (_area.isValid())
     {
         _buffer = QImage(area.size(), QImage::Format_ARGB32);
@@ -42,10 +70,41 @@ void RasterSurface::initialize(
 
     if (image.format() != QImage::Format_ARGB32)
         image.convertTo(QImage::Format_ARGB32);
+    _compositionMode = compositionMode;
     _buffer = image;
+    _bufferOffset = offset;
     _area = QRect(offset, image.size());
 }
 
+void RasterSurface::initialize(
+        QSharedPointer<RasterTileSource> tileSource,
+        QPainter::CompositionMode compositionMode,
+        InitFlags flags
+    )
+{
+    const QWriteLocker lock(&_lock);
+    const Initializer init(_initHelper);
+
+    ADDLE_ASSERT(tileSource);
+
+    _compositionMode = compositionMode;
+    _tileSource = tileSource;
+    _area = tileSource->area();
+    _bufferOffset = _area.topLeft();
+
+    if (_area.isEmpty()) return;
+
+    // The buffer is allocated by realize() as tiles are decoded, so only the
+    // parts of the surface that are used take up memory.
+    const QRect span = tileSpan(_area, tileSource->tileSize());
+    for (int y = span.top(); y <= span.bottom(); ++y)
+    {
+        for (int x = span.left(); x <= span.right(); ++x)
+            _pendingTiles.insert(QPoint(x, y));
+    }
+    _pendingCount.storeRelease(_pendingTiles.size());
+}
+
 QSharedPointer<IRenderStep> RasterSurface::renderStep()
 {
     const QReadLocker lock(&_lock);
@@ -63,6 +122,19 @@ void RasterSurface::clear()
         const QWriteLocker lock(&_lock);
 
         oldArea = _area;
+        if (_tileSource)
+        {
+            markModified(_tileSource->area().united(oldArea));
+            _pendingTiles.clear();
+            _pendingCount.storeRelease(0);
+
+            const QMutexLocker previewLock(&_previewMutex);
+            _previews.clear();
+        }
+        else
+        {
+            markModified(oldArea);
+        }
         _area = QRect();
     }
 
@@ -73,14 +145,276 @@ void RasterSurface::clear()
     }
 }
 
-// QImage RasterSurface::copy(QRect copyArea) const
-// {
-//     copyArea = copyArea.isValid() ? _area.intersected(copyArea) : _area;
+QImage RasterSurface::copy(QRect copyArea, QPoint* offset) const
+{
+    ASSERT_INIT();
+    realize(copyArea);
+    const QReadLocker lock(&_lock);
+
+    const QRect bufferArea(_bufferOffset, _buffer.size());
+
+    copyArea = copyArea.isValid() ? _area.intersected(copyArea) : _area;
+    copyArea = copyArea.intersected(bufferArea);
+
+    if (offset) *offset = copyArea.topLeft();
+
+    if (copyArea.isEmpty())
+        return QImage();
+    else if (copyArea == bufferArea)
+        return _buffer; // implicitly shared
+    else
+        return _buffer.copy(copyArea.translated(-_bufferOffset));
+}
+
+QSet<QPoint> RasterSurface::modifiedTiles(quint64* generation) const
+{
+    ASSERT_INIT();
+    const QReadLocker lock(&_lock);
+
+    if (generation) *generation = _modificationCounter;
+    return _modifiedTiles.keys().toSet();
+}
+
+void RasterSurface::setTileSource(QSharedPointer<RasterTileSource> tileSource, quint64 cleanGeneration)
+{
+    ASSERT_INIT();
+    const QWriteLocker lock(&_lock);
+
+    const bool sameTiles = tileSource && _tileSource
+        && tileSource->tileSize() == _tileSource->tileSize();
+
+    // Changes made without a tile source of the same tile size can't be told
+    // apart by tile, so if there were any after `cleanGeneration`, the
+    // surface keeps its current source.
+    if (tileSource && !sameTiles && _modificationCounter > cleanGeneration)
+        return;
+
+    if (!sameTiles)
+    {
+        // Tiles of the old source can't be decoded from the new one.
+        realize_p(QRect());
+        _pendingTiles.clear();
+        _pendingCount.storeRelease(0);
+
+        const QMutexLocker previewLock(&_previewMutex);
+        _previews.clear();
+    }
+
+    _tileSource = tileSource;
+
+    for (auto i = _modifiedTiles.begin(); i != _modifiedTiles.end();)
+    {
+        if (!sameTiles || i.value() <= cleanGeneration)
+            i = _modifiedTiles.erase(i);
+        else
+            ++i;
+    }
+}
+
+void RasterSurface::realize(QRect area) const
+{
+    if (_pendingCount.loadAcquire() == 0) return;
+
+    const QWriteLocker lock(&_lock);
+    realize_p(area);
+}
+
+void RasterSurface::realize_p(QRect area) const
+{
+    if (_pendingTiles.isEmpty() || !_tileSource) return;
+
+    area = area.isValid() ? area.intersected(_area) : _area;
+    if (area.isEmpty()) return;
+
+    const int tileSize = _tileSource->tileSize();
+    const QRect span = tileSpan(area, tileSize);
+
+    QList<QPoint> toDecode;
+    if ((qint64)span.width() * span.height() < _pendingTiles.size())
+    {
+        for (int y = span.top(); y <= span.bottom(); ++y)
+        {
+            for (int x = span.left(); x <= span.right(); ++x)
+            {
+                if (_pendingTiles.contains(QPoint(x, y)))
+                    toDecode.append(QPoint(x, y));
+            }
+        }
+    }
+    else
+    {
+        for (const QPoint& index : qAsConst(_pendingTiles))
+        {
+            if (span.contains(index))
+                toDecode.append(index);
+        }
+    }
+
+    if (toDecode.isEmpty()) return;
+
+    // Decoding tiles does not change the logical contents of the surface,
+    // only whether they are present in the buffer.
+    QRect needed;
+    for (const QPoint& index : qAsConst(toDecode))
+        needed |= _tileSource->tileRect(index).intersected(_area);
+    extendBuffer_p(needed);
+
+    uchar* const bufferBits = _buffer.bits();
+    const int bytesPerLine = _buffer.bytesPerLine();
+    const QRect bufferArea(_bufferOffset, _buffer.size());
+    const QSharedPointer<RasterTileSource> tileSource = _tileSource;
+
+    // Set for each tile that was decoded. (Not a QBitArray, as neighboring
+    // bits share a byte and are written from different threads.)
+    QVector<char> decoded(toDecode.size(), false);
+
+    QMutex failureMutex;
+    std::exception_ptr failure;
+
+    // Tiles do not overlap, so each is decoded and copied into the buffer by
+    // whichever thread takes it. A tile that fails does not stop the others.
+    parallelFor(0, toDecode.size(), [&](int i) {
+        const QRect tileRect = tileSource->tileRect(toDecode[i]);
+        const QRect target = tileRect.intersected(bufferArea);
+        if (target.isEmpty())
+        {
+            decoded[i] = true;
+            return;
+        }
+
+        QImage tile;
+        try
+        {
+            tile = tileSource->decodeTile(toDecode[i]);
+        }
+        catch (...)
+        {
+            const QMutexLocker lock(&failureMutex);
+            if (!failure) failure = std::current_exception();
+            return;
+        }
+
+        const int bytes = target.width() * 4;
+        for (int y = target.top(); y <= target.bottom(); ++y)
+        {
+            uchar* dest = bufferBits + (y - _bufferOffset.y()) * bytesPerLine
+                + (target.left() - _bufferOffset.x()) * 4;
+
+            if (tile.isNull())
+            {
+                memset(dest, 0, bytes);
+            }
+            else
+            {
+                const uchar* src = tile.constScanLine(y - tileRect.top())
+                    + (target.left() - tileRect.left()) * 4;
+                memcpy(dest, src, bytes);
+            }
+        }
+        decoded[i] = true;
+    });
+
+    for (int i = 0; i < toDecode.size(); ++i)
+    {
+        if (decoded[i])
+            _pendingTiles.remove(toDecode[i]);
+    }
+
+    _pendingCount.storeRelease(_pendingTiles.size());
+
+    if (_pendingTiles.isEmpty())
+    {
+        const QMutexLocker previewLock(&_previewMutex);
+        _previews.clear();
+    }
+
+    if (failure)
+        std::rethrow_exception(failure);
+}
+
+void RasterSurface::extendBuffer_p(QRect area) const
+{
+    const QRect bufferArea(_bufferOffset, _buffer.size());
+    if (area.isEmpty() || bufferArea.contains(area)) return;
+
+    const QRect newArea = _buffer.isNull() ? area : bufferArea.united(area);
+
+    QImage newBuffer(newArea.size(), QImage::Format_ARGB32);
+    newBuffer.fill(Qt::transparent);
+
+    if (!_buffer.isNull())
+    {
+        QPainter painter(&newBuffer);
+        painter.setCompositionMode(QPainter::CompositionMode_Source);
+        painter.drawImage(bufferArea.topLeft() - newArea.topLeft(), _buffer);
+    }
+
+    _buffer = newBuffer;
+    _bufferOffset = newArea.topLeft();
+}
+
+QRegion RasterSurface::pendingRegion_p(QRect area) const
+{
+    QRegion result;
+    if (!_tileSource || _pendingTiles.isEmpty()) return result;
+
+    const QRect span = tileSpan(area, _tileSource->tileSize());
+    for (const QPoint& index : qAsConst(_pendingTiles))
+    {
+        if (span.contains(index))
+            result += _tileSource->tileRect(index).intersected(area);
+    }
+    return result;
+}
+
+QImage RasterSurface::preview(QRect area, double scale, QRegion& pending, QRect& previewArea) const
+{
+    if (_pendingCount.loadAcquire() == 0 || scale <= 0 || scale >= 0.5)
+        return QImage();
+
+    const QReadLocker lock(&_lock);
+    if (!_tileSource) return QImage();
+
+    area = area.intersected(_area);
+    if (area.isEmpty()) return QImage();
+
+    pending = pendingRegion_p(area);
+    if (pending.isEmpty()) return QImage();
+
+    previewArea = _tileSource->area();
+    const int level = qMin((int)std::floor(std::log2(1.0 / scale)), MAX_PREVIEW_LEVEL);
+
+    const QMutexLocker previewLock(&_previewMutex);
+    auto i = _previews.find(level);
+    if (i == _previews.end())
+    {
+        // A null preview is cached as well, so that an unsupported request
+        // is not repeated.
+        const QSize size(
+            qMax(1, previewArea.width() >> level),
+            qMax(1, previewArea.height() >> level)
+        );
+        i = _previews.insert(level, _tileSource->preview(size));
+    }
+    return *i;
+}
+
+void RasterSurface::markModified(QRect area)
+{
+    if (area.isEmpty()) return;
 
-//     QImage result = _buffer.copy(copyArea.translated(-_bufferOffset));
-//     result.setOffset(copyArea.topLeft());
-//     return result;
-// }
+    // Counted even without a tile source, so that setTileSource can tell
+    // whether the surface has changed since a given generation.
+    ++_modificationCounter;
+    if (!_tileSource) return;
+
+    const QRect span = tileSpan(area, _tileSource->tileSize());
+    for (int y = span.top(); y <= span.bottom(); ++y)
+    {
+        for (int x = span.left(); x <= span.right(); ++x)
+            _modifiedTiles[QPoint(x, y)] = _modificationCounter;
+    }
+}
 
 void RasterSurface::allocate(QRect allocArea)
 {
@@ -165,6 +499,7 @@ void RasterSurface::copyLinked()
 
 void RasterSurface::onPaintHandleDestroyed(const RasterPaintHandle& handle)
 {
+    markModified(handle.area());
     _lock.unlock();
 
     {
@@ -185,6 +520,7 @@ void RasterSurface::onBitReaderDestroyed(const RasterBitReader& reader) const
 
 void RasterSurface::onBitWriterDestroyed(const RasterBitWriter& writer)
 {
+    markModified(writer.area());
     _lock.unlock();
 
     {
@@ -200,44 +536,106 @@ void RasterSurface::onBitWriterDestroyed(const RasterBitWriter& writer)
 
 void RasterSurfaceRenderStep::onPush(RenderData& data)
 {
-    // if _owner's composition mode is CompositionMode_Source, then add a mask
-    // to RenderData covering _owner._area
+    const QReadLocker lock(&_owner._lock);
 
-    if (!_owner._area.isValid()) return;
+    if (!_owner._area.isValid() || !_owner._replaceMode) return;
 
-    if (_owner._replaceMode)
-    {
-        QPainterPath p1;
-        p1.addRect(data.area());
+    // In replace mode, this surface stands in for the steps beneath it within
+    // its area. Those steps are excluded from the area by a clip region made
+    // only of rects, which QPainter applies as a rectangular coverage mask
+    // rather than by rasterizing an arbitrary path.
 
-        QPainterPath p2;
-        p2.addRect(_owner._area);
+    const QRect covered = _owner._area.intersected(data.area());
+    if (covered.isEmpty()) return;
 
-        data.painter()->setClipPath(p1.subtracted(p2), Qt::IntersectClip);
-    }
+    data.painter()->setClipRegion(
+        QRegion(data.area()).subtracted(QRegion(covered)),
+        Qt::IntersectClip
+    );
 }
 
 void RasterSurfaceRenderStep::onPop(RenderData& data)
 {
+    // While zoomed out, parts of the surface that have not been decoded yet
+    // are drawn from a reduced-resolution preview rather than decoded.
+    const double scale = std::sqrt(qAbs(data.painter()->deviceTransform().determinant()));
+
+    QRegion pending;
+    QRect previewArea;
+    const QImage preview = _owner.preview(data.area(), scale, pending, previewArea);
+    if (preview.isNull())
+    {
+        try
+        {
+            _owner.realize(data.area());
+        }
+        catch (const FormatException&)
+        {
+            // Tiles that failed to decode are left out of the drawing. They
+            // stay pending, so the failure is reported to the next access
+            // that needs their contents, e.g., saving the document.
+        }
+    }
+
     const QReadLocker lock(&_owner._lock);
 
     if (!_owner._area.isValid()) return;
 
     QRect intersection = _owner._area.intersected(data.area());
+    if (intersection.isEmpty()) return;
+
+    // Only what has been decoded into the buffer is drawn from it.
+    const QRect bufferArea(_owner._bufferOffset, _owner._buffer.size());
+    const QRegion fromBuffer = QRegion(intersection.intersected(bufferArea))
+        .subtracted(_owner.pendingRegion_p(intersection));
 
     data.painter()->setCompositionMode(_owner._compositionMode);
     data.painter()->setOpacity((double)_owner._alpha / 0xFF);
 
     if (_owner._replaceMode)
     {
-        QPainterPath p = data.painter()->clipPath();
-        p.addRect(_owner._area);
-        data.painter()->setClipPath(p.simplified(), Qt::ReplaceClip);
+        // Lift the exclusion installed in onPush. Drawing is confined to
+        // `intersection` regardless, which lies within the render area.
+        data.painter()->setClipRect(intersection, Qt::ReplaceClip);
     }
 
-    data.painter()->drawImage(
-        intersection, 
-        _owner._buffer,
-        intersection.translated(-_owner._bufferOffset)
-    );
+    if (preview.isNull())
+    {
+        for (QRect rect : fromBuffer)
+        {
+            data.painter()->drawImage(
+                rect,
+                _owner._buffer,
+                rect.translated(-_owner._bufferOffset)
+            );
+        }
+        return;
+    }
+
+    const double scaleX = (double)preview.width() / previewArea.width();
+    const double scaleY = (double)preview.height() / previewArea.height();
+
+    pending &= intersection;
+    for (QRect rect : pending)
+    {
+        data.painter()->drawImage(
+            QRectF(rect),
+            preview,
+            QRectF(
+                (rect.left() - previewArea.left()) * scaleX,
+                (rect.top() - previewArea.top()) * scaleY,
+                rect.width() * scaleX,
+                rect.height() * scaleY
+            )
+        );
+    }
+
+    for (QRect rect : fromBuffer.subtracted(pending))
+    {
+        data.painter()->drawImage(
+            rect,
+            _owner._buffer,
+            rect.translated(-_owner._bufferOffset)
+        );
+    }
 }
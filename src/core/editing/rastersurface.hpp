@@ -15,6 +15,11 @@
 #include "utilities/initializehelper.hpp"
 #include <QObject>
 #include <QReadWriteLock>
+#include <QAtomicInt>
+#include <QMutex>
+#include <QHash>
+#include <QSet>
+#include <QRegion>
 namespace Addle {
 
 class RasterSurfaceRenderStep;
@@ -36,6 +41,11 @@ public:
         QPainter::CompositionMode compositionMode = QPainter::CompositionMode_SourceOver,
         InitFlags flags = None
     ) override;
+    void initialize(
+        QSharedPointer<RasterTileSource> tileSource,
+        QPainter::CompositionMode compositionMode = QPainter::CompositionMode_SourceOver,
+        InitFlags flags = None
+    ) override;
 
     virtual void setCompositionMode(QPainter::CompositionMode mode) override
     {
@@ -74,6 +84,18 @@ public:
 
     void clear() override;
 
+    QImage copy(QRect copyArea = QRect(), QPoint* offset = nullptr) const override;
+
+    QSharedPointer<RasterTileSource> tileSource() const override
+    {
+        ASSERT_INIT();
+        const QReadLocker lock(&_lock);
+        return _tileSource;
+    }
+
+    QSet<QPoint> modifiedTiles(quint64* generation = nullptr) const override;
+    void setTileSource(QSharedPointer<RasterTileSource> tileSource, quint64 cleanGeneration) override;
+
     int alpha() const { ASSERT_INIT(); return _alpha; }
     void setAlpha(int alpha) { ASSERT_INIT(); _alpha = alpha; emit changed(_area); }
 
@@ -83,12 +105,22 @@ public:
     {
         _lock.lockForWrite(); //unlock in onPaintHandleDestroyed
 
-        allocate(handleArea);
+        try
+        {
+            allocate(handleArea);
+            realize_p(handleArea);
+        }
+        catch (...)
+        {
+            _lock.unlock();
+            throw;
+        }
         return paintHandle_p(_buffer, _bufferOffset, handleArea);
     }
 
     RasterBitReader bitReader(QRect area) const override
     {
+        realize(area);
         _lock.lockForRead(); //unlock in onBitReaderDestroyed
 
         QRect readerArea = QRect(_bufferOffset, _buffer.size()).intersected(area);
@@ -99,7 +131,16 @@ public:
     {
         _lock.lockForWrite(); //unlock in onBitReaderDestroyed
 
-        allocate(area);
+        try
+        {
+            allocate(area);
+            realize_p(area);
+        }
+        catch (...)
+        {
+            _lock.unlock();
+            throw;
+        }
         return bitWriter_p(_buffer, _bufferOffset, area);
     }
 
@@ -115,8 +156,37 @@ private:
     void allocate(QRect allocArea);
     void copyLinked();
 
+    // Decodes any tiles of the tile source in `area` (or the whole surface if
+    // area is null) that have not yet been decoded. realize_p expects the
+    // write lock to already be held.
+    //
+    // Tiles that fail to decode are left pending, and the failure is thrown
+    // (as FormatException) once the others have been decoded. It is thrown
+    // again by each later attempt to access those tiles.
+    void realize(QRect area) const;
+    void realize_p(QRect area) const;
+
+    // Grows the buffer to cover `area`, without changing the area of the
+    // surface. Expects the write lock to already be held.
+    void extendBuffer_p(QRect area) const;
+
+    // The parts of `area` covered by tiles that have not been decoded.
+    // Expects the lock to already be held.
+    QRegion pendingRegion_p(QRect area) const;
+
+    // If tiles in `area` have not yet been decoded and the tile source can
+    // provide a preview fit for drawing at `scale` device pixels per surface
+    // pixel, returns the preview. `pending` receives the parts of `area` that
+    // should be drawn from it, and `previewArea` the area it covers.
+    QImage preview(QRect area, double scale, QRegion& pending, QRect& previewArea) const;
+
+    void markModified(QRect area);
+
     const int CHUNK_SIZE = 64;
 
+    // Previews are decoded at 1/2^n scale, up to this n.
+    static constexpr int MAX_PREVIEW_LEVEL = 6;
+
     mutable QReadWriteLock _lock;
     
     QSharedPointer<IRasterSurface> _linked;
@@ -126,8 +196,26 @@ private:
     int _alpha = 0xFF;
     bool _replaceMode = false;
 
-    QImage _buffer;
-    QPoint _bufferOffset;
+    // The buffer may cover less than the area of the surface. Anything
+    // outside it is transparent, apart from tiles that have not been decoded
+    // yet. It is mutable so tiles can be decoded into it on const access.
+    mutable QImage _buffer;
+    mutable QPoint _bufferOffset;
+
+    QSharedPointer<RasterTileSource> _tileSource;
+
+    // Tiles of the tile source not yet decoded into the buffer. The count is
+    // kept separately so it can be checked without locking.
+    mutable QSet<QPoint> _pendingTiles;
+    mutable QAtomicInt _pendingCount;
+
+    // Previews of the tile source by level, discarded once every tile has
+    // been decoded.
+    mutable QMutex _previewMutex;
+    mutable QHash<int, QImage> _previews;
+
+    QHash<QPoint, quint64> _modifiedTiles;
+    quint64 _modificationCounter = 0;
 
     QRect _area;
 
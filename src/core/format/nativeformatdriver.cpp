@@ -0,0 +1,722 @@
+/**
+ * Addle source code
+ * @file
+ * @copyright Copyright 2020 Eleanor Hawk
+ * @copyright Modification and distribution permitted under the terms of the
+ * MIT License. See "LICENSE" for full details.
+ */
+
+#include "nativeformatdriver.hpp"
+
+#include "interfaces/models/ilayer.hpp"
+#include "interfaces/editing/irastersurface.hpp"
+#include "servicelocator.hpp"
+
+#include "exceptions/formatexception.hpp"
+#include "exceptions/fileexception.hpp"
+#include "utilities/errors.hpp"
+#include "utilities/iocheck.hpp"
+#include "utilities/hashfunctions.hpp"
+#include "utilities/model/documentsnapshot.hpp"
+
+#include <cstring>
+
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QScopedPointer>
+#include <QPainter>
+#include <QDataStream>
+#include <QtEndian>
+#include <QtConcurrent>
+
+using namespace Addle;
+
+namespace {
+
+struct TileRecord
+{
+    quint64 offset = 0;
+    quint32 length = 0;
+};
+
+// Whether the record lies within `size` bytes, without overflowing.
+inline bool fitsIn(TileRecord record, quint64 size)
+{
+    return record.offset <= size && record.length <= size - record.offset;
+}
+
+inline int floorDiv(int a, int b)
+{
+    return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+// The indices of the tiles that cover `area`.
+inline QRect tileSpan(QRect area, int tileSize)
+{
+    return QRect(
+        QPoint(floorDiv(area.left(), tileSize), floorDiv(area.top(), tileSize)),
+        QPoint(floorDiv(area.right(), tileSize), floorDiv(area.bottom(), tileSize))
+    );
+}
+
+// Pixels are stored as little-endian ARGB32, compressed with zlib.
+QByteArray compressImage(QImage image)
+{
+#if Q_BYTE_ORDER == Q_BIG_ENDIAN
+    quint32* pixels = reinterpret_cast<quint32*>(image.bits());
+    for (int i = 0; i < image.width() * image.height(); ++i)
+        pixels[i] = qToLittleEndian(pixels[i]);
+#endif
+
+    return qCompress(image.constBits(), (int)image.sizeInBytes(), NativeFormatDriver::COMPRESSION_LEVEL);
+}
+
+QImage uncompressImage(const QByteArray& blob, QSize size)
+{
+    if (size.isEmpty()) return QImage();
+
+    const QByteArray raw = qUncompress(blob);
+    if ((qint64)raw.size() != (qint64)size.width() * size.height() * 4) return QImage();
+
+    QImage image(size, QImage::Format_ARGB32);
+    if (image.isNull()) return QImage();
+    std::memcpy(image.bits(), raw.constData(), raw.size());
+
+#if Q_BYTE_ORDER == Q_BIG_ENDIAN
+    quint32* pixels = reinterpret_cast<quint32*>(image.bits());
+    for (int i = 0; i < size.width() * size.height(); ++i)
+        pixels[i] = qFromLittleEndian(pixels[i]);
+#endif
+    return image;
+}
+
+// A read-only view of a document file, memory-mapped if possible.
+class NativeDocumentFile
+{
+public:
+    NativeDocumentFile(const QString& filename, QIODevice* fallback = nullptr)
+        : _file(filename)
+    {
+        if (!filename.isEmpty() && _file.open(QIODevice::ReadOnly))
+            _map = _file.map(0, _file.size());
+
+        if (_map)
+        {
+            _data = QByteArray::fromRawData(reinterpret_cast<const char*>(_map), _file.size());
+        }
+        else if (fallback)
+        {
+            // The file could not be mapped (or there is no file, e.g., for a
+            // pipe), so it is read into memory. The data outlives the device,
+            // so it is copied.
+            if (!fallback->isSequential())
+                IOCheck().seek(*fallback, 0);
+            _data = IOCheck().readAll(*fallback);
+        }
+    }
+
+    ~NativeDocumentFile()
+    {
+        if (_map) _file.unmap(_map);
+    }
+
+    QString filename() const { return _file.fileName(); }
+
+    // Does not copy the file's contents.
+    const QByteArray& data() const { return _data; }
+
+    QByteArray blob(TileRecord record) const
+    {
+        return QByteArray::fromRawData(_data.constData() + record.offset, record.length);
+    }
+
+private:
+    QFile _file;
+    uchar* _map = nullptr;
+    QByteArray _data;
+};
+
+class NativeTileSource : public RasterTileSource
+{
+public:
+    NativeTileSource(QSharedPointer<NativeDocumentFile> file,
+            int tileSize,
+            QRect area,
+            QHash<QPoint, TileRecord> records,
+            QSize previewSize = QSize(),
+            TileRecord previewRecord = TileRecord())
+        : _file(file),
+        _tileSize(tileSize),
+        _area(area),
+        _records(records),
+        _previewSize(previewSize),
+        _previewRecord(previewRecord)
+    {
+    }
+    virtual ~NativeTileSource() = default;
+
+    int tileSize() const override { return _tileSize; }
+    QRect area() const override { return _area; }
+    QList<QPoint> tiles() const override { return _records.keys(); }
+
+    QImage decodeTile(QPoint index) const override
+    {
+        if (!_records.contains(index)) return QImage();
+
+        const QImage tile = uncompressImage(_file->blob(_records.value(index)), QSize(_tileSize, _tileSize));
+        if (tile.isNull())
+            ADDLE_THROW(FormatException(FormatException::DecodingFailed, CoreFormats::Native));
+
+        return tile;
+    }
+
+    QImage preview(QSize size) const override
+    {
+        const QImage stored = storedPreview();
+        if (stored.isNull() || _area.isEmpty()) return QImage();
+
+        // The stored preview covers whole tiles, so it is cropped to the area.
+        const int factor = 1 << NativeFormatDriver::PREVIEW_LEVEL;
+        const QPoint origin = tileSpan(_area, _tileSize).topLeft() * _tileSize;
+        const QRect crop = QRect(
+            (_area.left() - origin.x()) / factor,
+            (_area.top() - origin.y()) / factor,
+            (_area.width() + factor - 1) / factor,
+            (_area.height() + factor - 1) / factor
+        ).intersected(stored.rect());
+
+        const QImage result = stored.copy(crop);
+
+        // As with QtImageTileSource, a preview that is smaller than requested
+        // is returned as-is, as it is drawn scaled anyway.
+        const QSize fitted = _area.size().scaled(size, Qt::KeepAspectRatio);
+        if (fitted.width() < result.width() && fitted.height() < result.height())
+            return result.scaled(fitted, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+        else
+            return result;
+    }
+
+    // The preview as it is stored, covering every tile of the area at
+    // 1/2^PREVIEW_LEVEL scale.
+    QImage storedPreview() const
+    {
+        if (!_file || !_previewRecord.length) return QImage();
+
+        return uncompressImage(_file->blob(_previewRecord), _previewSize);
+    }
+
+    const QSharedPointer<NativeDocumentFile>& file() const { return _file; }
+    const QHash<QPoint, TileRecord>& records() const { return _records; }
+
+private:
+    const QSharedPointer<NativeDocumentFile> _file;
+    const int _tileSize;
+    const QRect _area;
+    const QHash<QPoint, TileRecord> _records;
+
+    const QSize _previewSize;
+    const TileRecord _previewRecord;
+};
+
+struct EncodeJob
+{
+    QImage image;
+    QPoint offset;
+    QPoint index;
+};
+
+struct EncodedTile
+{
+    // Empty for tiles that are fully transparent.
+    QByteArray blob;
+
+    // The tile at the scale of the layer's preview.
+    QImage reduced;
+};
+
+struct TileEncoder
+{
+    typedef EncodedTile result_type;
+
+    EncodedTile operator()(const EncodeJob& job) const
+    {
+        const int tileSize = NativeFormatDriver::TILE_SIZE;
+        const QRect tileRect(job.index * tileSize, QSize(tileSize, tileSize));
+
+        const QRect part = tileRect.intersected(QRect(job.offset, job.image.size()));
+        if (part.isEmpty()) return EncodedTile();
+
+        QImage tile(tileSize, tileSize, QImage::Format_ARGB32);
+        tile.fill(Qt::transparent);
+
+        bool empty = true;
+        for (int y = part.top(); y <= part.bottom(); ++y)
+        {
+            const QRgb* src = reinterpret_cast<const QRgb*>(job.image.constScanLine(y - job.offset.y()))
+                + (part.left() - job.offset.x());
+            QRgb* dest = reinterpret_cast<QRgb*>(tile.scanLine(y - tileRect.top()))
+                + (part.left() - tileRect.left());
+            for (int x = 0; x < part.width(); ++x)
+            {
+                dest[x] = src[x];
+                if (qAlpha(src[x])) empty = false;
+            }
+        }
+
+        if (empty) return EncodedTile();
+
+        const int reducedSize = tileSize >> NativeFormatDriver::PREVIEW_LEVEL;
+
+        EncodedTile result;
+        result.reduced = tile.scaled(reducedSize, reducedSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+        result.blob = compressImage(tile);
+        return result;
+    }
+};
+
+struct LayerPlan
+{
+    QSharedPointer<IRasterSurface> surface;
+    QSharedPointer<NativeTileSource> source;
+
+    QImage image;
+    QPoint offset;
+
+    quint64 generation = 0;
+    QRect area;
+
+    QString name;
+    double opacity;
+    QPainter::CompositionMode compositionMode;
+    QList<int> groupPath;
+
+    // Clean tiles that are already in the destination file
+    QHash<QPoint, TileRecord> kept;
+
+    // Clean tiles to copy, still compressed, from another file
+    QList<QPoint> copied;
+
+    // Modified or new tiles, to be encoded from the image
+    QList<QPoint> encoded;
+
+    QHash<QPoint, TileRecord> records;
+
+    QSize previewSize;
+    TileRecord previewRecord;
+};
+
+QByteArray writeHeader(quint64 indexOffset, quint64 indexLength)
+{
+    QByteArray header;
+    QDataStream stream(&header, QIODevice::WriteOnly);
+
+    const QByteArray signature = CoreFormats::Native.fileSignature();
+    stream.writeRawData(signature.constData(), signature.size());
+    stream << NativeFormatDriver::FORMAT_VERSION
+        << (quint32)NativeFormatDriver::TILE_SIZE
+        << indexOffset
+        << indexLength;
+
+    return header;
+}
+
+} // namespace
+
+IDocument* NativeFormatDriver::importModel(QIODevice& device, DocumentImportExportInfo info)
+{
+    const auto file = QSharedPointer<NativeDocumentFile>(new NativeDocumentFile(info.filename(), &device));
+    const QByteArray& data = file->data();
+
+    const auto notRecognized = [&]() {
+        return FormatException(FormatException::FormatNotRecognized, CoreFormats::Native, info);
+    };
+
+    const QByteArray signature = CoreFormats::Native.fileSignature();
+    if (data.size() < HEADER_SIZE || !data.startsWith(signature))
+        ADDLE_THROW(notRecognized());
+
+    quint32 version;
+    quint32 tileSize;
+    quint64 indexOffset;
+    quint64 indexLength;
+    {
+        QDataStream header(QByteArray::fromRawData(data.constData(), HEADER_SIZE));
+        header.skipRawData(signature.size());
+        header >> version >> tileSize >> indexOffset >> indexLength;
+    }
+
+    if (version != FORMAT_VERSION
+        || tileSize < (1u << PREVIEW_LEVEL)
+        || tileSize > (quint32)MAX_TILE_SIZE
+        || (tileSize & (tileSize - 1)) != 0
+        || indexOffset < (quint64)HEADER_SIZE
+        || indexOffset > (quint64)data.size()
+        || indexLength > (quint64)data.size() - indexOffset)
+        ADDLE_THROW(notRecognized());
+
+    DocumentBuilder documentBuilder;
+    documentBuilder.setFilename(info.filename());
+
+    QDataStream index(QByteArray::fromRawData(data.constData() + indexOffset, indexLength));
+    index.setVersion(QDataStream::Qt_5_6);
+
+    QSize size;
+    QColor backgroundColor;
+    index >> size >> backgroundColor;
+    documentBuilder.setSize(size);
+    documentBuilder.setBackgroundColor(backgroundColor);
+
+    quint32 groupCount;
+    index >> groupCount;
+    for (quint32 i = 0; i < groupCount && index.status() == QDataStream::Ok; ++i)
+    {
+        QString name;
+        index >> name;
+        documentBuilder.addLayerGroup(LayerGroupInfo(name));
+    }
+
+    quint32 layerCount;
+    index >> layerCount;
+    for (quint32 i = 0; i < layerCount && index.status() == QDataStream::Ok; ++i)
+    {
+        info.checkCancelled();
+
+        QString name;
+        double opacity;
+        qint32 compositionMode;
+        QList<int> groupPath;
+        QRect area;
+        quint32 tileCount;
+        index >> name >> opacity >> compositionMode >> groupPath >> area >> tileCount;
+
+        QHash<QPoint, TileRecord> records;
+        for (quint32 j = 0; j < tileCount && index.status() == QDataStream::Ok; ++j)
+        {
+            QPoint tileIndex;
+            TileRecord record;
+            index >> tileIndex >> record.offset >> record.length;
+
+            if (!fitsIn(record, data.size()))
+                ADDLE_THROW(notRecognized());
+
+            records.insert(tileIndex, record);
+        }
+
+        QSize previewSize;
+        TileRecord previewRecord;
+        index >> previewSize >> previewRecord.offset >> previewRecord.length;
+        if (!fitsIn(previewRecord, data.size()))
+            ADDLE_THROW(notRecognized());
+
+        LayerBuilder layerBuilder;
+        layerBuilder.setName(name);
+        layerBuilder.setOpacity(opacity);
+        layerBuilder.setCompositionMode((QPainter::CompositionMode)compositionMode);
+        layerBuilder.setGroupPath(groupPath);
+        layerBuilder.setBoundary(area);
+        layerBuilder.setTileSource(QSharedPointer<RasterTileSource>(
+            new NativeTileSource(file, tileSize, area, records, previewSize, previewRecord)
+        ));
+
+        documentBuilder.addLayer(layerBuilder);
+    }
+
+    if (index.status() != QDataStream::Ok)
+        ADDLE_THROW(notRecognized());
+
+    info.reportProgress(1.0);
+
+    return ServiceLocator::make<IDocument>(documentBuilder);
+}
+
+void NativeFormatDriver::exportModel(IDocument* model, QIODevice& device, DocumentImportExportInfo info)
+{
+    const QSharedPointer<const DocumentSnapshot> snapshot = DocumentSnapshot::forExport(model, info);
+
+    const QString destination = QFileInfo(info.filename()).canonicalFilePath();
+
+    QList<LayerPlan> plans;
+    bool inPlace = !snapshot->layers().isEmpty();
+    qint64 keptBytes = 0;
+
+    for (const DocumentSnapshot::Layer& layer : snapshot->layers())
+    {
+        LayerPlan plan;
+        plan.surface = layer.surface;
+        plan.image = layer.image.convertToFormat(QImage::Format_ARGB32);
+        plan.offset = layer.offset;
+        plan.area = plan.image.isNull() ? QRect() : QRect(plan.offset, plan.image.size());
+        plan.generation = layer.generation;
+        plan.name = layer.name;
+        plan.opacity = layer.opacity;
+        plan.compositionMode = layer.compositionMode;
+        plan.groupPath = layer.groupPath;
+
+        // Only tiles of a source of the same tile size can be reused.
+        plan.source = layer.tileSource.dynamicCast<NativeTileSource>();
+        if (plan.source && (!plan.source->file() || plan.source->tileSize() != TILE_SIZE))
+            plan.source.clear();
+
+        if (!plan.source
+            || QFileInfo(plan.source->file()->filename()).canonicalFilePath() != destination)
+        {
+            inPlace = false;
+        }
+
+        if (plan.source)
+        {
+            const auto& records = plan.source->records();
+            for (auto i = records.cbegin(); i != records.cend(); ++i)
+            {
+                if (!layer.modifiedTiles.contains(i.key()))
+                {
+                    plan.kept.insert(i.key(), i.value());
+                    keptBytes += i.value().length;
+                }
+            }
+            plan.encoded = layer.modifiedTiles.toList();
+        }
+        else if (!plan.area.isEmpty())
+        {
+            const QRect span = tileSpan(plan.area, TILE_SIZE);
+            for (int y = span.top(); y <= span.bottom(); ++y)
+            {
+                for (int x = span.left(); x <= span.right(); ++x)
+                    plan.encoded.append(QPoint(x, y));
+            }
+        }
+
+        plans.append(plan);
+    }
+
+    // Superseded tiles are never reclaimed by saving in place, so once they
+    // take up too much of the file, it is rewritten from scratch.
+    const qint64 garbage = device.size() - keptBytes;
+    if (inPlace && garbage > MIN_COMPACT_GARBAGE && garbage > keptBytes)
+        inPlace = false;
+
+    if (!inPlace)
+    {
+        for (LayerPlan& plan : plans)
+        {
+            plan.copied = plan.kept.keys();
+            plan.kept.clear();
+        }
+    }
+
+    // Tiles are encoded in parallel, and written in order as they finish.
+    QList<EncodeJob> jobs;
+    for (const LayerPlan& plan : qAsConst(plans))
+    {
+        for (QPoint index : plan.encoded)
+            jobs.append({ plan.image, plan.offset, index });
+    }
+    QFuture<EncodedTile> encoded = QtConcurrent::mapped(jobs, TileEncoder());
+
+    // A file that is rewritten in full is written to a new file, which
+    // replaces it once complete. Other documents (and this one, until it is
+    // saved) may still map the old file, which is left as it is.
+    QFile* file = qobject_cast<QFile*>(&device);
+    QScopedPointer<QSaveFile> saveFile;
+    if (!inPlace && file && !info.filename().isEmpty())
+    {
+        saveFile.reset(new QSaveFile(info.filename()));
+        if (!saveFile->open(QIODevice::WriteOnly))
+        {
+            ADDLE_THROW(FileException(
+                FileException::OpenWriteOnly,
+                FileException::UnknownProblem,
+                QFileInfo(info.filename())
+            ));
+        }
+    }
+    else if (file && !file->isOpen())
+    {
+        // Saving in place only appends to the file, and the header is written
+        // last, so if saving fails the file still refers to its previous
+        // index.
+        IOCheck().openFile(*file, QIODevice::ReadWrite);
+    }
+    QIODevice& out = saveFile ? *saveFile : device;
+
+    if (inPlace)
+    {
+        IOCheck().seek(out, out.size());
+    }
+    else
+    {
+        IOCheck().seek(out, 0);
+        IOCheck().write(out, writeHeader(0, 0));
+    }
+
+    const int reducedSize = TILE_SIZE >> PREVIEW_LEVEL;
+
+    int jobIndex = 0;
+    for (LayerPlan& plan : plans)
+    {
+        plan.records = plan.kept;
+
+        // The preview is put together from the reduced tiles, taking those
+        // of clean tiles from the preview they were saved with.
+        const QRect span = tileSpan(plan.area, TILE_SIZE);
+        QImage preview;
+        if (!plan.area.isEmpty())
+        {
+            preview = QImage(span.size() * reducedSize, QImage::Format_ARGB32);
+            preview.fill(Qt::transparent);
+        }
+
+        const QImage oldPreview = plan.source ? plan.source->storedPreview() : QImage();
+        const QPoint oldOrigin = plan.source ? tileSpan(plan.source->area(), TILE_SIZE).topLeft() : QPoint();
+
+        {
+            QPainter painter;
+            if (!preview.isNull())
+            {
+                painter.begin(&preview);
+                painter.setCompositionMode(QPainter::CompositionMode_Source);
+            }
+
+            const auto placeReduced = [&](QPoint index, const QImage& image, QPoint from) {
+                if (painter.isActive() && !image.isNull())
+                {
+                    painter.drawImage(
+                        (index - span.topLeft()) * reducedSize,
+                        image,
+                        QRect(from, QSize(reducedSize, reducedSize))
+                    );
+                }
+            };
+
+            for (auto i = plan.kept.cbegin(); i != plan.kept.cend(); ++i)
+                placeReduced(i.key(), oldPreview, (i.key() - oldOrigin) * reducedSize);
+
+            for (QPoint index : qAsConst(plan.copied))
+            {
+                const TileRecord oldRecord = plan.source->records().value(index);
+
+                TileRecord record;
+                record.offset = out.pos();
+                record.length = oldRecord.length;
+                IOCheck().write(out, plan.source->file()->blob(oldRecord));
+
+                plan.records.insert(index, record);
+                placeReduced(index, oldPreview, (index - oldOrigin) * reducedSize);
+            }
+
+            for (QPoint index : qAsConst(plan.encoded))
+            {
+                const EncodedTile tile = encoded.resultAt(jobIndex);
+                ++jobIndex;
+
+                info.reportProgress(0.95 * jobIndex / qMax(jobs.size(), 1));
+
+                if (tile.blob.isEmpty()) continue;
+
+                TileRecord record;
+                record.offset = out.pos();
+                record.length = tile.blob.size();
+                IOCheck().write(out, tile.blob);
+
+                plan.records.insert(index, record);
+                placeReduced(index, tile.reduced, QPoint());
+            }
+        }
+
+        if (!preview.isNull())
+        {
+            const QByteArray blob = compressImage(preview);
+
+            plan.previewSize = preview.size();
+            plan.previewRecord.offset = out.pos();
+            plan.previewRecord.length = blob.size();
+            IOCheck().write(out, blob);
+        }
+    }
+
+    const auto& groups = snapshot->layerGroups();
+
+    QByteArray indexData;
+    {
+        QDataStream index(&indexData, QIODevice::WriteOnly);
+        index.setVersion(QDataStream::Qt_5_6);
+
+        index << snapshot->size() << snapshot->backgroundColor();
+
+        index << (quint32)groups.size();
+        for (const LayerGroupInfo& group : groups)
+            index << group.name();
+
+        index << (quint32)plans.size();
+        for (const LayerPlan& plan : qAsConst(plans))
+        {
+            index << plan.name
+                << plan.opacity
+                << (qint32)plan.compositionMode
+                << plan.groupPath
+                << plan.area
+                << (quint32)plan.records.size();
+
+            for (auto i = plan.records.cbegin(); i != plan.records.cend(); ++i)
+                index << i.key() << i.value().offset << i.value().length;
+
+            index << plan.previewSize << plan.previewRecord.offset << plan.previewRecord.length;
+        }
+    }
+
+    const quint64 indexOffset = out.pos();
+    IOCheck().write(out, indexData);
+    const qint64 end = out.pos();
+
+    // The header is written last, so if saving is interrupted, a file saved
+    // in place still refers to its previous index.
+    IOCheck().seek(out, 0);
+    IOCheck().write(out, writeHeader(indexOffset, indexData.size()));
+    IOCheck().seek(out, end);
+
+    IOCheck().flush(out);
+
+    if (saveFile)
+    {
+        if (!saveFile->commit())
+        {
+            ADDLE_THROW(FileException(
+                FileException::Move,
+                FileException::UnknownProblem,
+                QFileInfo(info.filename())
+            ));
+        }
+
+        // If the device was already open, it still refers to the replaced
+        // file, which is left as it is rather than truncated.
+        if (device.isOpen())
+            IOCheck().seek(device, device.size());
+    }
+
+    // The layers are now backed by the saved file, and their saved tiles are
+    // no longer modified. (A layer that has changed since the snapshot in a
+    // way that can't be told apart by tile keeps its current source.)
+    const auto newFile = QSharedPointer<NativeDocumentFile>(new NativeDocumentFile(info.filename()));
+    if (!newFile->data().isEmpty())
+    {
+        for (const LayerPlan& plan : qAsConst(plans))
+        {
+            plan.surface->setTileSource(
+                QSharedPointer<RasterTileSource>(
+                    new NativeTileSource(
+                        newFile,
+                        TILE_SIZE,
+                        plan.area,
+                        plan.records,
+                        plan.previewSize,
+                        plan.previewRecord
+                    )
+                ),
+                plan.generation
+            );
+        }
+    }
+
+    info.reportProgress(1.0);
+}
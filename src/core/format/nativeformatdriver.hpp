@@ -0,0 +1,86 @@
+/**
+ * Addle source code
+ * @file
+ * @copyright Copyright 2020 Eleanor Hawk
+ * @copyright Modification and distribution permitted under the terms of the
+ * MIT License. See "LICENSE" for full details.
+ */
+
+#ifndef NATIVEFORMATDRIVER_HPP
+#define NATIVEFORMATDRIVER_HPP
+
+#include "compat.hpp"
+
+#include "globals.hpp"
+#include "interfaces/models/idocument.hpp"
+#include "interfaces/format/iformatdriver.hpp"
+namespace Addle {
+
+/**
+ * A format driver for Addle's own working document format (.addle), designed
+ * for fast opening and saving rather than interoperability.
+ *
+ * Each layer is stored as square tiles, each compressed independently, and
+ * found through an index at the end of the file:
+ *
+ * | Offset | Size | Content                                          |
+ * | ------ | ---- | ------------------------------------------------ |
+ * | 0      | 8    | Signature                                        |
+ * | 8      | 4    | Format version                                   |
+ * | 12     | 4    | Tile size (pixels)                               |
+ * | 16     | 8    | Offset of the index                              |
+ * | 24     | 8    | Length of the index                              |
+ * | 32     | ...  | Compressed tiles, and the index                  |
+ *
+ * Numbers are big-endian, and the index is written with QDataStream. Fully
+ * transparent tiles are omitted. Each layer also has a preview at 1/2^
+ * PREVIEW_LEVEL scale, compressed like the tiles, which is shown while the
+ * layer's tiles are decoded.
+ *
+ * Opened files are memory-mapped, and tiles are decoded only as they are
+ * needed by the layers' raster surfaces. When a document is saved back to the
+ * file it was opened from, only modified tiles are written, appended along
+ * with a new index, and the header is updated last. Once the space taken by
+ * superseded tiles outweighs the live tiles, the file is rewritten in full,
+ * to a new file that then replaces the old one, so that documents which still
+ * map the old file are not disturbed.
+ */
+class ADDLE_CORE_EXPORT NativeFormatDriver : public IFormatDriver<IDocument>
+{
+public:
+    NativeFormatDriver() = default;
+    virtual ~NativeFormatDriver() = default;
+
+    bool supportsImport() const { return true; }
+    bool supportsExport() const { return true; }
+
+    DocumentFormatId id() const { return CoreFormats::Native; }
+
+    // The file is opened read-write only to save in place. Otherwise it is
+    // replaced through a QSaveFile.
+    bool opensFiles() const { return true; }
+
+    IDocument* importModel(QIODevice& device, DocumentImportExportInfo info);
+    void exportModel(IDocument* model, QIODevice& device, DocumentImportExportInfo info);
+
+    static constexpr quint32 FORMAT_VERSION = 1;
+    static constexpr int HEADER_SIZE = 32;
+    static constexpr int TILE_SIZE = 256;
+
+    // The largest tile size accepted when opening a file. Tile sizes must be
+    // powers of two.
+    static constexpr int MAX_TILE_SIZE = 4096;
+
+    static constexpr int PREVIEW_LEVEL = 3;
+
+    // zlib compression level for tiles. Favors speed over size.
+    static constexpr int COMPRESSION_LEVEL = 1;
+
+    // A file is rewritten in full rather than appended to when it holds at
+    // least this many bytes of superseded data, and more of it than live
+    // data.
+    static constexpr qint64 MIN_COMPACT_GARBAGE = 4 * 1024 * 1024;
+};
+
+} // namespace Addle
+#endif // NATIVEFORMATDRIVER_HPP
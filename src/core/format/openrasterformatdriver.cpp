@@ -0,0 +1,414 @@
+/**
+ * Addle source code
+ * @file
+ * @copyright Copyright 2020 Eleanor Hawk
+ * @copyright Modification and distribution permitted under the terms of the
+ * MIT License. See "LICENSE" for full details.
+ */
+
+#include "openrasterformatdriver.hpp"
+
+#include "servicelocator.hpp"
+
+#include "utilities/model/documentsnapshot.hpp"
+
+#include "exceptions/formatexception.hpp"
+#include "utilities/errors.hpp"
+#include "utilities/iocheck.hpp"
+
+#include <QColor>
+#include <QImage>
+#include <QBuffer>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
+#include <QtConcurrent>
+
+#include <private/qzipreader_p.h>
+#include <private/qzipwriter_p.h>
+
+using namespace Addle;
+
+namespace {
+
+struct CompositeOp
+{
+    const char* name;
+    QPainter::CompositionMode mode;
+};
+
+// OpenRaster composite ops that have an equivalent QPainter composition mode.
+// Others (the non-separable blend modes) are treated as svg:src-over.
+const CompositeOp COMPOSITE_OPS[] = {
+    { "svg:src-over",       QPainter::CompositionMode_SourceOver },
+    { "svg:multiply",       QPainter::CompositionMode_Multiply },
+    { "svg:screen",         QPainter::CompositionMode_Screen },
+    { "svg:overlay",        QPainter::CompositionMode_Overlay },
+    { "svg:darken",         QPainter::CompositionMode_Darken },
+    { "svg:lighten",        QPainter::CompositionMode_Lighten },
+    { "svg:color-dodge",    QPainter::CompositionMode_ColorDodge },
+    { "svg:color-burn",     QPainter::CompositionMode_ColorBurn },
+    { "svg:hard-light",     QPainter::CompositionMode_HardLight },
+    { "svg:soft-light",     QPainter::CompositionMode_SoftLight },
+    { "svg:difference",     QPainter::CompositionMode_Difference },
+    { "svg:plus",           QPainter::CompositionMode_Plus },
+    { "svg:dst-in",         QPainter::CompositionMode_DestinationIn },
+    { "svg:dst-out",        QPainter::CompositionMode_DestinationOut },
+    { "svg:src-atop",       QPainter::CompositionMode_SourceAtop },
+    { "svg:dst-atop",       QPainter::CompositionMode_DestinationAtop }
+};
+
+QPainter::CompositionMode compositionModeFromOp(QStringRef op)
+{
+    for (const CompositeOp& entry : COMPOSITE_OPS)
+    {
+        if (op == QLatin1String(entry.name))
+            return entry.mode;
+    }
+    return QPainter::CompositionMode_SourceOver;
+}
+
+QString opFromCompositionMode(QPainter::CompositionMode mode)
+{
+    for (const CompositeOp& entry : COMPOSITE_OPS)
+    {
+        if (mode == entry.mode)
+            return QLatin1String(entry.name);
+    }
+    return QLatin1String(COMPOSITE_OPS[0].name);
+}
+
+// OpenRaster has no notion of a document background color, so it is saved
+// as a bottom-most layer marked with this extension attribute, which holds
+// the color so it can be restored on import. Other applications show the
+// marked layer as an ordinary layer.
+const QLatin1String ADDLE_NAMESPACE("urn:addle:openraster");
+const QLatin1String BACKGROUND_COLOR_ATTRIBUTE("background-color");
+
+struct LayerEntry
+{
+    LayerBuilder builder;
+    QPoint offset;
+    QString src;
+};
+
+// Reads the children of a <stack> element. Each nested stack is added to the
+// document builder as a layer group.
+void readStack(QXmlStreamReader& xml,
+    DocumentBuilder& document,
+    QList<int> groupPath,
+    QPoint offset,
+    QList<LayerEntry>& entries)
+{
+    while (xml.readNextStartElement())
+    {
+        const QXmlStreamAttributes attributes = xml.attributes();
+        const QPoint elementOffset = offset + QPoint(
+            attributes.value(QLatin1String("x")).toInt(),
+            attributes.value(QLatin1String("y")).toInt()
+        );
+
+        if (xml.name() == QLatin1String("stack"))
+        {
+            QList<int> childPath = groupPath;
+            childPath.append(document.addLayerGroup(
+                LayerGroupInfo(attributes.value(QLatin1String("name")).toString())
+            ));
+
+            readStack(xml, document, childPath, elementOffset, entries);
+        }
+        else if (xml.name() == QLatin1String("layer")
+            && groupPath.isEmpty()
+            && attributes.hasAttribute(ADDLE_NAMESPACE, BACKGROUND_COLOR_ATTRIBUTE))
+        {
+            const QColor color(attributes.value(ADDLE_NAMESPACE, BACKGROUND_COLOR_ATTRIBUTE).toString());
+            if (color.isValid())
+                document.setBackgroundColor(color);
+
+            xml.skipCurrentElement();
+        }
+        else if (xml.name() == QLatin1String("layer"))
+        {
+            LayerEntry entry;
+            entry.src = attributes.value(QLatin1String("src")).toString();
+            entry.offset = elementOffset;
+
+            entry.builder.setName(attributes.value(QLatin1String("name")).toString());
+            entry.builder.setGroupPath(groupPath);
+            entry.builder.setCompositionMode(
+                compositionModeFromOp(attributes.value(QLatin1String("composite-op")))
+            );
+
+            double opacity = 1.0;
+            if (attributes.hasAttribute(QLatin1String("opacity")))
+                opacity = attributes.value(QLatin1String("opacity")).toDouble();
+
+            // Layer visibility is not yet modeled, so hidden layers are
+            // imported as fully transparent.
+            if (attributes.value(QLatin1String("visibility")) == QLatin1String("hidden"))
+                opacity = 0.0;
+
+            entry.builder.setOpacity(opacity);
+
+            entries.append(entry);
+            xml.skipCurrentElement();
+        }
+        else
+        {
+            xml.skipCurrentElement();
+        }
+    }
+}
+
+QByteArray writeStack(const DocumentSnapshot& snapshot, const QStringList& sources)
+{
+    QByteArray result;
+    QXmlStreamWriter xml(&result);
+    xml.setAutoFormatting(true);
+
+    xml.writeStartDocument();
+    xml.writeStartElement(QLatin1String("image"));
+    xml.writeNamespace(ADDLE_NAMESPACE, QLatin1String("addle"));
+    xml.writeAttribute(QLatin1String("version"), QLatin1String("0.0.5"));
+    xml.writeAttribute(QLatin1String("w"), QString::number(snapshot.size().width()));
+    xml.writeAttribute(QLatin1String("h"), QString::number(snapshot.size().height()));
+
+    xml.writeStartElement(QLatin1String("stack"));
+
+    // The groups containing the previous layer, outermost first.
+    QList<int> openGroups;
+
+    const auto& layers = snapshot.layers();
+    for (int i = 0; i < layers.size(); ++i)
+    {
+        const DocumentSnapshot::Layer& layer = layers[i];
+
+        int common = 0;
+        while (common < openGroups.size() && common < layer.groupPath.size()
+            && openGroups[common] == layer.groupPath[common])
+            ++common;
+
+        while (openGroups.size() > common)
+        {
+            xml.writeEndElement();
+            openGroups.removeLast();
+        }
+
+        for (int j = common; j < layer.groupPath.size(); ++j)
+        {
+            xml.writeStartElement(QLatin1String("stack"));
+            xml.writeAttribute(QLatin1String("name"),
+                snapshot.layerGroups().value(layer.groupPath[j]).name());
+            openGroups.append(layer.groupPath[j]);
+        }
+
+        xml.writeEmptyElement(QLatin1String("layer"));
+        xml.writeAttribute(QLatin1String("name"), layer.name);
+        xml.writeAttribute(QLatin1String("src"), sources[i]);
+        xml.writeAttribute(QLatin1String("x"), QString::number(layer.offset.x()));
+        xml.writeAttribute(QLatin1String("y"), QString::number(layer.offset.y()));
+        xml.writeAttribute(QLatin1String("opacity"), QString::number(layer.opacity));
+        xml.writeAttribute(QLatin1String("visibility"), QLatin1String("visible"));
+        xml.writeAttribute(QLatin1String("composite-op"), opFromCompositionMode(layer.compositionMode));
+    }
+
+    while (!openGroups.isEmpty())
+    {
+        xml.writeEndElement();
+        openGroups.removeLast();
+    }
+
+    if (snapshot.backgroundColor().alpha() > 0)
+    {
+        xml.writeEmptyElement(QLatin1String("layer"));
+        //% "Background"
+        xml.writeAttribute(QLatin1String("name"), qtTrId("templates.background-layer-name"));
+        xml.writeAttribute(QLatin1String("src"), sources.last());
+        xml.writeAttribute(QLatin1String("x"), QLatin1String("0"));
+        xml.writeAttribute(QLatin1String("y"), QLatin1String("0"));
+        xml.writeAttribute(ADDLE_NAMESPACE, BACKGROUND_COLOR_ATTRIBUTE,
+            snapshot.backgroundColor().name(QColor::HexArgb));
+    }
+
+    xml.writeEndElement(); // stack
+    xml.writeEndElement(); // image
+    xml.writeEndDocument();
+
+    return result;
+}
+
+QImage decodeLayer(const QByteArray& data)
+{
+    QImage image;
+    image.loadFromData(data, "PNG");
+    return image;
+}
+
+QByteArray encodeLayer(const QImage& image)
+{
+    QByteArray result;
+    QBuffer buffer(&result);
+    buffer.open(QIODevice::WriteOnly);
+
+    if (image.isNull())
+    {
+        // Every layer must have a valid image, even if it is empty.
+        QImage empty(1, 1, QImage::Format_ARGB32);
+        empty.fill(Qt::transparent);
+        empty.save(&buffer, "PNG");
+    }
+    else
+    {
+        image.save(&buffer, "PNG");
+    }
+
+    return result;
+}
+
+} // namespace
+
+IDocument* OpenRasterFormatDriver::importModel(QIODevice& device, DocumentImportExportInfo info)
+{
+    // Zip archives are read from the end, so a sequential device (e.g., a
+    // pipe) is read into memory first.
+    QBuffer buffer;
+    if (device.isSequential())
+    {
+        buffer.setData(IOCheck().readAll(device));
+        buffer.open(QIODevice::ReadOnly);
+    }
+
+    QZipReader zip(device.isSequential() ? &buffer : &device);
+
+    if (!zip.isReadable()
+        || zip.status() != QZipReader::NoError
+        || zip.fileData(QStringLiteral("mimetype")).trimmed() != MIME_TYPE)
+    {
+        ADDLE_THROW(FormatException(FormatException::FormatNotRecognized, CoreFormats::ORA, info));
+    }
+
+    DocumentBuilder documentBuilder;
+    documentBuilder.setFilename(info.filename());
+
+    QList<LayerEntry> entries;
+    {
+        QXmlStreamReader xml(zip.fileData(QStringLiteral("stack.xml")));
+
+        if (xml.readNextStartElement() && xml.name() == QLatin1String("image"))
+        {
+            const QXmlStreamAttributes attributes = xml.attributes();
+            documentBuilder.setSize(QSize(
+                attributes.value(QLatin1String("w")).toInt(),
+                attributes.value(QLatin1String("h")).toInt()
+            ));
+
+            // The root stack is not itself a layer group.
+            if (xml.readNextStartElement() && xml.name() == QLatin1String("stack"))
+                readStack(xml, documentBuilder, {}, QPoint(), entries);
+        }
+
+        if (xml.hasError() || !documentBuilder.size().isValid())
+            ADDLE_THROW(FormatException(FormatException::FormatNotRecognized, CoreFormats::ORA, info));
+    }
+
+    // The archive can only be read from one thread, so the compressed images
+    // are all read out first and then decoded in parallel.
+    QList<QByteArray> data;
+    data.reserve(entries.size());
+    for (const LayerEntry& entry : qAsConst(entries))
+    {
+        info.checkCancelled();
+        data.append(zip.fileData(entry.src));
+    }
+
+    QFuture<QImage> decoded = QtConcurrent::mapped(data, &decodeLayer);
+
+    for (int i = 0; i < entries.size(); ++i)
+    {
+        if (info.isCancelled())
+        {
+            decoded.cancel();
+            ADDLE_THROW(CancelledException());
+        }
+
+        const QImage image = decoded.resultAt(i);
+        if (image.isNull())
+        {
+            decoded.cancel();
+            ADDLE_THROW(FormatException(FormatException::FormatNotRecognized, CoreFormats::ORA, info));
+        }
+
+        LayerBuilder& builder = entries[i].builder;
+        builder.setImage(image);
+        builder.setBoundary(QRect(entries[i].offset, image.size()));
+        documentBuilder.addLayer(builder);
+
+        info.reportProgress((double)(i + 1) / entries.size());
+    }
+
+    return ServiceLocator::make<IDocument>(documentBuilder);
+}
+
+void OpenRasterFormatDriver::exportModel(IDocument* model, QIODevice& device, DocumentImportExportInfo info)
+{
+    const QSharedPointer<const DocumentSnapshot> snapshot = DocumentSnapshot::forExport(model, info);
+
+    QList<QImage> images;
+    QStringList sources;
+    for (const DocumentSnapshot::Layer& layer : snapshot->layers())
+    {
+        sources.append(QStringLiteral("data/layer%1.png").arg(images.size()));
+        images.append(layer.image);
+    }
+
+    if (snapshot->backgroundColor().alpha() > 0)
+    {
+        QImage background(snapshot->size(), QImage::Format_ARGB32);
+        background.fill(snapshot->backgroundColor());
+
+        sources.append(QStringLiteral("data/background.png"));
+        images.append(background);
+    }
+
+    // Layers are encoded in parallel, and the merged image is composited
+    // alongside them.
+    QFuture<QByteArray> encoded = QtConcurrent::mapped(images, &encodeLayer);
+    QFuture<QImage> merged = QtConcurrent::run([snapshot]() { return snapshot->composite(); });
+
+    QZipWriter zip(&device);
+
+    // The mimetype entry must come first, and must not be compressed.
+    zip.setCompressionPolicy(QZipWriter::NeverCompress);
+    zip.addFile(QStringLiteral("mimetype"), QByteArray(MIME_TYPE));
+
+    zip.setCompressionPolicy(QZipWriter::AlwaysCompress);
+    zip.addFile(QStringLiteral("stack.xml"), writeStack(*snapshot, sources));
+
+    // PNG data is already compressed.
+    zip.setCompressionPolicy(QZipWriter::NeverCompress);
+
+    // Each entry is written as soon as its layer has been encoded, while
+    // later layers are still encoding.
+    for (int i = 0; i < images.size(); ++i)
+    {
+        zip.addFile(sources[i], encoded.resultAt(i));
+        info.reportProgress(0.9 * (i + 1) / images.size());
+    }
+
+    const QImage mergedImage = merged.result();
+    zip.addFile(QStringLiteral("mergedimage.png"), encodeLayer(mergedImage));
+    zip.addFile(
+        QStringLiteral("Thumbnails/thumbnail.png"),
+        encodeLayer(mergedImage.scaled(
+            THUMBNAIL_SIZE, THUMBNAIL_SIZE,
+            Qt::KeepAspectRatio,
+            Qt::SmoothTransformation
+        ))
+    );
+
+    zip.close();
+
+    if (zip.status() != QZipWriter::NoError)
+        ADDLE_THROW(FormatException(FormatException::EncodingFailed, CoreFormats::ORA, info));
+
+    info.reportProgress(1.0);
+}
@@ -0,0 +1,49 @@
+/**
+ * Addle source code
+ * @file
+ * @copyright Copyright 2020 Eleanor Hawk
+ * @copyright Modification and distribution permitted under the terms of the
+ * MIT License. See "LICENSE" for full details.
+ */
+
+#ifndef OPENRASTERFORMATDRIVER_HPP
+#define OPENRASTERFORMATDRIVER_HPP
+
+#include "compat.hpp"
+
+#include "globals.hpp"
+#include "interfaces/models/idocument.hpp"
+#include "interfaces/format/iformatdriver.hpp"
+namespace Addle {
+
+/**
+ * A format driver for OpenRaster (.ora) documents, preserving layers and layer
+ * groups.
+ *
+ * The per-layer PNG images are decoded and encoded in parallel on the global
+ * thread pool. When exporting, the archive entries are written to the device
+ * in order as each layer finishes encoding.
+ *
+ * The document background color is saved as a marked bottom-most layer, and
+ * restored as the background color when the document is imported again.
+ */
+class ADDLE_CORE_EXPORT OpenRasterFormatDriver : public IFormatDriver<IDocument>
+{
+public:
+    OpenRasterFormatDriver() = default;
+    virtual ~OpenRasterFormatDriver() = default;
+
+    bool supportsImport() const { return true; }
+    bool supportsExport() const { return true; }
+
+    DocumentFormatId id() const { return CoreFormats::ORA; }
+
+    IDocument* importModel(QIODevice& device, DocumentImportExportInfo info);
+    void exportModel(IDocument* model, QIODevice& device, DocumentImportExportInfo info);
+
+    static constexpr const char* MIME_TYPE = "image/openraster";
+    static constexpr int THUMBNAIL_SIZE = 256;
+};
+
+} // namespace Addle
+#endif // OPENRASTERFORMATDRIVER_HPP
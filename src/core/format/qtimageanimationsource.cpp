@@ -0,0 +1,56 @@
+/**
+ * Addle source code
+ * @file
+ * @copyright Copyright 2020 Eleanor Hawk
+ * @copyright Modification and distribution permitted under the terms of the
+ * MIT License. See "LICENSE" for full details.
+ */
+
+#include "qtimageanimationsource.hpp"
+
+#include <QImageReader>
+
+using namespace Addle;
+
+QtImageAnimationSource::QtImageAnimationSource(QByteArray data, QByteArray format)
+    : _data(data), _format(format)
+{
+    rewind();
+
+    _size = _reader->size();
+    _loopCount = _reader->loopCount();
+}
+
+QtImageAnimationSource::~QtImageAnimationSource() = default;
+
+void QtImageAnimationSource::rewind()
+{
+    // Not every handler can jump back to the first frame, so the reader is
+    // recreated instead.
+    _reader.reset();
+
+    _buffer.close();
+    _buffer.setData(_data);
+    _buffer.open(QIODevice::ReadOnly);
+
+    _reader.reset(new QImageReader(&_buffer, _format));
+}
+
+QImage QtImageAnimationSource::nextFrame(int& delay)
+{
+    if (!_reader->canRead())
+        return QImage();
+
+    QImage frame = _reader->read();
+    if (frame.isNull())
+        return QImage();
+
+    if (frame.format() != QImage::Format_ARGB32)
+        frame.convertTo(QImage::Format_ARGB32);
+
+    delay = _reader->nextImageDelay();
+    if (delay < MIN_DELAY)
+        delay = DEFAULT_DELAY;
+
+    return frame;
+}
@@ -0,0 +1,59 @@
+/**
+ * Addle source code
+ * @file
+ * @copyright Copyright 2020 Eleanor Hawk
+ * @copyright Modification and distribution permitted under the terms of the
+ * MIT License. See "LICENSE" for full details.
+ */
+
+#ifndef QTIMAGEANIMATIONSOURCE_HPP
+#define QTIMAGEANIMATIONSOURCE_HPP
+
+#include "compat.hpp"
+
+#include <QBuffer>
+#include <QByteArray>
+
+#include <memory>
+
+#include "utilities/image/animationsource.hpp"
+
+class QImageReader;
+
+namespace Addle {
+
+/**
+ * Decodes the frames of an animated image in a format supported by
+ * QImageReader, e.g., GIF, from encoded data held in memory.
+ */
+class ADDLE_CORE_EXPORT QtImageAnimationSource : public AnimationSource
+{
+public:
+    QtImageAnimationSource(QByteArray data, QByteArray format);
+    virtual ~QtImageAnimationSource();
+
+    QSize size() const override { return _size; }
+    int loopCount() const override { return _loopCount; }
+
+    void rewind() override;
+    QImage nextFrame(int& delay) override;
+
+    // As in web browsers, a frame delay shorter than MIN_DELAY is taken to
+    // mean DEFAULT_DELAY.
+    static constexpr int MIN_DELAY = 20;
+    static constexpr int DEFAULT_DELAY = 100;
+
+private:
+    const QByteArray _data;
+    const QByteArray _format;
+
+    QSize _size;
+    int _loopCount = 0;
+
+    QBuffer _buffer;
+    std::unique_ptr<QImageReader> _reader;
+};
+
+} // namespace Addle
+
+#endif // QTIMAGEANIMATIONSOURCE_HPP
@@ -11,22 +11,91 @@
 #include "interfaces/models/idocument.hpp"
 #include "servicelocator.hpp"
 
+#include "utilities/model/documentsnapshot.hpp"
+#include "qtimagetilesource.hpp"
+#include "qtimageanimationsource.hpp"
+
+#include "exceptions/formatexception.hpp"
+#include "utilities/errors.hpp"
+#include "utilities/iocheck.hpp"
+#include "utilities/mappedfiledevice.hpp"
+
 #include <QImage>
+#include <QImageReader>
+#include <QImageWriter>
+#include <QBuffer>
+#include <QtDebug>
 #include <QString>
 
 using namespace Addle;
 
+bool QtImageFormatDriver::supportsExport() const
+{
+    // Some of Qt's handlers, e.g., for GIF, only read.
+    return QImageWriter::supportedImageFormats().contains(QByteArray(_name).toLower());
+}
+
 IDocument* QtImageFormatDriver::importModel(QIODevice& device, DocumentImportExportInfo info)
 {
     DocumentBuilder documentBuilder;
     documentBuilder.setFilename(info.filename());
 
-    QImage image;
-    image.load(&device, _name);
+    const QByteArray data = IOCheck().readAllShared(device);
+    info.checkCancelled();
+
+    QBuffer buffer;
+    buffer.setData(data);
+    buffer.open(QIODevice::ReadOnly);
+
+    QImageReader reader(&buffer, _name);
+    const QSize size = reader.size();
+
+    // The tile and animation sources are kept after the device is closed, so
+    // unless the data is implicitly shared with a QBuffer, it is copied.
+    const auto ownedData = [&]() -> QByteArray {
+        const QBuffer* source = qobject_cast<QBuffer*>(&device);
+        const bool shared = !source
+            || (!qobject_cast<const MappedFileDevice*>(source) && data.size() == source->data().size());
+
+        return shared ? data : QByteArray(data.constData(), data.size());
+    };
 
     LayerBuilder layerBuilder;
-    layerBuilder.setImage(image);
-    layerBuilder.setBoundary(image.rect());
+
+    // The reader's clip rect and scaled size are only applied by some
+    // handlers, and are not combined with rotation from image metadata, so
+    // other images are decoded in full.
+    if (size.isValid()
+        && (qint64)size.width() * size.height() >= MIN_LAZY_DECODE_PIXELS
+        && reader.supportsOption(QImageIOHandler::ClipRect)
+        && reader.supportsOption(QImageIOHandler::ScaledSize)
+        && reader.transformation() == QImageIOHandler::TransformationNone)
+    {
+        layerBuilder.setTileSource(QSharedPointer<RasterTileSource>(
+            new QtImageTileSource(ownedData(), _name, size)
+        ));
+        layerBuilder.setBoundary(QRect(QPoint(), size));
+    }
+    else
+    {
+        // The document of an animated image holds its first frame, and a
+        // source from which a viewer can decode the rest.
+        const bool animated = reader.supportsAnimation() && reader.imageCount() > 1;
+
+        const QImage image = reader.read();
+        info.checkCancelled();
+
+        layerBuilder.setImage(image);
+        layerBuilder.setBoundary(image.rect());
+
+        if (animated && !image.isNull())
+        {
+            documentBuilder.setAnimation(QSharedPointer<AnimationSource>(
+                new QtImageAnimationSource(ownedData(), _name)
+            ));
+        }
+    }
+
     documentBuilder.addLayer(layerBuilder);
 
     // if (status)
@@ -38,5 +107,22 @@ IDocument* QtImageFormatDriver::importModel(QIODevice& device, DocumentImportExp
 
 void QtImageFormatDriver::exportModel(IDocument* model, QIODevice& device, DocumentImportExportInfo info)
 {
+    const QSharedPointer<const DocumentSnapshot> snapshot = DocumentSnapshot::forExport(model, info);
+
+    // Compositing is reported as the first 90% of the work, leaving the rest
+    // to the encoder.
+    const QImage result = snapshot->composite(
+        [&](double progress) { info.reportProgress(0.9 * progress); }
+    );
 
-}
\ No newline at end of file
+    QImageWriter writer(&device, _name);
+    if (!writer.write(result))
+    {
+#ifdef ADDLE_DEBUG
+        qWarning() << writer.errorString();
+#endif
+        ADDLE_THROW(FormatException(FormatException::EncodingFailed, _id, info));
+    }
+
+    info.reportProgress(1.0);
+}
@@ -17,6 +17,14 @@ namespace Addle {
 
 // An image format driver that uses Qt's image processing functionality as its
 // backend
+//
+// Large images in formats whose Qt handler supports clip-rect and scaled
+// decoding (e.g., JPEG) are not decoded up front. Instead, the layer is backed
+// by a tile source, so only the regions actually viewed at full resolution are
+// decoded, and a zoomed-out view is drawn from a scaled-down decode.
+//
+// Animated images (e.g., GIF) are imported as their first frame, with an
+// animation source from which the rest are decoded for playback.
 class ADDLE_CORE_EXPORT QtImageFormatDriver : public IFormatDriver<IDocument>
 {
 public:
@@ -27,13 +35,16 @@ public:
     virtual ~QtImageFormatDriver() = default;
 
     bool supportsImport() const { return true; }
-    bool supportsExport() const { return false; }
+    bool supportsExport() const;
 
     DocumentFormatId id() const { return _id; }
 
     IDocument* importModel(QIODevice& device, DocumentImportExportInfo info);
     void exportModel(IDocument* model, QIODevice& device, DocumentImportExportInfo info);
 
+    // Images with at least this many pixels are decoded on demand if possible.
+    static constexpr qint64 MIN_LAZY_DECODE_PIXELS = 4096 * 4096;
+
 private:
     const DocumentFormatId _id;
     const char* _name;
@@ -0,0 +1,192 @@
+/**
+ * Addle source code
+ * @file
+ * @copyright Copyright 2020 Eleanor Hawk
+ * @copyright Modification and distribution permitted under the terms of the
+ * MIT License. See "LICENSE" for full details.
+ */
+
+#include "qtimagetilesource.hpp"
+
+#include "exceptions/formatexception.hpp"
+#include "utilities/errors.hpp"
+
+#include <QBuffer>
+#include <QImageReader>
+#include <QPainter>
+
+using namespace Addle;
+
+QtImageTileSource::QtImageTileSource(QByteArray data, QByteArray format, QSize size)
+    : _data(data), _format(format), _size(size)
+{
+    QBuffer buffer;
+    buffer.setData(_data);
+    buffer.open(QIODevice::ReadOnly);
+
+    _canClip = QImageReader(&buffer, _format).supportsOption(QImageIOHandler::ClipRect);
+}
+
+QList<QPoint> QtImageTileSource::tiles() const
+{
+    QList<QPoint> result;
+    for (int y = 0; y * TILE_SIZE < _size.height(); ++y)
+    {
+        for (int x = 0; x * TILE_SIZE < _size.width(); ++x)
+            result.append(QPoint(x, y));
+    }
+    return result;
+}
+
+QImage QtImageTileSource::decodeTile(QPoint index) const
+{
+    const QRect rect = tileRect(index);
+    const QRect clip = rect.intersected(area());
+    if (clip.isEmpty()) return QImage();
+
+    QImage part;
+    if (_canClip)
+    {
+        part = decodeFromBand(index, clip);
+        if (part.isNull())
+            ADDLE_THROW(FormatException(FormatException::DecodingFailed, GenericFormatId()));
+    }
+    else
+    {
+        const QMutexLocker lock(&_fullMutex);
+
+        if (_full.isNull())
+            _full = decodeFull();
+        if (_full.isNull())
+            ADDLE_THROW(FormatException(FormatException::DecodingFailed, GenericFormatId()));
+
+        part = _full.copy(clip);
+
+        // The full image is only needed until every tile has been taken
+        // from it.
+        _taken.insert(index);
+        if (_taken.size() == tiles().size())
+            _full = QImage();
+    }
+
+    if (clip == rect) return part;
+
+    QImage tile(TILE_SIZE, TILE_SIZE, QImage::Format_ARGB32);
+    tile.fill(Qt::transparent);
+
+    QPainter painter(&tile);
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+    painter.drawImage(clip.topLeft() - rect.topLeft(), part);
+
+    return tile;
+}
+
+QImage QtImageTileSource::preview(QSize size) const
+{
+    if (!_preview.isNull())
+    {
+        // A preview that is larger than requested is scaled down, but one
+        // that is smaller is returned as-is, as it is drawn scaled anyway.
+        const QSize fitted = _size.scaled(size, Qt::KeepAspectRatio);
+        if (fitted.width() < _preview.width() && fitted.height() < _preview.height())
+            return _preview.scaled(fitted, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+        else
+            return _preview;
+    }
+
+    QBuffer buffer;
+    buffer.setData(_data);
+    buffer.open(QIODevice::ReadOnly);
+
+    QImageReader reader(&buffer, _format);
+    reader.setScaledSize(_size.scaled(size, Qt::KeepAspectRatio));
+
+    QImage result = reader.read();
+    if (!result.isNull() && result.format() != QImage::Format_ARGB32)
+        result.convertTo(QImage::Format_ARGB32);
+
+    return result;
+}
+
+QImage QtImageTileSource::decodeFromBand(QPoint index, QRect clip) const
+{
+    const int columns = (_size.width() + TILE_SIZE - 1) / TILE_SIZE;
+    const int rows = (_size.height() + TILE_SIZE - 1) / TILE_SIZE;
+
+    QSharedPointer<Band> band;
+    {
+        const QMutexLocker lock(&_bandsMutex);
+
+        band = _bands.value(index.y());
+        if (!band)
+        {
+            band = QSharedPointer<Band>(new Band);
+            band->firstRow = index.y();
+            band->lastRow = index.y();
+
+            if ((index.y() + 1) * TILE_SIZE > _size.height() / 2)
+            {
+                // Stops short of rows that already have a band.
+                while (band->lastRow + 1 < rows && !_bands.contains(band->lastRow + 1))
+                    ++band->lastRow;
+            }
+
+            band->tileCount = columns * (band->lastRow - band->firstRow + 1);
+            for (int row = band->firstRow; row <= band->lastRow; ++row)
+                _bands.insert(row, band);
+        }
+    }
+
+    const QMutexLocker bandLock(&band->mutex);
+
+    const QRect bandRect = QRect(
+            0, band->firstRow * TILE_SIZE,
+            _size.width(), (band->lastRow - band->firstRow + 1) * TILE_SIZE
+        ).intersected(area());
+
+    if (band->image.isNull())
+    {
+        QBuffer buffer;
+        buffer.setData(_data);
+        buffer.open(QIODevice::ReadOnly);
+
+        QImageReader reader(&buffer, _format);
+        reader.setClipRect(bandRect);
+
+        band->image = reader.read();
+        if (band->image.isNull()) return QImage();
+        if (band->image.format() != QImage::Format_ARGB32)
+            band->image.convertTo(QImage::Format_ARGB32);
+    }
+
+    const QImage part = band->image.copy(clip.translated(-bandRect.topLeft()));
+
+    // The band is only needed until every tile has been taken from it.
+    band->taken.insert(index);
+    if (band->taken.size() == band->tileCount)
+    {
+        band->image = QImage();
+
+        const QMutexLocker lock(&_bandsMutex);
+        for (int row = band->firstRow; row <= band->lastRow; ++row)
+        {
+            if (_bands.value(row) == band)
+                _bands.remove(row);
+        }
+    }
+
+    return part;
+}
+
+QImage QtImageTileSource::decodeFull() const
+{
+    QBuffer buffer;
+    buffer.setData(_data);
+    buffer.open(QIODevice::ReadOnly);
+
+    QImage result = QImageReader(&buffer, _format).read();
+    if (!result.isNull() && result.format() != QImage::Format_ARGB32)
+        result.convertTo(QImage::Format_ARGB32);
+
+    return result;
+}
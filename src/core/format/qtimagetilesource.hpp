@@ -0,0 +1,98 @@
+/**
+ * Addle source code
+ * @file
+ * @copyright Copyright 2020 Eleanor Hawk
+ * @copyright Modification and distribution permitted under the terms of the
+ * MIT License. See "LICENSE" for full details.
+ */
+
+#ifndef QTIMAGETILESOURCE_HPP
+#define QTIMAGETILESOURCE_HPP
+
+#include "compat.hpp"
+
+#include <QByteArray>
+#include <QImage>
+#include <QMutex>
+#include <QSet>
+#include <QHash>
+#include <QSharedPointer>
+
+#include "utilities/image/rastertilesource.hpp"
+#include "utilities/hashfunctions.hpp"
+
+namespace Addle {
+
+/**
+ * Decodes regions of an image encoded in a format supported by QImageReader,
+ * on demand.
+ *
+ * The encoded data is held in memory, and each decode reads it through its own
+ * QBuffer so that tiles can be decoded concurrently. If the format's handler
+ * can decode a clip rect, tiles are decoded a band at a time: the first tile
+ * requested from a row decodes the whole row, which is kept until every tile
+ * in it has been taken. Since decoding a clip rect generally costs as much as
+ * decoding everything above it, a band that reaches the lower half of the
+ * image is extended to the bottom, so that the rest of the image is decoded
+ * in the same pass. Otherwise, the whole image is decoded once, when the
+ * first tile is requested, and kept until every tile has been taken from it.
+ *
+ * A preview image that has already been decoded (e.g., by a prefetch) can be
+ * given to the source, and is then used instead of decoding a new one.
+ */
+class ADDLE_CORE_EXPORT QtImageTileSource : public RasterTileSource
+{
+public:
+    QtImageTileSource(QByteArray data, QByteArray format, QSize size);
+    virtual ~QtImageTileSource() = default;
+
+    int tileSize() const override { return TILE_SIZE; }
+    QRect area() const override { return QRect(QPoint(), _size); }
+
+    QList<QPoint> tiles() const override;
+    QImage decodeTile(QPoint index) const override;
+    QImage preview(QSize size) const override;
+
+    // Sets an image of the whole area at reduced resolution, in
+    // QImage::Format_ARGB32, to be returned by `preview()`.
+    void setPreview(QImage preview) { _preview = preview; }
+
+    static constexpr int TILE_SIZE = 512;
+
+private:
+    struct Band
+    {
+        QMutex mutex;
+
+        // Rows of tiles covered by the band, inclusive.
+        int firstRow = 0;
+        int lastRow = 0;
+
+        int tileCount = 0;
+        QImage image;
+        QSet<QPoint> taken;
+    };
+
+    QImage decodeFull() const;
+    QImage decodeFromBand(QPoint index, QRect clip) const;
+
+    const QByteArray _data;
+    const QByteArray _format;
+    const QSize _size;
+    bool _canClip;
+
+    QImage _preview;
+
+    mutable QMutex _fullMutex;
+    mutable QImage _full;
+    mutable QSet<QPoint> _taken;
+
+    // Bands being decoded or taken from, by row. A band that covers several
+    // rows is listed under each.
+    mutable QMutex _bandsMutex;
+    mutable QHash<int, QSharedPointer<Band>> _bands;
+};
+
+} // namespace Addle
+
+#endif // QTIMAGETILESOURCE_HPP
@@ -19,6 +19,8 @@ void Document::initialize(const DocumentBuilder& builder)
 
     _filename = builder.filename();
     _backgroundColor = builder.backgroundColor();
+    _layerGroups = builder.layerGroups();
+    _animation = builder.animation();
 
     for (LayerBuilder& layerBuilder : builder.layers())
     {
@@ -26,7 +28,7 @@ void Document::initialize(const DocumentBuilder& builder)
         _layers.append(QSharedPointer<ILayer>(layer));
     }
 
-    _size = unitedBoundary().size();
+    _size = builder.size().isValid() ? builder.size() : unitedBoundary().size();
 }
 
 void Document::initialize()
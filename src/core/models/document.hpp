@@ -42,6 +42,9 @@ public:
     QString filename() const { ASSERT_INIT(); return _filename; }
 
     QList<QSharedPointer<ILayer>> layers() const { ASSERT_INIT(); return _layers; }
+    QList<LayerGroupInfo> layerGroups() const { ASSERT_INIT(); return _layerGroups; }
+
+    QSharedPointer<AnimationSource> animation() const { ASSERT_INIT(); return _animation; }
 
     QImage exportImage();
 
@@ -54,8 +57,11 @@ signals:
 private:
 
     QList<QSharedPointer<ILayer>> _layers;
+    QList<LayerGroupInfo> _layerGroups;
     QSize _size;
 
+    QSharedPointer<AnimationSource> _animation;
+
     bool _empty = false; //true;
 
     QColor _backgroundColor = Qt::GlobalColor::transparent;
@@ -28,7 +28,26 @@ void Layer::initialize(const LayerBuilder& builder)
     const Initializer init(_initHelper);
 
     _boundary = builder.boundary();
+    _name = builder.name();
+    _groupPath = builder.groupPath();
     _empty = true;
     
-    _rasterSurface = ServiceLocator::makeShared<IRasterSurface>(builder.image());
+    if (builder.tileSource())
+    {
+        _rasterSurface = ServiceLocator::makeShared<IRasterSurface>(
+            builder.tileSource(),
+            builder.compositionMode()
+        );
+    }
+    else
+    {
+        _rasterSurface = ServiceLocator::makeShared<IRasterSurface>(
+            builder.image(),
+            builder.boundary().topLeft(),
+            builder.compositionMode()
+        );
+    }
+
+    if (builder.opacity() < 1.0)
+        _rasterSurface->setAlpha(qRound(qBound(0.0, builder.opacity(), 1.0) * 0xFF));
 }
\ No newline at end of file
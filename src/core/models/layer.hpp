@@ -37,6 +37,9 @@ public:
 
     bool isEmpty() const { ASSERT_INIT(); return _empty; }
 
+    QString name() const { ASSERT_INIT(); return _name; }
+    QList<int> groupPath() const { ASSERT_INIT(); return _groupPath; }
+
     QRect boundary() const { ASSERT_INIT(); return _boundary; }
     QPoint topLeft() const { ASSERT_INIT(); return _boundary.topLeft(); }
 
@@ -50,6 +53,8 @@ public slots:
 
 private:
     QRect _boundary;
+    QString _name;
+    QList<int> _groupPath;
 
     bool _empty;
 
@@ -55,7 +55,7 @@ void DocumentPresenter::initialize(QSharedPointer<IDocument> model)
     //assert model
     _model = model;
 
-    _layersHelper.initialize(_model->layers());
+    _layersHelper.initialize(_model->layers(), _model->layerGroups());
     _initHelper.setCheckpoint(InitCheckpoints::Layers);
 }
 
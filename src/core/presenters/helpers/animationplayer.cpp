@@ -0,0 +1,312 @@
+/**
+ * Addle source code
+ * @file
+ * @copyright Copyright 2020 Eleanor Hawk
+ * @copyright Modification and distribution permitted under the terms of the
+ * MIT License. See "LICENSE" for full details.
+ */
+
+#include "animationplayer.hpp"
+
+#include <cstring>
+
+#include <QPainter>
+#include <QtConcurrent>
+
+#include "interfaces/editing/irastersurface.hpp"
+#include "utilities/image/animationsource.hpp"
+
+using namespace Addle;
+
+AnimationPlayer::AnimationPlayer(
+        QSharedPointer<AnimationSource> source,
+        QSharedPointer<IRasterSurface> surface,
+        QObject* parent
+    )
+    : QObject(parent),
+    _source(source),
+    _surface(surface),
+    _loopsLeft(source->loopCount())
+{
+    _timer.setSingleShot(true);
+    connect(&_timer, &QTimer::timeout, this, &AnimationPlayer::onTimeout);
+
+    _decodeThread.setMaxThreadCount(1);
+
+    _registration = CacheManager::add(
+        QStringLiteral("animation-frames"),
+        CacheManager::Normal,
+        [this]() {
+            const QMutexLocker lock(&_mutex);
+            return _framesBytes;
+        },
+        [this](qint64) {
+            const QMutexLocker lock(&_mutex);
+            if (_stopping || _frames.isEmpty())
+                return (qint64)0;
+
+            const qint64 freed = _framesBytes;
+            _frames.clear();
+            _framesBytes = 0;
+            _frameIndex = -1;
+
+            // The decoder has finished, so it is started again from the
+            // first frame, which is decoded whole.
+            QtConcurrent::run(&_decodeThread, [this]() {
+                _source->rewind();
+                decode(false);
+            });
+            return freed;
+        }
+    );
+
+    QtConcurrent::run(&_decodeThread, [this]() { decode(true); });
+}
+
+AnimationPlayer::~AnimationPlayer()
+{
+    {
+        const QMutexLocker lock(&_mutex);
+        _stopping = true;
+        _notFull.wakeAll();
+    }
+    _decodeThread.waitForDone();
+
+    _registration.reset();
+}
+
+void AnimationPlayer::play()
+{
+    if (_playing) return;
+
+    _registration.touch();
+
+    _playing = true;
+    _timer.start(0);
+    emit playingChanged(true);
+}
+
+void AnimationPlayer::pause()
+{
+    if (!_playing) return;
+
+    _playing = false;
+    _timer.stop();
+    emit playingChanged(false);
+}
+
+void AnimationPlayer::onTimeout()
+{
+    Frame frame;
+    if (!take(frame))
+    {
+        bool finished;
+        {
+            const QMutexLocker lock(&_mutex);
+            finished = _finished && _queue.isEmpty();
+        }
+
+        if (finished)
+        {
+            pause();
+        }
+        else
+        {
+            // The decoder has fallen behind. The frame on display is held a
+            // little longer rather than waiting for it.
+            _timer.start(RETRY_INTERVAL);
+        }
+        return;
+    }
+
+    if (frame.first)
+    {
+        if (_started)
+        {
+            if (_loopsLeft == 0)
+            {
+                pause();
+                return;
+            }
+            else if (_loopsLeft > 0)
+            {
+                --_loopsLeft;
+            }
+        }
+        _started = true;
+    }
+
+    present(frame);
+    _timer.start(frame.delay);
+}
+
+void AnimationPlayer::present(const Frame& frame)
+{
+    if (frame.patch.isNull())
+        return;
+
+    auto handle = _surface->paintHandle(QRect(frame.offset, frame.patch.size()));
+    handle.painter().setCompositionMode(QPainter::CompositionMode_Source);
+    handle.painter().drawImage(frame.offset, frame.patch);
+}
+
+bool AnimationPlayer::take(Frame& frame)
+{
+    const QMutexLocker lock(&_mutex);
+
+    if (!_queue.isEmpty())
+    {
+        frame = _queue.dequeue();
+        _queuedBytes -= costOf(frame);
+        _notFull.wakeAll();
+        return true;
+    }
+
+    if (!_frames.isEmpty())
+    {
+        _frameIndex = (_frameIndex + 1) % _frames.size();
+        frame = _frames.at(_frameIndex);
+        return true;
+    }
+
+    return false;
+}
+
+bool AnimationPlayer::push(Frame frame)
+{
+    const qint64 cost = costOf(frame);
+
+    const QMutexLocker lock(&_mutex);
+
+    // A single frame larger than the budget is still let through.
+    while (!_stopping && _queuedBytes > 0 && _queuedBytes + cost > DECODE_AHEAD_BUDGET)
+        _notFull.wait(&_mutex);
+
+    if (_stopping)
+        return false;
+
+    _queue.enqueue(frame);
+    _queuedBytes += cost;
+    return true;
+}
+
+void AnimationPlayer::decode(bool cacheFrames)
+{
+    QImage previous;
+
+    QVector<Frame> frames;
+    qint64 framesBytes = 0;
+    bool cacheAll = cacheFrames;
+
+    int passes = 0;
+    const int loopCount = _source->loopCount();
+
+    while (loopCount < 0 || passes <= loopCount)
+    {
+        int count = 0;
+        int delay = 0;
+
+        for (QImage image = _source->nextFrame(delay); !image.isNull(); image = _source->nextFrame(delay))
+        {
+            Frame frame = difference(previous, image);
+            frame.delay = delay;
+            frame.first = (count == 0);
+
+            previous = image;
+            ++count;
+
+            if (passes == 0 && cacheAll)
+            {
+                frames.append(frame);
+                framesBytes += costOf(frame);
+
+                if (framesBytes > CACHE_BUDGET)
+                {
+                    cacheAll = false;
+                    frames.clear();
+                }
+            }
+
+            if (!push(frame))
+                return;
+        }
+
+        // A still image, or one that could not be decoded, is not played.
+        if (count <= 1)
+            break;
+
+        if (passes == 0 && cacheAll)
+        {
+            // The first frame was decoded against nothing. In the cache it
+            // is kept as a difference against the last frame instead, which
+            // it follows on every repetition after the first.
+            Frame first = difference(previous, frames.first().patch);
+            first.delay = frames.first().delay;
+            first.first = true;
+            frames.first() = first;
+
+            {
+                const QMutexLocker lock(&_mutex);
+                _frames = frames;
+                _framesBytes = framesBytes;
+            }
+
+            _registration.changed();
+            return;
+        }
+
+        ++passes;
+        _source->rewind();
+    }
+
+    const QMutexLocker lock(&_mutex);
+    _finished = true;
+}
+
+AnimationPlayer::Frame AnimationPlayer::difference(const QImage& previous, const QImage& image)
+{
+    Frame frame;
+
+    if (previous.isNull() || previous.size() != image.size() || previous.format() != image.format())
+    {
+        frame.patch = image;
+        return frame;
+    }
+
+    const int width = image.width();
+    const int height = image.height();
+    const size_t rowBytes = (size_t)width * sizeof(QRgb);
+
+    int top = 0;
+    while (top < height && std::memcmp(previous.constScanLine(top), image.constScanLine(top), rowBytes) == 0)
+        ++top;
+
+    if (top == height)
+        return frame; // Identical.
+
+    int bottom = height - 1;
+    while (bottom > top && std::memcmp(previous.constScanLine(bottom), image.constScanLine(bottom), rowBytes) == 0)
+        --bottom;
+
+    int left = width;
+    int right = -1;
+    for (int y = top; y <= bottom; ++y)
+    {
+        const QRgb* a = reinterpret_cast<const QRgb*>(previous.constScanLine(y));
+        const QRgb* b = reinterpret_cast<const QRgb*>(image.constScanLine(y));
+
+        for (int x = 0; x < left; ++x)
+        {
+            if (a[x] != b[x]) { left = x; break; }
+        }
+        for (int x = width - 1; x > right; --x)
+        {
+            if (a[x] != b[x]) { right = x; break; }
+        }
+    }
+
+    const QRect changed(QPoint(left, top), QPoint(right, bottom));
+    frame.patch = image.copy(changed);
+    frame.offset = changed.topLeft();
+    return frame;
+}
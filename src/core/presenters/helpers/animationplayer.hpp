@@ -0,0 +1,131 @@
+/**
+ * Addle source code
+ * @file
+ * @copyright Copyright 2020 Eleanor Hawk
+ * @copyright Modification and distribution permitted under the terms of the
+ * MIT License. See "LICENSE" for full details.
+ */
+
+#ifndef ANIMATIONPLAYER_HPP
+#define ANIMATIONPLAYER_HPP
+
+#include "compat.hpp"
+
+#include <QObject>
+#include <QImage>
+#include <QMutex>
+#include <QQueue>
+#include <QSharedPointer>
+#include <QThreadPool>
+#include <QTimer>
+#include <QVector>
+#include <QWaitCondition>
+
+#include "utilities/cachemanager.hpp"
+
+namespace Addle {
+
+class AnimationSource;
+class IRasterSurface;
+
+/**
+ * Plays an animation on a raster surface, e.g., the layer of an animated GIF
+ * in the viewer.
+ *
+ * Frames are decoded ahead of time on a background thread. Each frame is kept
+ * as the region that differs from the frame before it, which for most
+ * animations is far smaller than the full frame, and presenting it only
+ * repaints that region of the surface.
+ *
+ * If every frame of the animation fits in `CACHE_BUDGET`, the frames are kept
+ * once decoded and replayed from memory. Otherwise they are decoded
+ * continuously, no more than `DECODE_AHEAD_BUDGET` ahead of playback. Kept
+ * frames are registered with CacheManager, and if they are evicted, playback
+ * goes back to decoding continuously.
+ */
+class ADDLE_CORE_EXPORT AnimationPlayer : public QObject
+{
+    Q_OBJECT
+public:
+    AnimationPlayer(
+        QSharedPointer<AnimationSource> source,
+        QSharedPointer<IRasterSurface> surface,
+        QObject* parent = nullptr
+    );
+    virtual ~AnimationPlayer();
+
+    bool isPlaying() const { return _playing; }
+
+    static constexpr qint64 CACHE_BUDGET = 64 * 1024 * 1024;
+    static constexpr qint64 DECODE_AHEAD_BUDGET = 16 * 1024 * 1024;
+
+    // How long to wait for the decoder when it has fallen behind, in ms.
+    static constexpr int RETRY_INTERVAL = 10;
+
+public slots:
+    void play();
+    void pause();
+
+signals:
+    void playingChanged(bool playing);
+
+private slots:
+    void onTimeout();
+
+private:
+    struct Frame
+    {
+        // The region that differs from the previous frame. May be null if the
+        // frames are identical.
+        QImage patch;
+        QPoint offset;
+
+        int delay = 0;
+
+        // Whether this is the first frame of a repetition of the animation.
+        bool first = false;
+    };
+
+    static qint64 costOf(const Frame& frame) { return frame.patch.sizeInBytes() + sizeof(Frame); }
+
+    // Makes a frame that changes `previous` into `image`.
+    static Frame difference(const QImage& previous, const QImage& image);
+
+    // Runs on the decode thread. If `cacheFrames` is true, the frames are
+    // kept after the first pass, if they fit.
+    void decode(bool cacheFrames);
+    bool push(Frame frame);
+
+    // Takes the next frame, if one is ready.
+    bool take(Frame& frame);
+
+    void present(const Frame& frame);
+
+    const QSharedPointer<AnimationSource> _source;
+    const QSharedPointer<IRasterSurface> _surface;
+
+    QTimer _timer;
+    bool _playing = false;
+    bool _started = false;
+    int _loopsLeft;
+
+    QMutex _mutex;
+    QWaitCondition _notFull;
+    QQueue<Frame> _queue;
+    qint64 _queuedBytes = 0;
+    bool _stopping = false;
+    bool _finished = false;
+
+    // Set once every frame is cached.
+    QVector<Frame> _frames;
+    qint64 _framesBytes = 0;
+    int _frameIndex = -1;
+
+    QThreadPool _decodeThread;
+
+    CacheManager::Registration _registration;
+};
+
+} // namespace Addle
+
+#endif // ANIMATIONPLAYER_HPP
@@ -0,0 +1,321 @@
+/**
+ * Addle source code
+ * @file
+ * @copyright Copyright 2020 Eleanor Hawk
+ * @copyright Modification and distribution permitted under the terms of the
+ * MIT License. See "LICENSE" for full details.
+ */
+
+#include "browserimagecache.hpp"
+
+#include <climits>
+
+#include <QBuffer>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QGuiApplication>
+#include <QImageReader>
+#include <QScreen>
+
+#include "servicelocator.hpp"
+#include "globals.hpp"
+
+#include "interfaces/models/idocument.hpp"
+#include "interfaces/format/iformatdriver.hpp"
+
+#include "format/qtimagetilesource.hpp"
+
+#include "utilities/model/documentbuilder.hpp"
+#include "utils.hpp"
+
+using namespace Addle;
+
+namespace {
+
+// The formats imported by QtImageFormatDriver, with the names of their Qt
+// handlers, as configured in the service configuration. Other formats are
+// listed as neighbors, but not prefetched.
+const QList<QPair<DocumentFormatId, QByteArray>>& qtImageFormats()
+{
+    static const QList<QPair<DocumentFormatId, QByteArray>> formats = {
+        { CoreFormats::JPEG, QByteArrayLiteral("JPEG") },
+        { CoreFormats::PNG, QByteArrayLiteral("PNG") }
+        // GIF is not prefetched, as cached entries do not keep animations.
+    };
+    return formats;
+}
+
+QByteArray qtImageFormat(const QString& suffix)
+{
+    for (const auto& format : qtImageFormats())
+    {
+        if (format.first.fileExtensions().contains(suffix, Qt::CaseInsensitive))
+            return format.second;
+    }
+    return QByteArray();
+}
+
+// QCache costs are ints, so entries are costed in KiB.
+inline int costOf(qint64 bytes)
+{
+    return (int)qMin((bytes + 1023) / 1024, (qint64)INT_MAX);
+}
+
+} // namespace
+
+BrowserImageCache::BrowserImageCache()
+{
+    _entries.setMaxCost(costOf(DEFAULT_BUDGET));
+
+    const QScreen* screen = qobject_cast<QGuiApplication*>(QCoreApplication::instance()) ?
+        QGuiApplication::primaryScreen() : nullptr;
+    if (screen)
+        _displaySize = screen->size() * screen->devicePixelRatio();
+    else
+        _displaySize = QSize(1920, 1080);
+
+    _registration = CacheManager::add(
+        QStringLiteral("browser-images"),
+        CacheManager::Low,
+        [this]() {
+            const QMutexLocker lock(&_mutex);
+            return (qint64)_entries.totalCost() * 1024;
+        },
+        [this](qint64 bytes) {
+            // QCache drops its least recently used entries when its maximum
+            // cost is lowered, so it is lowered and restored.
+            const QMutexLocker lock(&_mutex);
+            const int before = _entries.totalCost();
+            const int maxCost = _entries.maxCost();
+            _entries.setMaxCost(qMax(before - costOf(bytes), 0));
+            _entries.setMaxCost(maxCost);
+            return (qint64)(before - _entries.totalCost()) * 1024;
+        }
+    );
+}
+
+BrowserImageCache::~BrowserImageCache()
+{
+    _tasks.clear();
+    _tasks.waitForDone();
+
+    _registration.reset();
+}
+
+void BrowserImageCache::setDisplaySize(QSize size)
+{
+    const QMutexLocker lock(&_mutex);
+    if (size == _displaySize) return;
+
+    _displaySize = size;
+    _entries.clear();
+}
+
+void BrowserImageCache::setBudget(qint64 bytes)
+{
+    const QMutexLocker lock(&_mutex);
+    _entries.setMaxCost(costOf(bytes));
+}
+
+QString BrowserImageCache::neighbor(const QString& filename, int offset)
+{
+    const QStringList& files = listing(filename);
+
+    const int index = files.indexOf(QFileInfo(filename).absoluteFilePath());
+    if (index < 0 || index + offset < 0 || index + offset >= files.size())
+        return QString();
+
+    return files.at(index + offset);
+}
+
+void BrowserImageCache::prefetchAround(const QString& filename)
+{
+    const QStringList& files = listing(filename);
+
+    const int index = files.indexOf(QFileInfo(filename).absoluteFilePath());
+    if (index < 0) return;
+
+    // Files in the direction of travel are prefetched first, nearest first.
+    const int direction = index < _lastIndex ? -1 : 1;
+    _lastIndex = index;
+
+    QStringList wanted;
+    for (int distance = 1; distance <= _prefetchCount; ++distance)
+    {
+        for (int sign : { direction, -direction })
+        {
+            const int i = index + sign * distance;
+            if (i >= 0 && i < files.size())
+                wanted.append(files.at(i));
+        }
+    }
+
+    const QMutexLocker lock(&_mutex);
+
+    _wanted = wanted.toSet();
+    for (const QString& file : noDetach(wanted))
+    {
+        if (_entries.contains(file) || _pending.contains(file))
+            continue;
+        if (qtImageFormat(QFileInfo(file).suffix()).isEmpty())
+            continue;
+
+        _pending.insert(file);
+        _tasks.start([this, file]() { prefetch(file); });
+    }
+}
+
+QSharedPointer<IDocument> BrowserImageCache::document(const QString& filename)
+{
+    const QFileInfo info(filename);
+    const QString key = info.absoluteFilePath();
+
+    Entry entry;
+    {
+        const QMutexLocker lock(&_mutex);
+
+        const Entry* cached = _entries.object(key);
+        if (!cached) return QSharedPointer<IDocument>();
+
+        if (cached->lastModified != info.lastModified() || cached->fileSize != info.size())
+        {
+            _entries.remove(key);
+            return QSharedPointer<IDocument>();
+        }
+
+        entry = *cached;
+    }
+
+    _registration.touch();
+
+    DocumentBuilder documentBuilder;
+    documentBuilder.setFilename(filename);
+
+    LayerBuilder layerBuilder;
+    if (!entry.data.isNull())
+    {
+        auto source = new QtImageTileSource(entry.data, entry.format, entry.size);
+        source->setPreview(entry.image);
+
+        layerBuilder.setTileSource(QSharedPointer<RasterTileSource>(source));
+        layerBuilder.setBoundary(QRect(QPoint(), entry.size));
+    }
+    else
+    {
+        layerBuilder.setImage(entry.image);
+        layerBuilder.setBoundary(entry.image.rect());
+    }
+
+    documentBuilder.addLayer(layerBuilder);
+
+    return QSharedPointer<IDocument>(ServiceLocator::make<IDocument>(documentBuilder));
+}
+
+const QStringList& BrowserImageCache::listing(const QString& filename)
+{
+    const QFileInfo info(filename);
+    const QString dirPath = info.absolutePath();
+
+    // The listing is refreshed when moving to another directory, or when the
+    // file is missing from it, e.g., because it was created since.
+    if (dirPath == _listingDir && _listing.contains(info.absoluteFilePath()))
+        return _listing;
+
+    QStringList filters;
+    for (DocumentFormatId format : noDetach(ServiceLocator::getIds<IFormatDriver<IDocument>>()))
+    {
+        if (!ServiceLocator::get<IFormatDriver<IDocument>>(format).supportsImport())
+            continue;
+
+        for (const QString& suffix : format.fileExtensions())
+            filters.append(QStringLiteral("*.") + suffix);
+    }
+
+    const QDir dir(dirPath);
+    const QStringList names = dir.entryList(
+        filters,
+        QDir::Files | QDir::Readable,
+        QDir::Name | QDir::IgnoreCase | QDir::LocaleAware
+    );
+
+    _listingDir = dirPath;
+    _listing.clear();
+    for (const QString& name : names)
+        _listing.append(dir.absoluteFilePath(name));
+
+    _lastIndex = -1;
+    return _listing;
+}
+
+void BrowserImageCache::prefetch(const QString& filename)
+{
+    QSize displaySize;
+    {
+        const QMutexLocker lock(&_mutex);
+        if (!_wanted.contains(filename))
+        {
+            // Superseded by a later prefetchAround() before it began.
+            _pending.remove(filename);
+            return;
+        }
+        displaySize = _displaySize;
+    }
+
+    const QFileInfo info(filename);
+
+    Entry* entry = new Entry;
+    entry->lastModified = info.lastModified();
+    entry->fileSize = info.size();
+    entry->format = qtImageFormat(info.suffix());
+
+    QByteArray data;
+    {
+        QFile file(filename);
+        if (file.open(QIODevice::ReadOnly))
+            data = file.readAll();
+    }
+
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::ReadOnly);
+
+    QImageReader reader(&buffer, entry->format);
+    entry->size = reader.size();
+
+    // Images larger than the display are decoded at a reduced size, which
+    // QImageReader scales to itself if the format's handler can't. Their
+    // encoded data is kept so the full resolution can be decoded on demand:
+    // a band at a time if the handler can decode a clip rect, or else all at
+    // once (see QtImageTileSource). As in QtImageFormatDriver, images with a
+    // transformation in their metadata are only decoded in full.
+    if (entry->size.isValid()
+        && reader.transformation() == QImageIOHandler::TransformationNone
+        && (entry->size.width() > displaySize.width() || entry->size.height() > displaySize.height()))
+    {
+        reader.setScaledSize(entry->size.scaled(displaySize, Qt::KeepAspectRatio));
+        entry->data = data;
+    }
+
+    entry->image = reader.read();
+    if (!entry->image.isNull() && entry->image.format() != QImage::Format_ARGB32)
+        entry->image.convertTo(QImage::Format_ARGB32);
+
+    {
+        const QMutexLocker lock(&_mutex);
+        _pending.remove(filename);
+
+        if (entry->image.isNull() || displaySize != _displaySize)
+        {
+            delete entry;
+            return;
+        }
+
+        _entries.insert(
+            info.absoluteFilePath(),
+            entry,
+            costOf(entry->data.size() + entry->image.sizeInBytes())
+        );
+    }
+
+    _registration.changed();
+}
@@ -0,0 +1,124 @@
+/**
+ * Addle source code
+ * @file
+ * @copyright Copyright 2020 Eleanor Hawk
+ * @copyright Modification and distribution permitted under the terms of the
+ * MIT License. See "LICENSE" for full details.
+ */
+
+#ifndef BROWSERIMAGECACHE_HPP
+#define BROWSERIMAGECACHE_HPP
+
+#include "compat.hpp"
+
+#include <QByteArray>
+#include <QCache>
+#include <QDateTime>
+#include <QImage>
+#include <QMutex>
+#include <QSet>
+#include <QSharedPointer>
+#include <QSize>
+#include <QStringList>
+
+#include "utilities/cachemanager.hpp"
+#include "utilities/taskscheduler.hpp"
+
+namespace Addle {
+
+class IDocument;
+
+/**
+ * Decodes the images surrounding the one being viewed, so that stepping
+ * through a directory in the viewer does not wait on the disk or the decoder.
+ *
+ * The files before and after the current one in its directory are read in the
+ * Background lane of TaskScheduler, and decoded at no more than the display's
+ * resolution. The encoded data of a reduced image is kept with it, so when a
+ * cached file is opened, it is shown from the reduced image at once, and the
+ * full resolution is decoded only once it is needed.
+ *
+ * Entries are held in a least-recently-used cache, limited by their size in
+ * memory. The cache is registered with CacheManager at low priority, so
+ * prefetched images are the first memory given up when Addle's caches exceed
+ * their global budget.
+ *
+ * `prefetchAround()` and `neighbor()` are meant to be called from the UI
+ * thread. `document()` may be called from any thread.
+ */
+class ADDLE_CORE_EXPORT BrowserImageCache
+{
+public:
+    BrowserImageCache();
+    ~BrowserImageCache();
+
+    BrowserImageCache(const BrowserImageCache&) = delete;
+    BrowserImageCache& operator=(const BrowserImageCache&) = delete;
+
+    // The size that prefetched images are decoded to fit. Defaults to the
+    // size of the primary screen, in device pixels.
+    QSize displaySize() const { const QMutexLocker lock(&_mutex); return _displaySize; }
+    void setDisplaySize(QSize size);
+
+    // The number of files on each side of the current one to prefetch.
+    int prefetchCount() const { return _prefetchCount; }
+    void setPrefetchCount(int count) { _prefetchCount = count; }
+
+    // The approximate number of bytes held by the cache at most.
+    qint64 budget() const { const QMutexLocker lock(&_mutex); return (qint64)_entries.maxCost() * 1024; }
+    void setBudget(qint64 bytes);
+
+    // The file `offset` places away from `filename` among the files in its
+    // directory that Addle can open, sorted by name, or a null string if there
+    // is none.
+    QString neighbor(const QString& filename, int offset);
+
+    // Begins prefetching the neighbors of `filename`. Queued prefetches of
+    // files that are no longer neighbors are abandoned.
+    void prefetchAround(const QString& filename);
+
+    // Creates a document from the cached entry for `filename`, or returns null
+    // if it is not cached, or the file has changed since it was cached.
+    QSharedPointer<IDocument> document(const QString& filename);
+
+    static constexpr int DEFAULT_PREFETCH_COUNT = 2;
+    static constexpr qint64 DEFAULT_BUDGET = 256 * 1024 * 1024;
+
+private:
+    struct Entry
+    {
+        QDateTime lastModified;
+        qint64 fileSize = 0;
+
+        // The encoded image, if it is decoded lazily, or null if `image` is
+        // the image at full resolution.
+        QByteArray data;
+        QByteArray format;
+        QSize size;
+
+        QImage image;
+    };
+
+    const QStringList& listing(const QString& filename);
+    void prefetch(const QString& filename);
+
+    QString _listingDir;
+    QStringList _listing;
+    int _lastIndex = -1;
+
+    int _prefetchCount = DEFAULT_PREFETCH_COUNT;
+
+    mutable QMutex _mutex;
+    QSize _displaySize;
+    QCache<QString, Entry> _entries;
+    QSet<QString> _pending;
+    QSet<QString> _wanted;
+
+    TaskGroup _tasks { TaskScheduler::Background };
+
+    CacheManager::Registration _registration;
+};
+
+} // namespace Addle
+
+#endif // BROWSERIMAGECACHE_HPP
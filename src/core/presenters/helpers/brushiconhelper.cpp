@@ -31,6 +31,12 @@ QImage BrushIconHelper::_pattern64 = QImage();
 BrushIconHelper::BrushIconHelper(QObject* parent)
     : QObject(parent)
 {
+}
+
+void BrushIconHelper::initSurfaces() const
+{
+    if (_renderStack) return;
+
     _underSurface = ServiceLocator::makeShared<IRasterSurface>();
     _brushSurface = ServiceLocator::makeShared<IRasterSurface>();
     _renderStack = ServiceLocator::makeShared<IRenderStack>(
@@ -39,12 +45,24 @@ BrushIconHelper::BrushIconHelper(QObject* parent)
             _brushSurface->renderStep().toWeakRef()
         })
     );
+}
 
-    if (_pattern8.isNull())
-        _pattern8.load(ServiceLocator::get<IAppearanceService>().selector().select(":/misc/pattern8.png"));
-
-    if (_pattern64.isNull())
-        _pattern64.load(ServiceLocator::get<IAppearanceService>().selector().select(":/misc/pattern64.png"));
+const QImage& BrushIconHelper::pattern(bool small)
+{
+    if (small)
+    {
+        if (_pattern8.isNull())
+            _pattern8.load(ServiceLocator::get<IAppearanceService>().selector().select(":/misc/pattern8.png"));
+        
+        return _pattern8;
+    }
+    else
+    {
+        if (_pattern64.isNull())
+            _pattern64.load(ServiceLocator::get<IAppearanceService>().selector().select(":/misc/pattern64.png"));
+        
+        return _pattern64;
+    }
 }
 
 QIcon BrushIconHelper::icon() const
@@ -83,20 +101,19 @@ BrushIconHelper::BrushIconEngine::BrushIconEngine(
     double size
 )
     : _helper(helper),
-    _brushStroke(new BrushStroke(brush, _helper->color(), size, helper->_brushSurface))
+    _brush(brush),
+    _size(size)
 {
-    _brushStroke->setPreview(true);
 }
 
 BrushIconHelper::BrushIconEngine::BrushIconEngine(
     QPointer<const BrushIconHelper> helper,
     BrushId brush
 )
-    : _helper(helper),
-    _brushStroke(new BrushStroke(brush, _helper->color(), 0, helper->_brushSurface)),
-    _autoSize(true)
+    : _autoSize(true),
+    _helper(helper),
+    _brush(brush)
 {
-    _brushStroke->setPreview(true);
 }
 
 QIconEngine* BrushIconHelper::BrushIconEngine::clone() const
@@ -128,12 +145,21 @@ void BrushIconHelper::BrushIconEngine::paint_p(QSize iconSize)
 {
     if (!_helper) return; // assert
 
+    _helper->initSurfaces();
+    if (!_brushStroke)
+    {
+        _brushStroke = QSharedPointer<BrushStroke>(
+            new BrushStroke(_brush, _helper->color(), _size, _helper->_brushSurface)
+        );
+        _brushStroke->setPreview(true);
+    }
+
     double size;
     double scale;
     QPointF center;
 
-    IBrush::PreviewHints hints = ServiceLocator::get<IBrush>(_helper->_brush).previewHints();
-    bool copyMode = ServiceLocator::get<IBrush>(_helper->_brush).copyMode();
+    IBrush::PreviewHints hints = _brushStroke->brush().previewHints();
+    bool copyMode = _brushStroke->brush().copyMode();
 
     const QRect iconRect(QPoint(), iconSize);
 
@@ -230,10 +256,7 @@ void BrushIconHelper::BrushIconEngine::paint_p(QSize iconSize)
         
         surfaceHandle.painter().setPen(Qt::NoPen);
 
-        if (smallIcon)
-            surfaceHandle.painter().setBrush(QBrush(_pattern8));
-        else 
-            surfaceHandle.painter().setBrush(QBrush(_pattern64));
+        surfaceHandle.painter().setBrush(QBrush(pattern(smallIcon)));
             
         surfaceHandle.painter().setBrushOrigin(canonicalRect.center());
         surfaceHandle.painter().drawRect(coarseBoundRect(canonicalRect));
@@ -69,6 +69,8 @@ private:
         bool _autoSize = false;
 
         QPointer<const BrushIconHelper> _helper;
+        BrushId _brush;
+        double _size = 0;
         QSharedPointer<BrushStroke> _brushStroke; //concurrency?
 
         QPixmap _cache;
@@ -97,9 +99,16 @@ private:
     static QImage _pattern8;
     static QImage _pattern64;
 
-    QSharedPointer<IRasterSurface> _underSurface;
-    QSharedPointer<IRasterSurface> _brushSurface; // make static
-    QSharedPointer<IRenderStack> _renderStack;
+    // The patterns are loaded the first time a subtractive brush is painted.
+    static const QImage& pattern(bool small);
+
+    // The surfaces and render stack are built the first time an icon is
+    // painted, rather than when the helper is made.
+    void initSurfaces() const;
+
+    mutable QSharedPointer<IRasterSurface> _underSurface;
+    mutable QSharedPointer<IRasterSurface> _brushSurface; // make static
+    mutable QSharedPointer<IRenderStack> _renderStack;
     static CheckerBoard _checkerBoard;
 
     void paint(QPainter* painter, const QRect& rect, BrushId brush);
@@ -38,16 +38,56 @@ public:
         _topSelectedLayer.onChange += onTopSelectedLayerChanged;
     }
 
-    void initialize(const QList<QSharedPointer<ILayer>>& layerModels)
+    void initialize(const QList<QSharedPointer<ILayer>>& layerModels, const QList<LayerGroupInfo>& layerGroups = {})
     {
+        // The groups containing the previous layer, outermost first, paired
+        // with their nodes.
+        QList<QPair<int, LayerNode*>> openGroups;
+
         for (auto layerModel : layerModels)
         {
-            auto layer = ServiceLocator::makeShared<ILayerPresenter>(_document, layerModel);
-            _layers.addValue(layer);
+            const QList<int> groupPath = layerModel->groupPath();
+
+            int common = 0;
+            while (common < openGroups.size() && common < groupPath.size()
+                && openGroups[common].first == groupPath[common])
+                ++common;
+            
+            while (openGroups.size() > common)
+                openGroups.removeLast();
+
+            for (int i = common; i < groupPath.size(); ++i)
+            {
+                LayerNode& parent = openGroups.isEmpty() ? _layers.root() : *openGroups.last().second;
+                LayerNode& group = parent.addGroup();
+
+                LayerGroupInfo info = layerGroups.value(groupPath[i]);
+                if (info.name().isEmpty())
+                {
+                    info.setName(qtTrId("templates.layer-group-name").arg(_layerGroupLabelNumber));
+                    _layerGroupLabelNumber++;
+                }
+                group.setMetaData(QVariant::fromValue(info));
+
+                openGroups.append(qMakePair(groupPath[i], &group));
+            }
 
-            //% "Layer %1"
-            layer->setName(qtTrId("templates.layer-name").arg(_layerLabelNumber));
-            _layerLabelNumber++;
+            auto layer = ServiceLocator::makeShared<ILayerPresenter>(_document, layerModel);
+            if (openGroups.isEmpty())
+                _layers.addValue(layer);
+            else
+                openGroups.last().second->addValue(layer);
+
+            if (!layerModel->name().isEmpty())
+            {
+                layer->setName(layerModel->name());
+            }
+            else
+            {
+                //% "Layer %1"
+                layer->setName(qtTrId("templates.layer-name").arg(_layerLabelNumber));
+                _layerLabelNumber++;
+            }
         }
                 
         _layerSelection.insert(&_layers[0]);
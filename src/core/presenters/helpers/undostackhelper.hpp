@@ -17,6 +17,10 @@
 #include <QStack>
 namespace Addle {
 
+// The history is not registered with CacheManager. Unlike a cache, an
+// operation evicted from it can't be made again, so evicting would silently
+// take undo steps from the user. It is also only touched from the GUI thread,
+// while the manager may call into caches from any thread.
 class UndoStackHelper 
 {
 public:
@@ -41,8 +41,7 @@ void LayerPresenter::initialize(IDocumentPresenter* documentPresenter, QSharedPo
         _model->rasterSurface().data(),
         SIGNAL(changed(QRect)),
         this,
-        SLOT(onRasterChanged(QRect)),
-        Qt::QueuedConnection
+        SLOT(onRasterChanged(QRect))
     );
 
     _renderStep = QSharedPointer<IRenderStep>(new LayerPresenterRenderStep(*this));
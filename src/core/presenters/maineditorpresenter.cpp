@@ -53,11 +53,14 @@
 #include "exceptions/formatexception.hpp"
 
 #include "utilities/iocheck.hpp"
+#include "utilities/mappedfiledevice.hpp"
+#include "utilities/debugging/startuptrace.hpp"
 
 using namespace Addle;
 
 void MainEditorPresenter::initialize(Mode mode)
 {
+    ADDLE_TRACE_STARTUP("MainEditorPresenter::initialize");
     const Initializer init(_initHelper);
     
     ServiceLocator::get<IApplicationService>().registerMainEditorPresenter(this);
@@ -70,49 +73,41 @@ void MainEditorPresenter::initialize(Mode mode)
     _canvasPresenter = ServiceLocator::makeUnique<ICanvasPresenter>(std::ref(*this));
     _initHelper.setCheckpoint(InitCheck_CanvasPresenter);
     
-    _palettes = { 
-        ServiceLocator::makeShared<IPalettePresenter>(CorePalettes::BasicPalette)
-    };
-
-    _colorSelection = ServiceLocator::makeUnique<IColorSelectionPresenter>(_palettes);
-    _colorSelection->setPalette(_palettes.first());
+    // The viewer does without the presenters that only editing needs, until
+    // it is switched into editor mode.
+    if (_mode == Editor)
+        initEditing();
     _initHelper.setCheckpoint(InitCheck_ColorSelection);
 
-    _brushTool = ServiceLocator::makeShared<IBrushToolPresenter>(
-        this,
-        IBrushToolPresenter::Mode::Brush
-    );
-
-    _eraserTool = ServiceLocator::makeShared<IBrushToolPresenter>(
-        this,
-        IBrushToolPresenter::Mode::Eraser
-    );
-
-    _navigateTool = ServiceLocator::makeShared<INavigateToolPresenter>(
-        this
-    );
-
+    // Tool presenters are built by toolPresenter() when they are first needed.
     _tools = {{
         Mode::Editor,
         {
-            //{ DefaultTools::Select, nullptr },
-            { CoreTools::Brush, _brushTool },
-            { CoreTools::Eraser, _eraserTool },
-            //{ DefaultTools::Text, nullptr },
-            //{ DefaultTools::Shapes, nullptr },
-            //{ DefaultTools::Stickers, nullptr },
-            //{ DefaultTools::Eyedrop, nullptr },
-            { CoreTools::Navigate, _navigateTool }
-            //{ DefaultTools::Measure, nullptr }
+            //DefaultTools::Select,
+            CoreTools::Brush,
+            CoreTools::Eraser,
+            //DefaultTools::Text,
+            //DefaultTools::Shapes,
+            //DefaultTools::Stickers,
+            //DefaultTools::Eyedrop,
+            CoreTools::Navigate
+            //DefaultTools::Measure
+        }
+    }, {
+        Mode::Viewer,
+        {
+            CoreTools::Navigate
         }
     }};
 
-    _view = ServiceLocator::makeUnique<IMainEditorView>(std::ref(*this));
+    {
+        ADDLE_TRACE_STARTUP("MainEditorView construction");
+        _view = ServiceLocator::makeUnique<IMainEditorView>(std::ref(*this));
+    }
     _initHelper.setCheckpoint(InitCheck_View);
 
-    _loadDocumentTask = new LoadDocumentTask(this);
-    connect(_loadDocumentTask, &AsyncTask::completed, this, &MainEditorPresenter::onLoadDocumentCompleted);
-    connect(_loadDocumentTask, &AsyncTask::failed, this, &MainEditorPresenter::onLoadDocumentFailed);
+    _saveDocumentTask = new SaveDocumentTask(this);
+    connect(_saveDocumentTask, &AsyncTask::failed, this, &MainEditorPresenter::onSaveDocumentFailed);
 }
 
 void MainEditorPresenter::setDocumentPresenter(QSharedPointer<IDocumentPresenter> documentPresenter)
@@ -123,6 +118,9 @@ void MainEditorPresenter::setDocumentPresenter(QSharedPointer<IDocumentPresenter
 
     _documentPresenter = documentPresenter;
 
+    _animationPlayer.reset();
+    updateAnimation();
+
     if (_connection_topSelectedLayer)
         disconnect(_connection_topSelectedLayer);
 
@@ -154,8 +152,59 @@ QSharedPointer<ILayerPresenter> MainEditorPresenter::topSelectedLayer() const
 void MainEditorPresenter::setMode(Mode mode)
 {
     ASSERT_INIT(); 
+    if (mode == _mode)
+        return;
+
     _mode = mode;
-    //emit
+
+    if (_mode == Editor)
+        initEditing();
+
+    // Animations are only played in the viewer. The document is kept as it
+    // is, so an animation stopped here is edited at its current frame.
+    updateAnimation();
+
+    if (_currentTool && !_tools.value(_mode).contains(_currentTool))
+        setCurrentTool(CoreTools::Navigate);
+
+    emit modeChanged(_mode);
+}
+
+void MainEditorPresenter::initEditing()
+{
+    if (_colorSelection)
+        return;
+
+    _palettes = { 
+        ServiceLocator::makeShared<IPalettePresenter>(CorePalettes::BasicPalette)
+    };
+
+    _colorSelection = ServiceLocator::makeUnique<IColorSelectionPresenter>(_palettes);
+    _colorSelection->setPalette(_palettes.first());
+}
+
+void MainEditorPresenter::updateAnimation()
+{
+    // The viewer plays animated images on their only layer.
+    if (!_animationPlayer && _mode == Viewer && _documentPresenter)
+    {
+        const QSharedPointer<IDocument> model = _documentPresenter->model();
+        if (model && model->animation() && !model->layers().isEmpty())
+        {
+            _animationPlayer.reset(new AnimationPlayer(
+                model->animation(),
+                model->layers().first()->rasterSurface()
+            ));
+        }
+    }
+
+    if (_animationPlayer)
+    {
+        if (_mode == Viewer)
+            _animationPlayer->play();
+        else
+            _animationPlayer->pause();
+    }
 }
 
 void MainEditorPresenter::newDocument()
@@ -192,23 +241,102 @@ void MainEditorPresenter::loadDocument(QUrl url)
         }
         else
         {            
-            if (!_loadDocumentTask->isRunning())
-            {
-                _loadDocumentTask->setUrl(url);
-                _loadDocumentTask->start();
-            }
+            startLoadDocumentTask(url);
         }
     }
     ADDLE_SLOT_CATCH
 }
 
+void MainEditorPresenter::startLoadDocumentTask(QUrl url)
+{
+    if (_loadDocumentTask && _loadDocumentTask->isRunning())
+    {
+        // The latest request wins. The load in progress is cancelled and
+        // abandoned, and deleted once it has stopped.
+        LoadDocumentTask* superseded = _loadDocumentTask;
+        _loadDocumentTask = nullptr;
+
+        superseded->disconnect(this);
+        superseded->setParent(nullptr);
+        connect(superseded, &AsyncTask::stopped, superseded, &QObject::deleteLater);
+        superseded->cancel();
+
+        if (!superseded->isRunning())
+            superseded->deleteLater();
+    }
+
+    if (!_loadDocumentTask)
+    {
+        _loadDocumentTask = new LoadDocumentTask(this);
+        connect(_loadDocumentTask, &AsyncTask::completed, this, &MainEditorPresenter::onLoadDocumentCompleted);
+        connect(_loadDocumentTask, &AsyncTask::failed, this, &MainEditorPresenter::onLoadDocumentFailed);
+    }
+
+    if (_mode == Viewer && url.isLocalFile())
+    {
+        if (!_browserCache)
+            _browserCache = QSharedPointer<BrowserImageCache>::create();
+
+        _loadDocumentTask->setBrowserCache(_browserCache);
+    }
+    else
+    {
+        _loadDocumentTask->setBrowserCache(QSharedPointer<BrowserImageCache>());
+    }
+
+    _browsedUrl = url;
+    _loadDocumentTask->setUrl(url);
+    _loadDocumentTask->start();
+}
+
+void MainEditorPresenter::browse(int offset)
+{
+    if (_mode != Viewer || !_browsedUrl.isLocalFile())
+        return;
+
+    if (!_browserCache)
+        _browserCache = QSharedPointer<BrowserImageCache>::create();
+
+    const QString filename = _browserCache->neighbor(_browsedUrl.toLocalFile(), offset);
+    if (!filename.isNull())
+        startLoadDocumentTask(QUrl::fromLocalFile(filename));
+}
+
+void MainEditorPresenter::saveDocument(QUrl url)
+{
+    try
+    {
+        ASSERT_INIT();
+        if (isEmpty() || _saveDocumentTask->isRunning())
+            return;
+
+        _saveDocumentTask->setUrl(url);
+        // The document is only read here, on the thread that owns it, and
+        // the task is given a snapshot of it.
+        _saveDocumentTask->setSnapshot(QSharedPointer<const DocumentSnapshot>(
+            new DocumentSnapshot(*_documentPresenter->model())
+        ));
+        _saveDocumentTask->start();
+    }
+    ADDLE_SLOT_CATCH
+}
+
 void MainEditorPresenter::onLoadDocumentCompleted()
 {
     try
     {
         ASSERT_INIT(); 
+
+        // A signal from a superseded task may already have been queued.
+        if (sender() != _loadDocumentTask) return;
+
         setDocumentPresenter(_loadDocumentTask->documentPresenter());
         view().show();
+
+        // Neighbors are prefetched once the file itself has been loaded, so
+        // they do not compete with it.
+        if (_browserCache && _loadDocumentTask->url().isLocalFile())
+            _browserCache->prefetchAround(_loadDocumentTask->url().toLocalFile());
     }
     ADDLE_SLOT_CATCH
 }
@@ -219,6 +347,8 @@ void MainEditorPresenter::onLoadDocumentFailed()
     {
         ASSERT_INIT();
 
+        if (sender() != _loadDocumentTask) return;
+
         const auto& mainEditorPresenters = ServiceLocator::get<IApplicationService>().mainEditorPresenters();
         ADDLE_ASSERT(mainEditorPresenters.contains(this));
 
@@ -240,6 +370,7 @@ void MainEditorPresenter::onLoadDocumentFailed()
             case FormatException::FormatNotRecognized:
             case FormatException::EmptyResource:
             case FormatException::WrongModelType:
+            case FormatException::DecodingFailed:
                 errorPresenter->setMessage(
                     //: Displayed after attempting to open a file whose format
                     //: is not supported, not recognized, damaged, or otherwise
@@ -304,38 +435,124 @@ void MainEditorPresenter::onLoadDocumentFailed()
     ADDLE_SLOT_CATCH
 }
 
+void MainEditorPresenter::onSaveDocumentFailed()
+{
+    try
+    {
+        ASSERT_INIT();
+
+        QString filename = QFileInfo(_saveDocumentTask->url().toLocalFile()).fileName();
+
+        QSharedPointer<GenericErrorPresenter> errorPresenter = 
+            QSharedPointer<GenericErrorPresenter>(new GenericErrorPresenter());
+        errorPresenter->setException(_saveDocumentTask->error());
+
+        if (typeid(*_saveDocumentTask->error()) == typeid(FormatException))
+        {
+            //: Displayed after attempting to save a document to a file whose
+            //: format is not recognized or cannot be written.
+            //: %1 = the name of the file
+            errorPresenter->setMessage(qtTrId("ui.save-document.invalid-format-error")
+                .arg(filename));
+        }
+        else if (typeid(*_saveDocumentTask->error()) == typeid(FileException))
+        {
+            //: Displayed after attempting to save a document to a file that
+            //: could not be written, e.g., because permission was denied.
+            //: %1 = the file path
+            errorPresenter->setMessage(qtTrId("ui.save-document.file-error")
+                .arg(_saveDocumentTask->url().toLocalFile()));
+        }
+        else
+        {
+            ADDLE_THROW(*_saveDocumentTask->error());
+        }
+
+        emit error(errorPresenter);
+    }
+    ADDLE_SLOT_CATCH
+}
+
 void MainEditorPresenter::setCurrentTool(ToolId tool)
 {
     ASSERT_INIT(); 
     if (tool == _currentTool)
         return;
 
-    const auto& toolPresenters = _tools.value(_mode);
-    ADDLE_ASSERT(!tool || toolPresenters.contains(tool));
+    ADDLE_ASSERT(!tool || _tools.value(_mode).contains(tool));
 
     _currentTool = tool;
     auto previousTool = _currentToolPresenter;
-    _currentToolPresenter = toolPresenters.value(tool);
+    _currentToolPresenter = toolPresenter(tool);
     emit currentToolChanged(_currentTool);
     emit _currentToolPresenter->setSelected(true);
     if (previousTool)
         emit previousTool->setSelected(false);
 }
 
+QSharedPointer<IToolPresenter> MainEditorPresenter::toolPresenter(ToolId tool)
+{
+    ASSERT_INIT();
+    if (!tool || !_tools.value(_mode).contains(tool))
+        return nullptr;
+
+    if (tool == CoreTools::Brush)
+    {
+        if (!_brushTool)
+            _brushTool = ServiceLocator::makeShared<IBrushToolPresenter>(
+                this,
+                IBrushToolPresenter::Mode::Brush
+            );
+        return _brushTool;
+    }
+    else if (tool == CoreTools::Eraser)
+    {
+        if (!_eraserTool)
+            _eraserTool = ServiceLocator::makeShared<IBrushToolPresenter>(
+                this,
+                IBrushToolPresenter::Mode::Eraser
+            );
+        return _eraserTool;
+    }
+    else if (tool == CoreTools::Navigate)
+    {
+        if (!_navigateTool)
+            _navigateTool = ServiceLocator::makeShared<INavigateToolPresenter>(
+                this
+            );
+        return _navigateTool;
+    }
+    
+    return nullptr;
+}
+
 void LoadDocumentTask::doTask()
 {
     QUrl loadedUrl = url();
 
     if (loadedUrl.isLocalFile())
     {
-        QFile file(loadedUrl.toLocalFile());
+        // The load may have been superseded before it even began.
+        checkCancelled();
 
-        IOCheck().openFile(file, QIODevice::ReadWrite | QIODevice::ExistingOnly);
+        QSharedPointer<IDocument> doc;
+        if (const auto cache = browserCache())
+            doc = cache->document(loadedUrl.toLocalFile());
 
-        DocumentImportExportInfo info;
-        info.setFilename(loadedUrl.toLocalFile());
+        if (!doc)
+        {
+            // The file is mapped, so format drivers can decode it in place.
+            MappedFileDevice file(loadedUrl.toLocalFile());
+            file.open(QIODevice::ReadOnly);
+
+            DocumentImportExportInfo info;
+            info.setFilename(loadedUrl.toLocalFile());
+            info.setCancellationCheck([this]() { return isCancelRequested(); });
+
+            doc = QSharedPointer<IDocument>(ServiceLocator::get<IFormatService>().importModel(file, info));
+        }
+        checkCancelled();
 
-        auto doc = QSharedPointer<IDocument>(ServiceLocator::get<IFormatService>().importModel(file, info));
         setDocumentPresenter(ServiceLocator::makeShared<IDocumentPresenter>(doc));
     }
     else
@@ -343,4 +560,30 @@ void LoadDocumentTask::doTask()
         //% "Loading a document from a remote URL is not yet supported."
         ADDLE_LOGIC_ERROR_M(qtTrId("debug-messages.remote-url-not-supported"));
     }
+}
+
+void SaveDocumentTask::doTask()
+{
+    QUrl savedUrl = url();
+    QSharedPointer<const DocumentSnapshot> savedSnapshot = snapshot();
+
+    ADDLE_ASSERT(savedSnapshot);
+
+    if (savedUrl.isLocalFile())
+    {
+        QFile file(savedUrl.toLocalFile());
+
+        DocumentImportExportInfo info;
+        info.setFilename(savedUrl.toLocalFile());
+        info.setSnapshot(savedSnapshot);
+        info.setProgressCallback([this](double progress) { setProgress(progress); });
+
+        setProgress(0.0);
+        ServiceLocator::get<IFormatService>().exportSnapshot(file, info);
+    }
+    else
+    {
+        //% "Saving a document to a remote URL is not yet supported."
+        ADDLE_LOGIC_ERROR_M(qtTrId("debug-messages.remote-url-save-not-supported"));
+    }
 }
\ No newline at end of file
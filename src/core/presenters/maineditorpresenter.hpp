@@ -19,10 +19,13 @@
 #include <memory>
 
 #include "helpers/undostackhelper.hpp"
+#include "helpers/browserimagecache.hpp"
+#include "helpers/animationplayer.hpp"
 
 #include "interfaces/presenters/imaineditorpresenter.hpp"
 
 #include "utilities/asynctask.hpp"
+#include "utilities/model/documentsnapshot.hpp"
 #include "utilities/presenter/propertycache.hpp"
 
 #include "utilities/initializehelper.hpp"
@@ -47,7 +50,10 @@ class IEyedropToolPresenter;
 class INavigateToolPresenter;
 class IMeasureToolPresenter;
 
+class IDocument;
+
 class LoadDocumentTask;
+class SaveDocumentTask;
 
 class ADDLE_CORE_EXPORT MainEditorPresenter : public QObject, public virtual IMainEditorPresenter
 {
@@ -93,11 +99,22 @@ public:
 
     ICanvasPresenter& canvasPresenter() const { ASSERT_INIT_CHECKPOINT(InitCheck_CanvasPresenter); return *_canvasPresenter; }
     IViewPortPresenter& viewPortPresenter() const { ASSERT_INIT_CHECKPOINT(InitCheck_ViewPortPresenter); return *_viewPortPresenter; }
-    IColorSelectionPresenter& colorSelection() const { ASSERT_INIT_CHECKPOINT(InitCheck_ColorSelection); return *_colorSelection; }
+    IColorSelectionPresenter& colorSelection() const
+    {
+        // Only made in Editor mode.
+        ASSERT_INIT_CHECKPOINT(InitCheck_ColorSelection);
+        ADDLE_ASSERT(_colorSelection);
+        return *_colorSelection;
+    }
 
     void setMode(Mode mode);
     Mode mode() const { return _mode; }
 
+signals:
+    void modeChanged(IMainEditorPresenter::Mode mode);
+
+public:
+
     // # IHaveDocumentPresenter
 
     QSharedPointer<IDocumentPresenter> documentPresenter() const { ASSERT_INIT(); return _documentPresenter; }
@@ -113,11 +130,16 @@ signals:
 public slots:
     void newDocument();
     void loadDocument(QUrl url);
+    void saveDocument(QUrl url);
+
+    void browseNext() { try { ASSERT_INIT(); browse(1); } ADDLE_SLOT_CATCH }
+    void browsePrevious() { try { ASSERT_INIT(); browse(-1); } ADDLE_SLOT_CATCH }
 
 public:
     ToolId currentTool() const { ASSERT_INIT(); return _currentTool; }
     void setCurrentTool(ToolId tool);
-    QHash<ToolId, QSharedPointer<IToolPresenter>> tools() const { ASSERT_INIT(); return _tools.value(_mode); }
+    QList<ToolId> tools() const { ASSERT_INIT(); return _tools.value(_mode); }
+    QSharedPointer<IToolPresenter> toolPresenter(ToolId tool);
 
     QSharedPointer<IToolPresenter> currentToolPresenter() const { ASSERT_INIT(); return _currentToolPresenter; }
 
@@ -143,11 +165,24 @@ signals:
 private slots:
     void onLoadDocumentCompleted();
     void onLoadDocumentFailed();
+    void onSaveDocumentFailed();
 
 private:
     void setDocumentPresenter(QSharedPointer<IDocumentPresenter> document);
     bool isEmpty_p() const { return !_documentPresenter; }
 
+    // Starts loading `url`, superseding any load already in progress.
+    void startLoadDocumentTask(QUrl url);
+
+    void browse(int offset);
+
+    // Builds the presenters that are only needed for editing, if they have
+    // not been built already.
+    void initEditing();
+
+    // Plays the document's animation in Viewer mode, and pauses it otherwise.
+    void updateAnimation();
+
     Mode _mode = (Mode)NULL;
 
     std::unique_ptr<IMainEditorView> _view = nullptr;
@@ -170,11 +205,19 @@ private:
     QSharedPointer<INavigateToolPresenter> _navigateTool;
     QSharedPointer<IMeasureToolPresenter> _measureTool;
 
-    QHash<Mode, QHash<ToolId, QSharedPointer<IToolPresenter>>> _tools;
+    QHash<Mode, QList<ToolId>> _tools;
     ToolId _currentTool;
     QSharedPointer<IToolPresenter> _currentToolPresenter;
 
-    LoadDocumentTask* _loadDocumentTask;
+    LoadDocumentTask* _loadDocumentTask = nullptr;
+
+    // The most recently requested file, which browsing steps from, even if
+    // it has not finished loading.
+    QUrl _browsedUrl;
+    QSharedPointer<BrowserImageCache> _browserCache;
+
+    std::unique_ptr<AnimationPlayer> _animationPlayer;
+    SaveDocumentTask* _saveDocumentTask;
 
     UndoStackHelper _undoStackHelper;
 
@@ -198,6 +241,10 @@ public:
     QUrl url() const { const auto lock = lockIO(); return _url; }
     void setUrl(QUrl url) { const auto lock = lockIO(); _url = url; }
 
+    // If set, the document is taken from the cache when it is there.
+    QSharedPointer<BrowserImageCache> browserCache() const { const auto lock = lockIO(); return _browserCache; }
+    void setBrowserCache(QSharedPointer<BrowserImageCache> cache) { const auto lock = lockIO(); _browserCache = cache; }
+
     QSharedPointer<IDocumentPresenter> documentPresenter() const 
     { 
         const auto lock = lockIO();
@@ -215,8 +262,36 @@ private:
     }
 
     QUrl _url;
+    QSharedPointer<BrowserImageCache> _browserCache;
+
     QSharedPointer<IDocumentPresenter> _documentPresenter;
 };
 
+class SaveDocumentTask : public AsyncTask
+{
+    Q_OBJECT 
+public:
+    SaveDocumentTask(QObject* parent = nullptr)
+        : AsyncTask(parent)
+    {
+    }
+    virtual ~SaveDocumentTask() = default;
+
+    QUrl url() const { const auto lock = lockIO(); return _url; }
+    void setUrl(QUrl url) { const auto lock = lockIO(); _url = url; }
+
+    // Must be taken on the thread that owns the document, before the task is
+    // started.
+    QSharedPointer<const DocumentSnapshot> snapshot() const { const auto lock = lockIO(); return _snapshot; }
+    void setSnapshot(QSharedPointer<const DocumentSnapshot> snapshot) { const auto lock = lockIO(); _snapshot = snapshot; }
+
+protected:
+    void doTask();
+
+private:
+    QUrl _url;
+    QSharedPointer<const DocumentSnapshot> _snapshot;
+};
+
 } // namespace Addle
 #endif // MAINEDITORPRESENTER_HPP
\ No newline at end of file
@@ -58,6 +58,26 @@ void BrushToolPresenter::initialize(IMainEditorPresenter* owner, Mode mode)
         new BrushPreviewProvider(this)
     );
 
+    _hoverPreview = std::unique_ptr<HoverPreview>(new HoverPreview(*this));
+
+    connect_interface(_mainEditor, SIGNAL(documentPresenterChanged(QSharedPointer<IDocumentPresenter>)), this, SLOT(onDocumentChanged(QSharedPointer<IDocumentPresenter>)));
+    connect_interface(_canvas, SIGNAL(hasMouseChanged(bool)), this, SLOT(onCanvasHasMouseChanged(bool)));
+    connect_interface(_viewPort, SIGNAL(zoomChanged(double)), this, SLOT(onViewPortZoomChanged(double)));
+    connect_interface(_colorSelection, SIGNAL(color1Changed(ColorInfo)), this, SLOT(onColorChanged(ColorInfo)));
+    connect_interface(_mainEditor, SIGNAL(topSelectedLayerChanged(QSharedPointer<ILayerPresenter>)), this, SLOT(onSelectedLayerChanged()));
+}
+
+IAssetSelectionPresenter& BrushToolPresenter::brushSelection()
+{
+    ASSERT_INIT();
+    if (!_brushSelection)
+        initBrushSelection();
+
+    return *_brushSelection;
+}
+
+void BrushToolPresenter::initBrushSelection()
+{
     switch(_mode)
     {
     case Mode::Brush:
@@ -91,14 +111,7 @@ void BrushToolPresenter::initialize(IMainEditorPresenter* owner, Mode mode)
         break;
     }
 
-    _hoverPreview = std::unique_ptr<HoverPreview>(new HoverPreview(*this));
-
-    connect_interface(_mainEditor, SIGNAL(documentPresenterChanged(QSharedPointer<IDocumentPresenter>)), this, SLOT(onDocumentChanged(QSharedPointer<IDocumentPresenter>)));
-    connect_interface(_canvas, SIGNAL(hasMouseChanged(bool)), this, SLOT(onCanvasHasMouseChanged(bool)));
     connect_interface(_brushSelection.get(), SIGNAL(selectionChanged(QList<AddleId>)), this, SLOT(onBrushSelectionChanged()));
-    connect_interface(_viewPort, SIGNAL(zoomChanged(double)), this, SLOT(onViewPortZoomChanged(double)));
-    connect_interface(_colorSelection, SIGNAL(color1Changed(ColorInfo)), this, SLOT(onColorChanged(ColorInfo)));
-    connect_interface(_mainEditor, SIGNAL(topSelectedLayerChanged(QSharedPointer<ILayerPresenter>)), this, SLOT(onSelectedLayerChanged()));
 }
 
 ToolId BrushToolPresenter::id()
@@ -222,7 +235,7 @@ void BrushToolPresenter::onViewPortZoomChanged(double zoom)
 {
     try 
     {
-        if (selectedBrushPresenter())
+        if (_brushSelection && selectedBrushPresenter())
             selectedBrushPresenter()->sizeSelection().refreshPreviews();
         
         refreshPreviews();
@@ -352,6 +365,9 @@ void BrushToolPresenter::HoverPreview::update()
 {
     _ASSERT_INIT(_owner._initHelper);
 
+    // Nothing has been previewed if the brushes have not yet been built.
+    if (!_owner._brushSelection) return;
+
     BrushId id = _owner.selectedBrush();
     if (!id) return;
 
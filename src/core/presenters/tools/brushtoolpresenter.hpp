@@ -63,7 +63,7 @@ public:
     IMainEditorPresenter* owner() { ASSERT_INIT(); return _mainEditor; }
     ToolId id();
 
-    IAssetSelectionPresenter& brushSelection() { ASSERT_INIT(); return *_brushSelection; }
+    IAssetSelectionPresenter& brushSelection();
     void selectBrush(BrushId id) { brushSelection().select(id); }
     BrushId selectedBrush()
     {
@@ -105,6 +105,10 @@ private:
     void onDisengage();
     void onSelectedChanged(bool isSelected);
 
+    // Builds the brush selection, along with the presenters of its brushes.
+    // This is put off until the brush selection is first needed.
+    void initBrushSelection();
+
     bool _grace;
 
     Mode _mode = (Mode)NULL;
@@ -48,6 +48,24 @@ void NavigateToolPresenter::setNavigateOperation(NavigateToolPresenter::Navigate
     ADDLE_SLOT_CATCH
 }
 
+void NavigateToolPresenter::onEngage()
+{
+    try
+    {
+        _viewPort->setNavigating(true);
+    }
+    ADDLE_SLOT_CATCH
+}
+
+void NavigateToolPresenter::onDisengage()
+{
+    try
+    {
+        _viewPort->setNavigating(false);
+    }
+    ADDLE_SLOT_CATCH
+}
+
 void NavigateToolPresenter::onMove()
 {
     try
@@ -36,7 +36,9 @@ public:
         : _selectHelper(*this)
     {
         _mouseHelper.onMove.bind(&NavigateToolPresenter::onMove, this);
+        _mouseHelper.onEngage.bind(&NavigateToolPresenter::onEngage, this);
         _mouseHelper.onEngage.bind(&PropertyCache<QCursor>::recalculate, &_cache_cursor);
+        _mouseHelper.onDisengage.bind(&NavigateToolPresenter::onDisengage, this);
         _mouseHelper.onDisengage.bind(&PropertyCache<QCursor>::recalculate, &_cache_cursor);
 
         _cache_cursor.calculateBy(&NavigateToolPresenter::cursor_p, this);
@@ -68,7 +70,9 @@ signals:
     void cursorChanged(QCursor cursor);
 
 private:
+    void onEngage();
     void onMove();
+    void onDisengage();
     QCursor cursor_p();
 
     NavigateOperationOptions _operation = INavigateToolPresenterAux::DEFAULT_NAVIGATE_OPERATION_OPTION;
@@ -144,6 +144,20 @@ void ViewPortPresenter::setHasFocus(bool value)
     }
 }
 
+void ViewPortPresenter::setNavigating(bool navigating)
+{
+    try
+    {
+        ASSERT_INIT();
+        if (_isNavigating != navigating)
+        {
+            _isNavigating = navigating;
+            emit navigatingChanged(_isNavigating);
+        }
+    }
+    ADDLE_SLOT_CATCH
+}
+
 void ViewPortPresenter::setZoom(double zoom)
 {
     ASSERT_INIT();
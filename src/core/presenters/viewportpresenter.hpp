@@ -230,6 +230,8 @@ public:
     QPoint globalOffset() const { ASSERT_INIT(); return _globalOffset; }
     virtual QPointF center() const { ASSERT_INIT(); return _center; }
 
+    bool isNavigating() const { ASSERT_INIT(); return _isNavigating; }
+
 public slots:
     void resetTransforms();
     void fitWidth();
@@ -239,8 +241,11 @@ public slots:
 
     void setGlobalOffset(QPoint offset) { try { ASSERT_INIT(); _globalOffset = offset; } ADDLE_SLOT_CATCH }
 
+    void setNavigating(bool navigating);
+
 signals:
     void transformsChanged();
+    void navigatingChanged(bool navigating);
     void ontoCanvasTransformChanged(QTransform);
     void fromCanvasTransformChanged(QTransform);
 
@@ -266,6 +271,7 @@ private:
     PropertyCache<bool> _canZoomOutCache;
 
     bool _hasFocus = false;
+    bool _isNavigating = false;
 
     //The rotation of the viewport in degrees
     double _rotation = 0.0;
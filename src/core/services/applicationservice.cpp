@@ -8,6 +8,13 @@
 
 #include <QCoreApplication>
 #include <QCommandLineParser>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFileInfo>
+#include <QGuiApplication>
+#include <QLocalServer>
+#include <QLocalSocket>
 
 #include <QtDebug>
 #include <iostream>
@@ -16,6 +23,7 @@
 #include "utils.hpp"
 
 #include "applicationservice.hpp"
+#include "batchconverter.hpp"
 
 #include "servicelocator.hpp"
 
@@ -23,9 +31,12 @@
 #include "interfaces/presenters/imaineditorpresenter.hpp"
 #include "interfaces/views/imaineditorview.hpp"
 
+#include "utilities/cachemanager.hpp"
+#include "utilities/memorypressuremonitor.hpp"
 #include "utilities/qobject.hpp"
 #include "globals.hpp"
 #include "exceptions/commandlineexceptions.hpp"
+#include "utilities/debugging/startuptrace.hpp"
 
 #ifdef ADDLE_DEBUG
 #include "utilities/debugging/debugbehavior.hpp"
@@ -38,6 +49,8 @@ ApplicationService::~ApplicationService()
 
 bool ApplicationService::start()
 {
+    ADDLE_TRACE_STARTUP("ApplicationService::start");
+
 #ifdef ADDLE_DEBUG
     //% "Starting ApplicationService."
     qDebug() << qUtf8Printable(qtTrId("debug-messages.application-service.starting"));
@@ -68,13 +81,32 @@ bool ApplicationService::start()
 
     }
 
-    if (_startupMode == StartupMode::terminal)
+    if (_startupMode == StartupMode::batch)
+    {
+        _exitCode = _batchConverter->run();
+        quitting();
+        return false;
+    }
+    else if (_startupMode == StartupMode::terminal)
     {
         quitting();
         return false;
     }
     else
     {
+        if (!_newInstance)
+        {
+            bool noInstance = false;
+            if (forwardToRunningInstance(&noInstance))
+            {
+                _exitCode = 0;
+                quitting();
+                return false;
+            }
+
+            listenForInstances(noInstance);
+        }
+
         try
         {
             startGraphicalApplication();
@@ -119,48 +151,144 @@ bool ApplicationService::start()
     }
 }
 
-void ApplicationService::parseCommandLine()
+namespace {
+
+// The options understood on the command line, added to `parser` as they are
+// made. main() parses the command line with the same options, before the
+// application object is created, to tell whether it is a batch command.
+struct CommandLineOptions
 {
-    QStringList args = QCoreApplication::arguments();
+    CommandLineOptions(QCommandLineParser& parser)
+        : help(parser.addHelpOption()),
+        version(parser.addVersionOption()),
+        editor(
+            {
+                "e",
+                "editor"
+            },
+            //% "Explicitly start Addle in editor mode."
+            qtTrId("cli-messages.options.editor-mode-description")
+        ),
+        browser(
+            {
+                "b",
+                "browser"
+            },
+            //% "Explicitly start Addle in browser mode."
+            qtTrId("cli-messages.options.browser-mode-description")
+        ),
+        newInstance(
+            {
+                "n",
+                "new-instance"
+            },
+            //% "Start a new instance of Addle, rather than opening the file in one that is already running."
+            qtTrId("cli-messages.options.new-instance-description")
+        ),
+        to(
+            "to",
+            //% "(convert) The format to convert files to, by file extension, e.g., \"jpg\"."
+            qtTrId("cli-messages.options.to-description"),
+            //% "extension"
+            qtTrId("cli-messages.options.to-value")
+        ),
+        resize(
+            "resize",
+            //% "(convert) Resize images to fit within WIDTHxHEIGHT, or by PERCENT%."
+            qtTrId("cli-messages.options.resize-description"),
+            //% "size"
+            qtTrId("cli-messages.options.resize-value")
+        ),
+        output(
+            {
+                "o",
+                "output"
+            },
+            //% "(convert) The directory to write converted files to. By default, they are written alongside the originals."
+            qtTrId("cli-messages.options.output-description"),
+            //% "directory"
+            qtTrId("cli-messages.options.output-value")
+        ),
+        jobs(
+            {
+                "j",
+                "jobs"
+            },
+            //% "(convert) The number of files to convert at once. By default, one per processor core."
+            qtTrId("cli-messages.options.jobs-description"),
+            //% "count"
+            qtTrId("cli-messages.options.jobs-value")
+        ),
+        // Tracing is enabled in main(), before the command line is parsed here.
+        traceStartup(
+            StartupTrace::COMMAND_LINE_OPTION,
+            //% "Write a timeline of startup to the given file, in Chrome trace format."
+            qtTrId("cli-messages.options.trace-startup-description"),
+            //% "file"
+            qtTrId("cli-messages.options.trace-startup-value")
+        )
+    {
+        parser.addOption(editor);
+        parser.addOption(browser);
+        parser.addOption(newInstance);
+        parser.addOption(to);
+        parser.addOption(resize);
+        parser.addOption(output);
+        parser.addOption(jobs);
+        parser.addOption(traceStartup);
+
+        parser.addPositionalArgument(
+            //% "open"
+            qtTrId("cli-messages.options.open-name"),
+            //% "The file or url to open, or \"convert\" followed by files to convert."
+            qtTrId("cli-messages.options.open.description")
+        );
+    }
 
+    QCommandLineOption help;
+    QCommandLineOption version;
+    QCommandLineOption editor;
+    QCommandLineOption browser;
+    QCommandLineOption newInstance;
+    QCommandLineOption to;
+    QCommandLineOption resize;
+    QCommandLineOption output;
+    QCommandLineOption jobs;
+    QCommandLineOption traceStartup;
+};
+
+bool convertRequested(const QCommandLineParser& parser)
+{
+    return !parser.positionalArguments().isEmpty()
+        && parser.positionalArguments()[0] == IApplicationService::CONVERT_COMMAND;
+}
+
+} // namespace
+
+bool ApplicationService::isConvertCommand(const QStringList& arguments)
+{
     QCommandLineParser parser;
+    const CommandLineOptions options(parser);
 
-    parser.setApplicationDescription(qtTrId(ADDLE_TAGLINE_TRID));
+    return parser.parse(arguments) && convertRequested(parser);
+}
 
-    QCommandLineOption helpOption = parser.addHelpOption();
-    QCommandLineOption versionOption = parser.addVersionOption();
+void ApplicationService::parseCommandLine()
+{
+    ADDLE_TRACE_STARTUP("ApplicationService::parseCommandLine");
 
-    QCommandLineOption editorOption(
-        {
-            "e",
-            "editor"
-        }, 
-        //% "Explicitly start Addle in editor mode."
-        qtTrId("cli-messages.options.editor-mode-description")
-    );
-    parser.addOption(editorOption);
+    QStringList args = QCoreApplication::arguments();
 
-    QCommandLineOption browserOption(
-        {
-            "b",
-            "browser"
-        },
-        //% "Explicitly start Addle in browser mode."
-        qtTrId("cli-messages.options.browser-mode-description")
-    );
-    parser.addOption(browserOption);
+    QCommandLineParser parser;
 
-    parser.addPositionalArgument(
-        //% "open"
-        qtTrId("cli-messages.options.open-name"),
-        //% "The file or url to open."
-        qtTrId("cli-messages.options.open.description")
-    );
+    parser.setApplicationDescription(qtTrId(ADDLE_TAGLINE_TRID));
+
+    const CommandLineOptions options(parser);
 
     if (!parser.parse(args))
         ADDLE_THROW(CommandLineParserException(parser.errorText()));
 
-    if (parser.isSet(helpOption))
+    if (parser.isSet(options.help))
     {
         _startupMode = StartupMode::terminal;
         _exitCode = 0;
@@ -168,7 +296,7 @@ void ApplicationService::parseCommandLine()
         return;
     }
 
-    if (parser.isSet(versionOption))
+    if (parser.isSet(options.version))
     {
         _startupMode = StartupMode::terminal;
         _exitCode = 0;
@@ -179,6 +307,42 @@ void ApplicationService::parseCommandLine()
         return;
     }
 
+    if (convertRequested(parser))
+    {
+        if (parser.isSet(options.editor) || parser.isSet(options.browser))
+            ADDLE_THROW(MultipleStartModesException());
+
+        if (!parser.isSet(options.to))
+            ADDLE_THROW(CommandLineParserException(
+                //% "Missing option \"--to\" for \"convert\"."
+                qtTrId("cli-messages.convert.missing-to")
+            ));
+
+        _batchConverter = QSharedPointer<BatchConverter>(new BatchConverter(
+            parser.positionalArguments().mid(1),
+            parser.value(options.to)
+        ));
+
+        if (parser.isSet(options.resize) && !_batchConverter->parseResize(parser.value(options.resize)))
+            ADDLE_THROW(InvalidArgumentException("resize", parser.value(options.resize)));
+
+        if (parser.isSet(options.output))
+            _batchConverter->setOutputDirectory(parser.value(options.output));
+
+        if (parser.isSet(options.jobs))
+        {
+            bool ok;
+            const int jobs = parser.value(options.jobs).toInt(&ok);
+            if (!ok || jobs < 1)
+                ADDLE_THROW(InvalidArgumentException("jobs", parser.value(options.jobs)));
+
+            _batchConverter->setJobs(jobs);
+        }
+
+        _startupMode = StartupMode::batch;
+        return;
+    }
+
     if (!parser.positionalArguments().isEmpty())
     {
         QString openString = parser.positionalArguments()[0];
@@ -215,11 +379,13 @@ void ApplicationService::parseCommandLine()
         }
     }
 
-    if (parser.isSet(editorOption) && parser.isSet(browserOption))
+    _newInstance = parser.isSet(options.newInstance);
+
+    if (parser.isSet(options.editor) && parser.isSet(options.browser))
     {
         ADDLE_THROW(MultipleStartModesException());
     }
-    else if (parser.isSet(editorOption))
+    else if (parser.isSet(options.editor))
     {
         _startupMode = StartupMode::editor;
 
@@ -230,7 +396,7 @@ void ApplicationService::parseCommandLine()
         );
 #endif
     }
-    else if (parser.isSet(browserOption))
+    else if (parser.isSet(options.browser))
     {
         _startupMode = StartupMode::browser;
 
@@ -241,9 +407,9 @@ void ApplicationService::parseCommandLine()
         );
 #endif
     }
-    else if (!parser.isSet(editorOption) && !parser.isSet(browserOption))
+    else if (!parser.isSet(options.editor) && !parser.isSet(options.browser))
     {
-        if (_startingFilename.isNull() || _startingUrl.isEmpty())
+        if (_startingFilename.isNull() && _startingUrl.isEmpty())
         {
             _startupMode = StartupMode::editor;
 #ifdef ADDLE_DEBUG
@@ -268,23 +434,209 @@ void ApplicationService::parseCommandLine()
 
 void ApplicationService::startGraphicalApplication()
 {
-    IMainEditorPresenter* presenter;
-    //if (_startupMode == StartupMode::editor) always use editor view for now.
-    //{
-    presenter = ServiceLocator::make<IMainEditorPresenter>(IMainEditorPresenter::Editor);
+    ADDLE_TRACE_STARTUP("ApplicationService::startGraphicalApplication");
 
-    //}
+    if (auto application = qobject_cast<QGuiApplication*>(QCoreApplication::instance()))
+    {
+        connect(application, &QGuiApplication::applicationStateChanged,
+            this, &ApplicationService::onApplicationStateChanged);
+    }
 
+    _memoryPressureMonitor = new MemoryPressureMonitor(this);
+    connect(_memoryPressureMonitor, &MemoryPressureMonitor::pressure,
+        this, &ApplicationService::onMemoryPressure);
+
+    openMainEditor(_startupMode, startingUrl());
+}
+
+void ApplicationService::openMainEditor(StartupMode mode, QUrl url)
+{
+    // A file opened to be viewed starts in Viewer mode, which does without
+    // the editing presenters and UI until it is switched into Editor mode.
+    IMainEditorPresenter* presenter = ServiceLocator::make<IMainEditorPresenter>(
+        mode == StartupMode::browser ?
+            IMainEditorPresenter::Viewer :
+            IMainEditorPresenter::Editor
+    );
+
+    if (!url.isEmpty())
+        presenter->loadDocument(url);
+
+    presenter->view().show();
+}
+
+QUrl ApplicationService::startingUrl() const
+{
+    // Filenames are made absolute, so they can be forwarded to an instance
+    // with a different working directory.
     if (!_startingFilename.isNull())
+        return QUrl::fromLocalFile(QFileInfo(_startingFilename).absoluteFilePath());
+    else
+        return _startingUrl;
+}
+
+namespace {
+
+// The name of the running instance's socket. It is unique to the user, so
+// that launches are only forwarded between processes of the same user.
+QString instanceServerName()
+{
+    const QByteArray hash = QCryptographicHash::hash(
+        QDir::homePath().toUtf8(),
+        QCryptographicHash::Md5
+    ).toHex().left(16);
+
+    return QStringLiteral("addle-") + QString::fromLatin1(hash);
+}
+
+} // namespace
+
+bool ApplicationService::forwardToRunningInstance(bool* noInstance)
+{
+    ADDLE_TRACE_STARTUP("ApplicationService::forwardToRunningInstance");
+
+    QLocalSocket socket;
+    socket.connectToServer(instanceServerName());
+    if (!socket.waitForConnected(INSTANCE_TIMEOUT))
     {
-        presenter->loadDocument(QUrl::fromLocalFile(_startingFilename));
+        *noInstance = socket.error() == QLocalSocket::ServerNotFoundError
+            || socket.error() == QLocalSocket::ConnectionRefusedError;
+        return false;
     }
-    else if (!_startingUrl.isEmpty())
+
     {
-        presenter->loadDocument(_startingUrl);
+        QDataStream stream(&socket);
+        stream.setVersion(QDataStream::Qt_5_12);
+        stream << INSTANCE_PROTOCOL_VERSION << (qint32)_startupMode << startingUrl();
     }
 
-    presenter->view().show();
+    if (!socket.waitForBytesWritten(INSTANCE_TIMEOUT))
+        return false;
+
+    // Once the launch has been sent, the running instance will open it, even
+    // if it is too busy to acknowledge it in time. So this process does not
+    // start in its own right, or the launch would be opened twice.
+    socket.waitForReadyRead(INSTANCE_TIMEOUT);
+
+#ifdef ADDLE_DEBUG
+    qDebug() << qUtf8Printable(
+        //% "Forwarded startup to the running instance."
+        qtTrId("debug-messages.application-service.forwarded-to-instance")
+    );
+#endif
+
+    socket.disconnectFromServer();
+    return true;
+}
+
+void ApplicationService::listenForInstances(bool removeStale)
+{
+    ADDLE_TRACE_STARTUP("ApplicationService::listenForInstances");
+
+    const QString name = instanceServerName();
+
+    _instanceServer = new QLocalServer(this);
+    _instanceServer->setSocketOptions(QLocalServer::UserAccessOption);
+    connect(_instanceServer, &QLocalServer::newConnection, this, &ApplicationService::onInstanceConnection);
+
+    bool listening = _instanceServer->listen(name);
+    if (!listening && removeStale)
+    {
+        // Nothing was listening, so a socket left here is stale, e.g., from
+        // an instance that crashed. Otherwise it belongs to a running
+        // instance that could not be reached, and is left alone.
+        QLocalServer::removeServer(name);
+        listening = _instanceServer->listen(name);
+    }
+
+    if (!listening)
+    {
+#ifdef ADDLE_DEBUG
+        qDebug() << qUtf8Printable(
+            //% "Could not listen for other instances: %1"
+            qtTrId("debug-messages.application-service.instance-listen-error")
+                .arg(_instanceServer->errorString())
+        );
+#endif
+        delete _instanceServer;
+        _instanceServer = nullptr;
+    }
+}
+
+void ApplicationService::onInstanceConnection()
+{
+    try
+    {
+        while (QLocalSocket* socket = _instanceServer->nextPendingConnection())
+        {
+            connect(socket, &QLocalSocket::readyRead, this, &ApplicationService::onInstanceMessage);
+            connect(socket, &QLocalSocket::disconnected, socket, &QObject::deleteLater);
+        }
+    }
+    ADDLE_SLOT_CATCH
+}
+
+void ApplicationService::onInstanceMessage()
+{
+    try
+    {
+        QLocalSocket* socket = qobject_cast<QLocalSocket*>(sender());
+        if (!socket) return;
+
+        QDataStream stream(socket);
+        stream.setVersion(QDataStream::Qt_5_12);
+
+        // The message may arrive in pieces.
+        stream.startTransaction();
+
+        quint32 version;
+        qint32 mode;
+        QUrl url;
+        stream >> version >> mode >> url;
+
+        if (!stream.commitTransaction())
+            return;
+
+        if (version != INSTANCE_PROTOCOL_VERSION
+            || (mode != StartupMode::editor && mode != StartupMode::browser))
+        {
+            socket->disconnectFromServer();
+            return;
+        }
+
+#ifdef ADDLE_DEBUG
+        qDebug() << qUtf8Printable(
+            //% "Opening \"%1\" for another instance."
+            qtTrId("debug-messages.application-service.instance-open")
+                .arg(url.toString())
+        );
+#endif
+
+        openMainEditor((StartupMode)mode, url);
+
+        socket->write(QByteArrayLiteral("\x01"));
+        socket->flush();
+    }
+    ADDLE_SLOT_CATCH
+}
+
+void ApplicationService::onApplicationStateChanged(Qt::ApplicationState state)
+{
+    try
+    {
+        if (state == Qt::ApplicationSuspended)
+            CacheManager::releaseMemory();
+    }
+    ADDLE_SLOT_CATCH
+}
+
+void ApplicationService::onMemoryPressure()
+{
+    try
+    {
+        CacheManager::releaseMemory();
+    }
+    ADDLE_SLOT_CATCH
 }
 
 void ApplicationService::quitting()
@@ -12,10 +12,16 @@
 #include "compat.hpp"
 #include <QObject>
 #include <QUrl>
+#include <QStringList>
+#include <QSharedPointer>
 #include "interfaces/services/iapplicationsservice.hpp"
 
+class QLocalServer;
+
 namespace Addle {
 
+class BatchConverter;
+class MemoryPressureMonitor;
 class ADDLE_CORE_EXPORT ApplicationService : public QObject, public IApplicationService
 {
     Q_OBJECT
@@ -30,6 +36,11 @@ public:
 
     int exitCode() { return _exitCode; }
 
+    // Whether `arguments` (including the program name) are a batch command,
+    // which runs without a graphical interface. Parses them the same way as
+    // the service does once started, so options may come before the command.
+    static bool isConvertCommand(const QStringList& arguments);
+
     void registerMainEditorPresenter(IMainEditorPresenter* presenter);
     QSet<IMainEditorPresenter*> mainEditorPresenters() const { return _mainEditorPresenters; }
 
@@ -39,16 +50,55 @@ public slots:
 private slots:
     void onMainEditorPresenterDestroyed();
 
+    void onInstanceConnection();
+    void onInstanceMessage();
+
+    // The caches are emptied when the operating system reports low memory
+    // (see MemoryPressureMonitor), and on suspension, which mobile platforms
+    // send before they reclaim memory.
+    void onApplicationStateChanged(Qt::ApplicationState state);
+    void onMemoryPressure();
+
 private:
     void parseCommandLine();
     void startGraphicalApplication();
 
+    // Opens a main editor window in the given startup mode, and loads `url`
+    // into it if it is not empty.
+    void openMainEditor(StartupMode mode, QUrl url);
+
+    QUrl startingUrl() const;
+
+    // Single instance mode: a graphical launch first offers its arguments to
+    // an instance that is already running, through a local socket, and exits
+    // once the arguments are sent. Otherwise it becomes the running instance
+    // and listens for later launches.
+    //
+    // `noInstance` is set if no instance is listening at all, in which case a
+    // socket left behind (e.g., by an instance that crashed) may be removed
+    // so that this one can listen in its place.
+    bool forwardToRunningInstance(bool* noInstance);
+    void listenForInstances(bool removeStale);
+
+    // The time given to a running instance to accept a connection, and to
+    // acknowledge a forwarded launch.
+    static constexpr int INSTANCE_TIMEOUT = 1000; // ms
+
+    static constexpr quint32 INSTANCE_PROTOCOL_VERSION = 1;
+
+    QSharedPointer<BatchConverter> _batchConverter;
+
     QUrl _startingUrl;
     QString _startingFilename;
 
     StartupMode _startupMode;
     int _exitCode;
 
+    bool _newInstance = false;
+    QLocalServer* _instanceServer = nullptr;
+
+    MemoryPressureMonitor* _memoryPressureMonitor = nullptr;
+
     QSet<IMainEditorPresenter*> _mainEditorPresenters;
     QHash<QObject*, IMainEditorPresenter*> _mainEditorPresenters_byQObjects;
 };
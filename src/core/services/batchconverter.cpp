@@ -0,0 +1,379 @@
+/**
+ * Addle source code
+ * @file
+ * @copyright Copyright 2020 Eleanor Hawk
+ * @copyright Modification and distribution permitted under the terms of the
+ * MIT License. See "LICENSE" for full details.
+ */
+
+#include "batchconverter.hpp"
+
+#include <cmath>
+#include <iostream>
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QElapsedTimer>
+#include <QStringBuilder>
+#include <QRegularExpression>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+#include "servicelocator.hpp"
+#include "globals.hpp"
+
+#include "interfaces/models/idocument.hpp"
+#include "interfaces/format/iformatdriver.hpp"
+#include "interfaces/services/iformatservice.hpp"
+
+#include "utilities/model/documentsnapshot.hpp"
+
+#include "utilities/mappedfiledevice.hpp"
+#include "utilities/model/documentbuilder.hpp"
+#include "utils.hpp"
+
+using namespace Addle;
+
+namespace {
+
+// Scales the edges of `rect` by the given factors, so that adjacent
+// rects remain adjacent.
+QRect scaledRect(QRect rect, double scaleX, double scaleY)
+{
+    return QRect(
+        QPoint(
+            (int)std::round(rect.left() * scaleX),
+            (int)std::round(rect.top() * scaleY)
+        ),
+        QPoint(
+            (int)std::round((rect.right() + 1) * scaleX) - 1,
+            (int)std::round((rect.bottom() + 1) * scaleY) - 1
+        )
+    );
+}
+
+} // namespace
+
+BatchConverter::BatchConverter(QStringList inputs, QString targetSuffix)
+    : _inputs(inputs), _targetSuffix(targetSuffix)
+{
+    if (_targetSuffix.startsWith('.'))
+        _targetSuffix.remove(0, 1);
+}
+
+bool BatchConverter::parseResize(const QString& argument)
+{
+    static const QRegularExpression percentPattern(QStringLiteral("^(\\d+(?:\\.\\d+)?)%$"));
+    static const QRegularExpression sizePattern(QStringLiteral("^(\\d+)x(\\d+)$"));
+
+    QRegularExpressionMatch match = percentPattern.match(argument);
+    if (match.hasMatch())
+    {
+        const double percent = match.captured(1).toDouble();
+        if (percent <= 0) return false;
+
+        _scale = percent / 100.0;
+        _resizeTo = QSize();
+        return true;
+    }
+
+    match = sizePattern.match(argument);
+    if (match.hasMatch())
+    {
+        const QSize size(match.captured(1).toInt(), match.captured(2).toInt());
+        if (size.isEmpty()) return false;
+
+        _resizeTo = size;
+        _scale = 1.0;
+        return true;
+    }
+
+    return false;
+}
+
+int BatchConverter::run()
+{
+    bool formatSupported = false;
+    for (DocumentFormatId format : noDetach(ServiceLocator::getIds<IFormatDriver<IDocument>>()))
+    {
+        if (format.fileExtensions().contains(_targetSuffix, Qt::CaseInsensitive)
+            && ServiceLocator::get<IFormatDriver<IDocument>>(format).supportsExport())
+        {
+            formatSupported = true;
+            break;
+        }
+    }
+
+    if (!formatSupported)
+    {
+        std::cerr << qPrintable(
+            //% "The output format \"%1\" is not supported."
+            qtTrId("cli-messages.convert.unsupported-format").arg(_targetSuffix)
+        ) << std::endl;
+        return ErrorCodes::COMMAND_LINE_ERROR_CODE;
+    }
+
+    const QStringList inputs = expandInputs();
+    if (inputs.isEmpty())
+    {
+        std::cerr << qPrintable(
+            //% "No input files were found."
+            qtTrId("cli-messages.convert.no-inputs")
+        ) << std::endl;
+        return ErrorCodes::COMMAND_LINE_ERROR_CODE;
+    }
+
+    if (!_outputDirectory.isEmpty() && !QDir().mkpath(_outputDirectory))
+    {
+        std::cerr << qPrintable(
+            //% "The output directory \"%1\" could not be created."
+            qtTrId("cli-messages.convert.output-directory-failed").arg(_outputDirectory)
+        ) << std::endl;
+        return ErrorCodes::COMMAND_LINE_ERROR_CODE;
+    }
+
+    // Inputs with the same base name (e.g., a.png and a.gif) would be written
+    // to the same output, concurrently, so they are refused up front.
+    {
+        QHash<QString, QString> inputsByOutput;
+        bool collision = false;
+        for (const QString& input : inputs)
+        {
+            const QString output = QFileInfo(outputPath(input)).absoluteFilePath();
+
+            auto i = inputsByOutput.find(output);
+            if (i == inputsByOutput.end())
+            {
+                inputsByOutput.insert(output, input);
+                continue;
+            }
+
+            std::cerr << qPrintable(
+                //% "%1 and %2 would both be converted to %3."
+                qtTrId("cli-messages.convert.output-collision")
+                    .arg(*i)
+                    .arg(input)
+                    .arg(outputPath(input))
+            ) << std::endl;
+            collision = true;
+        }
+
+        if (collision)
+            return ErrorCodes::COMMAND_LINE_ERROR_CODE;
+    }
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(_jobs > 0 ? _jobs : qMax(QThread::idealThreadCount(), 1));
+
+    // The format service is created up front, rather than by whichever worker
+    // thread happens to need it first.
+    ServiceLocator::get<IFormatService>();
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QList<QFuture<Result>> futures;
+    futures.reserve(inputs.size());
+    for (const QString& input : inputs)
+        futures.append(QtConcurrent::run(&pool, [this, input]() { return convert(input); }));
+
+    int converted = 0;
+    qint64 pixels = 0;
+
+    // Results are reported in order, as they become available.
+    for (int i = 0; i < inputs.size(); ++i)
+    {
+        const Result result = futures[i].result();
+
+        if (result.success)
+        {
+            ++converted;
+            pixels += result.pixels;
+
+            std::cout << qPrintable(
+                //% "%1 -> %2: %3 ms (import %4 ms, transform %5 ms, export %6 ms)"
+                qtTrId("cli-messages.convert.file-result")
+                    .arg(result.input)
+                    .arg(result.output)
+                    .arg(result.importTime + result.transformTime + result.exportTime)
+                    .arg(result.importTime)
+                    .arg(result.transformTime)
+                    .arg(result.exportTime)
+            ) << std::endl;
+        }
+        else
+        {
+            std::cerr << qPrintable(
+                //% "%1: conversion failed: %2"
+                qtTrId("cli-messages.convert.file-error")
+                    .arg(result.input)
+                    .arg(result.error)
+            ) << std::endl;
+        }
+    }
+
+    const double seconds = qMax(timer.elapsed(), (qint64)1) / 1000.0;
+
+    std::cout << qPrintable(
+        //% "Converted %1 of %2 files in %3 s (%4 files/s, %5 megapixels/s)"
+        qtTrId("cli-messages.convert.summary")
+            .arg(converted)
+            .arg(inputs.size())
+            .arg(seconds, 0, 'f', 2)
+            .arg(converted / seconds, 0, 'f', 2)
+            .arg(pixels / 1.0e6 / seconds, 0, 'f', 2)
+    ) << std::endl;
+
+    return converted == inputs.size() ? 0 : ErrorCodes::UNKNOWN_ERROR_CODE;
+}
+
+BatchConverter::Result BatchConverter::convert(const QString& input) const
+{
+    Result result;
+    result.input = input;
+    result.output = outputPath(input);
+
+    if (QFileInfo(result.output) == QFileInfo(input))
+    {
+        //% "the output would overwrite the input."
+        result.error = qtTrId("cli-messages.convert.would-overwrite");
+        return result;
+    }
+
+    IFormatService& formatService = ServiceLocator::get<IFormatService>();
+
+    try
+    {
+        QElapsedTimer timer;
+        timer.start();
+
+        QSharedPointer<IDocument> document;
+        {
+            MappedFileDevice device(input);
+
+            DocumentImportExportInfo info;
+            info.setFilename(input);
+
+            document = formatService.importModel(device, info);
+        }
+        result.pixels = (qint64)document->size().width() * document->size().height();
+        result.importTime = timer.restart();
+
+        if (_resizeTo.isValid() || _scale != 1.0)
+        {
+            const DocumentSnapshot snapshot(*document);
+
+            const QSize size = snapshot.size();
+            const QSize target = _resizeTo.isValid() ?
+                size.scaled(_resizeTo, Qt::KeepAspectRatio) :
+                QSize(
+                    qMax(1, (int)std::round(size.width() * _scale)),
+                    qMax(1, (int)std::round(size.height() * _scale))
+                );
+
+            const double scaleX = size.isEmpty() ? 1.0 : (double)target.width() / size.width();
+            const double scaleY = size.isEmpty() ? 1.0 : (double)target.height() / size.height();
+
+            DocumentBuilder builder;
+            builder.setFilename(input);
+            builder.setBackgroundColor(snapshot.backgroundColor());
+            builder.setSize(target);
+
+            for (const LayerGroupInfo& group : snapshot.layerGroups())
+                builder.addLayerGroup(group);
+
+            for (const DocumentSnapshot::Layer& layer : snapshot.layers())
+            {
+                LayerBuilder layerBuilder;
+                layerBuilder.setName(layer.name);
+                layerBuilder.setOpacity(layer.opacity);
+                layerBuilder.setCompositionMode(layer.compositionMode);
+                layerBuilder.setGroupPath(layer.groupPath);
+
+                if (!layer.image.isNull())
+                {
+                    const QRect boundary = scaledRect(
+                        QRect(layer.offset, layer.image.size()),
+                        scaleX,
+                        scaleY
+                    );
+
+                    if (!boundary.isEmpty())
+                    {
+                        layerBuilder.setImage(layer.image.scaled(
+                            boundary.size(),
+                            Qt::IgnoreAspectRatio,
+                            Qt::SmoothTransformation
+                        ));
+                        layerBuilder.setBoundary(boundary);
+                    }
+                }
+
+                builder.addLayer(layerBuilder);
+            }
+
+            document = QSharedPointer<IDocument>(ServiceLocator::make<IDocument>(builder));
+            result.pixels = (qint64)target.width() * target.height();
+        }
+        result.transformTime = timer.restart();
+
+        {
+            QFile device(result.output);
+
+            DocumentImportExportInfo info;
+            info.setFilename(result.output);
+
+            formatService.exportModel(*document, device, info);
+        }
+        result.exportTime = timer.elapsed();
+
+        result.success = true;
+    }
+    catch (const std::exception& ex)
+    {
+        result.error = QString::fromUtf8(ex.what());
+        if (result.error.isEmpty())
+        {
+            //% "an error occurred."
+            result.error = qtTrId("cli-messages.convert.unknown-error");
+        }
+    }
+
+    return result;
+}
+
+QStringList BatchConverter::expandInputs() const
+{
+    QStringList result;
+    for (const QString& input : _inputs)
+    {
+        const QFileInfo info(input);
+        if (!info.fileName().contains(QRegularExpression(QStringLiteral("[*?\\[]"))))
+        {
+            result.append(input);
+            continue;
+        }
+
+        const QDir dir = info.dir();
+        const QStringList matches = dir.entryList(
+            { info.fileName() },
+            QDir::Files | QDir::Readable,
+            QDir::Name
+        );
+
+        for (const QString& match : matches)
+            result.append(dir.filePath(match));
+    }
+    return result;
+}
+
+QString BatchConverter::outputPath(const QString& input) const
+{
+    const QFileInfo info(input);
+    const QDir dir = _outputDirectory.isEmpty() ? info.dir() : QDir(_outputDirectory);
+
+    return dir.filePath(info.completeBaseName() % '.' % _targetSuffix);
+}
@@ -0,0 +1,89 @@
+/**
+ * Addle source code
+ * @file
+ * @copyright Copyright 2020 Eleanor Hawk
+ * @copyright Modification and distribution permitted under the terms of the
+ * MIT License. See "LICENSE" for full details.
+ */
+
+#ifndef BATCHCONVERTER_HPP
+#define BATCHCONVERTER_HPP
+
+#include "compat.hpp"
+
+#include <QString>
+#include <QStringList>
+#include <QSize>
+
+namespace Addle {
+
+/**
+ * Converts image files from one format to another without a graphical
+ * interface, e.g., `addle convert *.png --to jpg --resize 50%`.
+ *
+ * Each file is imported, optionally resized, and exported through
+ * IFormatService. Files are converted in parallel on a thread pool of the
+ * converter's own, so that the number of jobs does not limit the global pool
+ * used by the format drivers and raster kernels. The time taken for each (and the total throughput) is reported on
+ * standard output.
+ */
+class ADDLE_CORE_EXPORT BatchConverter
+{
+public:
+    struct Result
+    {
+        QString input;
+        QString output;
+        bool success = false;
+        QString error;
+
+        qint64 pixels = 0;
+
+        // In milliseconds
+        qint64 importTime = 0;
+        qint64 transformTime = 0;
+        qint64 exportTime = 0;
+    };
+
+    // Input paths may contain wildcards, which are expanded if the shell did
+    // not already do so.
+    BatchConverter(QStringList inputs, QString targetSuffix);
+
+    // A null size and scale of 1.0 (the default) mean no resizing. Otherwise
+    // documents are scaled to fit within `size`, or scaled by `scale`.
+    void setResize(QSize size) { _resizeTo = size; }
+    void setScale(double scale) { _scale = scale; }
+
+    // If not set, files are written alongside their inputs.
+    void setOutputDirectory(QString directory) { _outputDirectory = directory; }
+
+    // The number of files converted at once. If 0, one per core.
+    void setJobs(int jobs) { _jobs = jobs; }
+
+    // Parses the argument of the --resize option: either WIDTHxHEIGHT or
+    // PERCENT%. Returns false if the argument is not understood.
+    bool parseResize(const QString& argument);
+
+    // Runs the conversion and returns the exit code for the application.
+    int run();
+
+    // Converts one file. Safe to call from any thread.
+    Result convert(const QString& input) const;
+
+private:
+    QStringList expandInputs() const;
+    QString outputPath(const QString& input) const;
+
+    QStringList _inputs;
+    QString _targetSuffix;
+    QString _outputDirectory;
+
+    QSize _resizeTo;
+    double _scale = 1.0;
+
+    int _jobs = 0;
+};
+
+} // namespace Addle
+
+#endif // BATCHCONVERTER_HPP
@@ -14,11 +14,14 @@
 #include <typeinfo>
 #include <algorithm>
 #include <QSharedPointer>
+#include <QDir>
+#include <QSaveFile>
 
 #include "globals.hpp"
 
 #include "servicelocator.hpp"
 #include "exceptions/formatexception.hpp"
+#include "exceptions/fileexception.hpp"
 #include "utilities/iocheck.hpp"
 #include "utilities/errors.hpp"
 
@@ -35,29 +38,36 @@ GenericFormatModel FormatService::importModel_p(QIODevice& device, const Generic
     ADDLE_ASSERT(_formats_byModelType.contains(modelTypeIndex));
 
     QFile* file = qobject_cast<QFile*>(&device);
-    if (file)
+    if (file && !file->isOpen())
     {
         ADDLE_ASSERT(info.fileInfo() != QFileInfo());
         IOCheck().openFile(*file, QIODevice::ReadOnly);
-        if (file->size() == 0)
-            ADDLE_THROW(
-                FormatException(FormatException::EmptyResource,
-                GenericFormatId(),
-                info)
-            );
     }
-    else
+    else if (!device.isOpen())
     {
-        //TODO
-        ADDLE_LOGIC_ERROR_M("Only file devices are currently supported by FormatService.");
+        // e.g., a QBuffer or MappedFileDevice. Sequential devices such as
+        // pipes and stdin are expected to be open already.
+        device.open(QIODevice::ReadOnly);
     }
+    ADDLE_ASSERT(device.isReadable());
+
+    // Only the prefix is read, and on sequential devices it remains in the
+    // device's own read buffer for the driver.
+    const QByteArray prefix = peekPrefix(device);
+
+    if (prefix.isEmpty())
+        ADDLE_THROW(
+            FormatException(FormatException::EmptyResource,
+            GenericFormatId(),
+            info)
+        );
 
     GenericFormatId impliedBySuffix = _formats_bySuffix.value(info.fileInfo().completeSuffix());
 
     GenericFormatId format;
     if (
         (format = info.format()) ||
-        (format = inferFormatFromSignature(device)) ||
+        (format = inferFormatFromSignature(prefix)) ||
         (format = impliedBySuffix)
     )
     {
@@ -78,15 +88,101 @@ GenericFormatModel FormatService::importModel_p(QIODevice& device, const Generic
     }
 }
 
-GenericFormatId FormatService::inferFormatFromSignature(QIODevice& device)
+void FormatService::exportModel_p(GenericFormatModel model, QIODevice& device, const GenericImportExportInfo& info)
+{
+    std::type_index modelTypeIndex(info.modelType());
+
+    ADDLE_ASSERT(_formats_byModelType.contains(modelTypeIndex));
+
+    // The driver is found before anything is opened, so that nothing is
+    // created or changed for a format that can't be saved.
+    GenericFormatId format;
+    if (!(
+        (format = info.format()) ||
+        (format = _formats_bySuffix.value(info.fileInfo().completeSuffix()))
+    ))
+    {
+        ADDLE_THROW(FormatException(FormatException::FormatNotRecognized, GenericFormatId(), info));
+    }
+
+    if(!_drivers_byFormat.contains(format))
+        ADDLE_THROW(FormatException(FormatException::WrongModelType, format, info));
+
+    GenericFormatDriver driver = _drivers_byFormat.value(format);
+
+    // Not every format that can be opened can be saved, e.g., GIF.
+    if (!driver.supportsExport())
+        ADDLE_THROW(FormatException(FormatException::EncodingFailed, format, info));
+
+    QFile* file = qobject_cast<QFile*>(&device);
+    if (file && !file->isOpen())
+    {
+        ADDLE_ASSERT(info.fileInfo() != QFileInfo());
+
+        if (driver.opensFiles())
+        {
+            driver.exportModel(model, device, info);
+            return;
+        }
+
+        // The export is written to a temporary file, which replaces the
+        // original only once it is complete. If the driver fails or is
+        // cancelled, the original is left as it was.
+        QDir().mkpath(QFileInfo(file->fileName()).absolutePath());
+
+        QSaveFile saveFile(file->fileName());
+        if (!saveFile.open(QIODevice::WriteOnly))
+        {
+            ADDLE_THROW(FileException(
+                FileException::OpenWriteOnly,
+                FileException::UnknownProblem,
+                QFileInfo(file->fileName())
+            ));
+        }
+
+        driver.exportModel(model, saveFile, info);
+
+        if (!saveFile.commit())
+        {
+            ADDLE_THROW(FileException(
+                FileException::Move,
+                FileException::UnknownProblem,
+                QFileInfo(file->fileName())
+            ));
+        }
+        return;
+    }
+    else if (!device.isOpen())
+    {
+        device.open(QIODevice::WriteOnly);
+    }
+    ADDLE_ASSERT(device.isWritable());
+
+    driver.exportModel(model, device, info);
+}
+
+QByteArray FormatService::peekPrefix(QIODevice& device)
 {
-    if (device.isSequential())
-        return GenericFormatId();
+    const int length = qMax(_maxSignatureLength, 1);
+
+    QByteArray prefix = IOCheck().peek(device, length);
 
-    const QByteArray peek = IOCheck().peek(device, _maxSignatureLength);
+    // Data may still be arriving on a sequential device, e.g., a pipe.
+    while (prefix.size() < length
+        && device.isSequential()
+        && device.waitForReadyRead(SEQUENTIAL_PREFIX_TIMEOUT))
+    {
+        prefix = IOCheck().peek(device, length);
+    }
+
+    return prefix;
+}
+
+GenericFormatId FormatService::inferFormatFromSignature(const QByteArray& prefix)
+{
     QByteArray sniff;
-    sniff.reserve(peek.size());
-    for (char c : peek)
+    sniff.reserve(prefix.size());
+    for (char c : prefix)
     {
         sniff.append(c);
         if (_formats_bySignature.contains(sniff))
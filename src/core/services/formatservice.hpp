@@ -30,6 +30,7 @@ public:
 
 protected:
     GenericFormatModel importModel_p(QIODevice& device, const GenericImportExportInfo& info);
+    void exportModel_p(GenericFormatModel model, QIODevice& device, const GenericImportExportInfo& info);
 
 private:
     template <class ModelType>
@@ -41,9 +42,15 @@ private:
     QHash<std::type_index, QSet<GenericFormatId>> _formats_byModelType;
     QHash<GenericFormatId, GenericFormatDriver> _drivers_byFormat;
 
-    GenericFormatId inferFormatFromSignature(QIODevice& device);
+    // Reads the first bytes of the device, enough for any file signature,
+    // without consuming them.
+    QByteArray peekPrefix(QIODevice& device);
+    GenericFormatId inferFormatFromSignature(const QByteArray& prefix);
 
     int _maxSignatureLength = 0;
+
+    // How long to wait for the prefix of a sequential device, in ms.
+    static constexpr int SEQUENTIAL_PREFIX_TIMEOUT = 5000;
 };
 
 } // namespace Addle
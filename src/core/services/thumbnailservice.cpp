@@ -0,0 +1,279 @@
+/**
+ * Addle source code
+ * @file
+ * @copyright Copyright 2020 Eleanor Hawk
+ * @copyright Modification and distribution permitted under the terms of the
+ * MIT License. See "LICENSE" for full details.
+ */
+
+#include "thumbnailservice.hpp"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QImageWriter>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QUrl>
+
+#include "servicelocator.hpp"
+
+#include "interfaces/models/idocument.hpp"
+#include "interfaces/services/iformatservice.hpp"
+
+#include "utilities/model/documentsnapshot.hpp"
+
+#include "utilities/mappedfiledevice.hpp"
+
+using namespace Addle;
+
+namespace {
+
+const QString KEY_URI = QStringLiteral("Thumb::URI");
+const QString KEY_MTIME = QStringLiteral("Thumb::MTime");
+const QString KEY_SIZE = QStringLiteral("Thumb::Size");
+const QString KEY_WIDTH = QStringLiteral("Thumb::Image::Width");
+const QString KEY_HEIGHT = QStringLiteral("Thumb::Image::Height");
+const QString KEY_SOFTWARE = QStringLiteral("Software");
+
+// The subdirectory for failures is named for the application, per the
+// specification.
+const QString FAILURE_DIR = QStringLiteral("fail/addle");
+
+QString uriOf(const QFileInfo& info)
+{
+    return QUrl::fromLocalFile(info.absoluteFilePath()).toString(QUrl::FullyEncoded);
+}
+
+QString directoryName(IThumbnailService::Size size)
+{
+    switch (size)
+    {
+    case IThumbnailService::Normal:
+        return QStringLiteral("normal");
+    case IThumbnailService::Large:
+        return QStringLiteral("large");
+    case IThumbnailService::XLarge:
+        return QStringLiteral("x-large");
+    case IThumbnailService::XXLarge:
+    default:
+        return QStringLiteral("xx-large");
+    }
+}
+
+// Whether the thumbnail being read by `reader` describes the file as it is
+// now. Only the PNG's text chunks are read.
+bool isCurrent(QImageReader& reader, const QString& uri, const QFileInfo& info)
+{
+    if (reader.text(KEY_URI) != uri)
+        return false;
+
+    if (reader.text(KEY_MTIME) != QString::number(info.lastModified().toSecsSinceEpoch()))
+        return false;
+
+    // Thumb::Size is optional.
+    const QString size = reader.text(KEY_SIZE);
+    return size.isEmpty() || size == QString::number(info.size());
+}
+
+// Writes the image atomically, readable only by the user.
+bool writePng(const QString& path, const QImage& image)
+{
+    const QFileInfo info(path);
+    if (!QDir().mkpath(info.absolutePath()))
+        return false;
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    QImageWriter writer(&file, "png");
+    if (!writer.write(image) || !file.commit())
+        return false;
+
+    QFile::setPermissions(path, QFileDevice::ReadOwner | QFileDevice::WriteOwner);
+    return true;
+}
+
+} // namespace
+
+ThumbnailService::ThumbnailService()
+{
+    _cacheDir = QDir(
+        QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation)
+    ).filePath(QStringLiteral("thumbnails"));
+
+    // The specification asks for the thumbnail directory to be private.
+    if (QDir().mkpath(_cacheDir))
+    {
+        QFile::setPermissions(
+            _cacheDir,
+            QFileDevice::ReadOwner | QFileDevice::WriteOwner | QFileDevice::ExeOwner
+        );
+    }
+}
+
+ThumbnailService::~ThumbnailService()
+{
+    _tasks.clear();
+    _tasks.waitForDone();
+}
+
+QImage ThumbnailService::cachedThumbnail(const QString& filename, Size size) const
+{
+    const QFileInfo info(filename);
+    if (!info.isFile())
+        return QImage();
+
+    QImageReader reader(thumbnailPath(uriOf(info), size), "png");
+    if (!reader.canRead() || !isCurrent(reader, uriOf(info), info))
+        return QImage();
+
+    return reader.read();
+}
+
+void ThumbnailService::requestThumbnail(const QString& filename, Size size)
+{
+    const QString path = QFileInfo(filename).absoluteFilePath();
+    {
+        const QMutexLocker lock(&_pendingMutex);
+        if (_pending.contains(qMakePair(path, (int)size)))
+            return;
+
+        _pending.insert(qMakePair(path, (int)size));
+    }
+
+    // Created here rather than by whichever worker needs it first.
+    ServiceLocator::get<IFormatService>();
+
+    // Later requests are given higher priority, so a view that scrolls
+    // through many files has the ones now visible served first.
+    _tasks.start([this, path, size]() {
+        QImage thumbnail = cachedThumbnail(path, size);
+        if (thumbnail.isNull())
+            thumbnail = generate(path, size);
+
+        QMetaObject::invokeMethod(
+            this,
+            [this, path, size, thumbnail]() { finish(path, size, thumbnail); },
+            Qt::QueuedConnection
+        );
+    }, ++_sequence);
+}
+
+void ThumbnailService::cancelRequests()
+{
+    _tasks.clear();
+
+    // Requests that had already started are still reported.
+    const QMutexLocker lock(&_pendingMutex);
+    _pending.clear();
+}
+
+void ThumbnailService::finish(const QString& filename, Size size, QImage thumbnail)
+{
+    {
+        const QMutexLocker lock(&_pendingMutex);
+        _pending.remove(qMakePair(filename, (int)size));
+    }
+
+    if (thumbnail.isNull())
+        emit thumbnailFailed(filename, size);
+    else
+        emit thumbnailReady(filename, size, thumbnail);
+}
+
+QImage ThumbnailService::generate(const QString& filename, Size size) const
+{
+    const QFileInfo info(filename);
+    const QString uri = uriOf(info);
+
+    // Thumbnails are not made of thumbnails.
+    if (info.absoluteFilePath().startsWith(_cacheDir + '/'))
+        return QImage();
+
+    {
+        QImageReader failure(failurePath(uri), "png");
+        if (failure.canRead() && isCurrent(failure, uri, info))
+            return QImage();
+    }
+
+    QImage image;
+    QSize originalSize;
+
+    QImageReader reader(filename);
+    reader.setAutoTransform(true);
+    if (reader.canRead())
+    {
+        // Formats that support it (e.g., JPEG) decode directly at the reduced
+        // size, which is much cheaper than decoding in full.
+        originalSize = reader.size();
+        if (originalSize.isValid()
+            && (originalSize.width() > size || originalSize.height() > size))
+        {
+            reader.setScaledSize(originalSize.scaled(size, size, Qt::KeepAspectRatio));
+        }
+
+        image = reader.read();
+    }
+    else
+    {
+        // Formats Qt does not read, such as OpenRaster and Addle's own, are
+        // imported and composited.
+        try
+        {
+            MappedFileDevice device(filename);
+
+            DocumentImportExportInfo importInfo;
+            importInfo.setFilename(filename);
+
+            auto document = ServiceLocator::get<IFormatService>().importModel(device, importInfo);
+            image = DocumentSnapshot(*document).composite();
+            originalSize = image.size();
+        }
+        catch (const std::exception&)
+        {
+        }
+    }
+
+    if (image.isNull())
+    {
+        QImage failure(1, 1, QImage::Format_ARGB32);
+        failure.fill(Qt::transparent);
+        failure.setText(KEY_URI, uri);
+        failure.setText(KEY_MTIME, QString::number(info.lastModified().toSecsSinceEpoch()));
+        failure.setText(KEY_SOFTWARE, QStringLiteral("Addle"));
+
+        writePng(failurePath(uri), failure);
+        return QImage();
+    }
+
+    if (image.width() > size || image.height() > size)
+        image = image.scaled(size, size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+
+    image.setText(KEY_URI, uri);
+    image.setText(KEY_MTIME, QString::number(info.lastModified().toSecsSinceEpoch()));
+    image.setText(KEY_SIZE, QString::number(info.size()));
+    if (originalSize.isValid())
+    {
+        image.setText(KEY_WIDTH, QString::number(originalSize.width()));
+        image.setText(KEY_HEIGHT, QString::number(originalSize.height()));
+    }
+    image.setText(KEY_SOFTWARE, QStringLiteral("Addle"));
+
+    writePng(thumbnailPath(uri, size), image);
+    return image;
+}
+
+QString ThumbnailService::thumbnailPath(const QString& uri, Size size) const
+{
+    const QByteArray hash = QCryptographicHash::hash(uri.toUtf8(), QCryptographicHash::Md5).toHex();
+    return QDir(_cacheDir).filePath(directoryName(size) + '/' + QString::fromLatin1(hash) + QStringLiteral(".png"));
+}
+
+QString ThumbnailService::failurePath(const QString& uri) const
+{
+    const QByteArray hash = QCryptographicHash::hash(uri.toUtf8(), QCryptographicHash::Md5).toHex();
+    return QDir(_cacheDir).filePath(FAILURE_DIR + '/' + QString::fromLatin1(hash) + QStringLiteral(".png"));
+}
@@ -0,0 +1,74 @@
+/**
+ * Addle source code
+ * @file
+ * @copyright Copyright 2020 Eleanor Hawk
+ * @copyright Modification and distribution permitted under the terms of the
+ * MIT License. See "LICENSE" for full details.
+ */
+
+#ifndef THUMBNAILSERVICE_HPP
+#define THUMBNAILSERVICE_HPP
+
+#include "compat.hpp"
+
+#include <QObject>
+#include <QMutex>
+#include <QPair>
+#include <QSet>
+
+#include "utilities/taskscheduler.hpp"
+
+#include "interfaces/services/ithumbnailservice.hpp"
+
+namespace Addle {
+
+/**
+ * Stores thumbnails following the freedesktop.org thumbnail specification:
+ * a thumbnail is a PNG named for the MD5 hash of the file's URI, in a
+ * directory for its size under `$XDG_CACHE_HOME/thumbnails`. It records the
+ * URI, modification time and size of the file, and is stale once these no
+ * longer match.
+ *
+ * Files that cannot be thumbnailed are recorded as failures, so that they are
+ * not tried again until they change.
+ */
+class ADDLE_CORE_EXPORT ThumbnailService : public QObject, public IThumbnailService
+{
+    Q_OBJECT
+    Q_INTERFACES(Addle::IThumbnailService)
+    IAMQOBJECT_IMPL
+
+public:
+    ThumbnailService();
+    virtual ~ThumbnailService();
+
+    QImage cachedThumbnail(const QString& filename, Size size = Normal) const;
+    void requestThumbnail(const QString& filename, Size size = Normal);
+    void cancelRequests();
+
+signals:
+    void thumbnailReady(QString filename, int size, QImage thumbnail);
+    void thumbnailFailed(QString filename, int size);
+
+private:
+    // Generates and stores a thumbnail. Runs in the Background lane of
+    // TaskScheduler.
+    QImage generate(const QString& filename, Size size) const;
+
+    void finish(const QString& filename, Size size, QImage thumbnail);
+
+    QString thumbnailPath(const QString& uri, Size size) const;
+    QString failurePath(const QString& uri) const;
+
+    QString _cacheDir;
+    TaskGroup _tasks { TaskScheduler::Background };
+
+    int _sequence = 0;
+
+    QMutex _pendingMutex;
+    QSet<QPair<QString, int>> _pending;
+};
+
+} // namespace Addle
+
+#endif // THUMBNAILSERVICE_HPP
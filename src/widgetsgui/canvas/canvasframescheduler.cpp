@@ -0,0 +1,133 @@
+/**
+ * Addle source code
+ * @file
+ * @copyright Copyright 2020 Eleanor Hawk
+ * @copyright Modification and distribution permitted under the terms of the
+ * MIT License. See "LICENSE" for full details.
+ */
+
+#include "canvasframescheduler.hpp"
+#include "layeritem.hpp"
+
+#include <QGuiApplication>
+#include <QScreen>
+
+using namespace Addle;
+
+CanvasFrameScheduler::CanvasFrameScheduler(QObject* parent)
+    : QObject(parent)
+{
+    _timer.setTimerType(Qt::PreciseTimer);
+    connect(&_timer, &QTimer::timeout, this, &CanvasFrameScheduler::onFrame);
+
+    QScreen* screen = QGuiApplication::primaryScreen();
+    if (screen)
+    {
+        connect(screen, &QScreen::refreshRateChanged, this, &CanvasFrameScheduler::updateFrameInterval);
+    }
+    updateFrameInterval();
+}
+
+void CanvasFrameScheduler::invalidate(LayerItem* item, QRect area)
+{
+    if (!item || area.isEmpty()) return;
+
+    if (!_dirty.contains(item))
+        _queue.append(item);
+
+    _dirty[item].add(area);
+    schedule();
+}
+
+void CanvasFrameScheduler::remove(LayerItem* item)
+{
+    _dirty.remove(item);
+    _queue.removeAll(item);
+}
+
+void CanvasFrameScheduler::schedule()
+{
+    if (_timer.isActive()) return;
+
+    // Coming out of idle, the first frame is presented as soon as possible,
+    // and subsequent frames are paced at the display's refresh interval.
+    _frameClock.invalidate();
+    _timer.start(0);
+}
+
+void CanvasFrameScheduler::onFrame()
+{
+    if (_frameClock.isValid())
+        recordFrameTime((double)_frameClock.nsecsElapsed() / 1000000);
+    _frameClock.start();
+
+    qint64 budget = _pixelBudget;
+    int count = _queue.size();
+
+    // Items are visited round-robin so that one layer with a large backlog
+    // can't starve the others. Every visited item gets at least one rect per
+    // frame.
+    while (budget > 0 && count > 0)
+    {
+        --count;
+        LayerItem* item = _queue.takeFirst();
+
+        DirtyRegion& dirty = _dirty[item];
+        const QRegion region = dirty.take();
+
+        QRegion deferred;
+        for (QRect rect : region)
+        {
+            if (budget > 0)
+            {
+                item->update(rect);
+                budget -= (qint64)rect.width() * rect.height();
+            }
+            else
+            {
+                deferred += rect;
+                _stats.deferredPixels += (qint64)rect.width() * rect.height();
+            }
+        }
+
+        if (deferred.isEmpty())
+        {
+            _dirty.remove(item);
+        }
+        else
+        {
+            dirty.add(deferred);
+            _queue.append(item);
+        }
+    }
+
+    _stats.frames++;
+    emit frameFinished();
+
+    if (_queue.isEmpty())
+        _timer.stop();
+    else
+        _timer.setInterval(qRound(_frameInterval));
+}
+
+void CanvasFrameScheduler::recordFrameTime(double elapsed)
+{
+    _frameTimeTotal += elapsed;
+    _measuredFrames++;
+    _stats.averageFrameTime = _frameTimeTotal / _measuredFrames;
+    _stats.worstFrameTime = qMax(_stats.worstFrameTime, elapsed);
+
+    // A frame counts as dropped if the tick after it arrived later than
+    // one and a half refresh intervals.
+    if (elapsed > _frameInterval * 1.5)
+        _stats.droppedFrames += qRound(elapsed / _frameInterval) - 1;
+}
+
+void CanvasFrameScheduler::updateFrameInterval()
+{
+    QScreen* screen = QGuiApplication::primaryScreen();
+    if (screen && screen->refreshRate() > 1.0)
+        _frameInterval = 1000.0 / screen->refreshRate();
+    else
+        _frameInterval = 1000.0 / 60;
+}
@@ -0,0 +1,98 @@
+/**
+ * Addle source code
+ * @file
+ * @copyright Copyright 2020 Eleanor Hawk
+ * @copyright Modification and distribution permitted under the terms of the
+ * MIT License. See "LICENSE" for full details.
+ */
+
+#ifndef CANVASFRAMESCHEDULER_HPP
+#define CANVASFRAMESCHEDULER_HPP
+
+#include "compat.hpp"
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+
+#include "utilities/render/dirtyregion.hpp"
+
+namespace Addle {
+
+class LayerItem;
+
+/**
+ * Paces repaints of the canvas to the display's refresh rate.
+ *
+ * Layer items report invalidated areas to the scheduler instead of updating
+ * themselves directly. Once per frame, the scheduler hands the accumulated
+ * areas back to the items for repainting, up to a budget of pixels. Any
+ * invalidated area over budget is carried into the next frame, so a heavy
+ * stroke is drawn steadily over several frames rather than in bursts.
+ */
+class ADDLE_WIDGETSGUI_EXPORT CanvasFrameScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    struct FrameStats
+    {
+        int frames = 0;
+        int droppedFrames = 0;
+
+        // Frame times are measured between successive frame ticks while
+        // the scheduler is active, in milliseconds.
+        double averageFrameTime = 0;
+        double worstFrameTime = 0;
+
+        // Number of pixels whose repaint was deferred to a later frame
+        // because a frame's budget was exhausted.
+        qint64 deferredPixels = 0;
+    };
+
+    CanvasFrameScheduler(QObject* parent = nullptr);
+    virtual ~CanvasFrameScheduler() = default;
+
+    void invalidate(LayerItem* item, QRect area);
+
+    // Must be called by an item before it is destroyed.
+    void remove(LayerItem* item);
+
+    double frameInterval() const { return _frameInterval; }
+
+    qint64 pixelBudget() const { return _pixelBudget; }
+    void setPixelBudget(qint64 budget) { _pixelBudget = qMax(budget, (qint64)1); }
+
+    FrameStats stats() const { return _stats; }
+    void resetStats() { _stats = FrameStats(); _frameTimeTotal = 0; _measuredFrames = 0; }
+
+signals:
+    void frameFinished();
+
+private slots:
+    void onFrame();
+    void updateFrameInterval();
+
+private:
+    void schedule();
+    void recordFrameTime(double elapsed);
+
+    static constexpr qint64 DEFAULT_PIXEL_BUDGET = 4096 * 4096 / 4;
+
+    QHash<LayerItem*, DirtyRegion> _dirty;
+    QList<LayerItem*> _queue; // round-robin order of items with pending work
+
+    QTimer _timer;
+    QElapsedTimer _frameClock;
+
+    double _frameInterval = 1000.0 / 60;
+    qint64 _pixelBudget = DEFAULT_PIXEL_BUDGET;
+
+    FrameStats _stats;
+    double _frameTimeTotal = 0;
+    int _measuredFrames = 0;
+};
+
+} // namespace Addle
+
+#endif // CANVASFRAMESCHEDULER_HPP
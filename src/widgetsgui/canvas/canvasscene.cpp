@@ -23,6 +23,7 @@
 
 #include "docbackgrounditem.hpp"
 #include "layeritem.hpp"
+#include "canvasframescheduler.hpp"
 
 #include "utils.hpp"
 
@@ -33,6 +34,8 @@ const double MINIMUM_LAYER_Z = 1;
 CanvasScene::CanvasScene(ICanvasPresenter& presenter, QObject* parent)
     : QGraphicsScene(parent), _presenter(presenter)
 {
+    _frameScheduler = new CanvasFrameScheduler(this);
+
     _presenter = presenter;
 
     auto documentPresenter = _presenter.mainEditorPresenter().documentPresenter();
@@ -100,9 +103,19 @@ bool CanvasScene::event(QEvent* e)
     return QGraphicsScene::event(e);
 }
 
+void CanvasScene::setDraft(bool draft)
+{
+    if (_isDraft == draft) return;
+
+    _isDraft = draft;
+    for (LayerItem* layerItem : _layerItems)
+        layerItem->setDraft(_isDraft);
+}
+
 void CanvasScene::layersUpdated()
 {
     clear();
+    _layerItems.clear();
 
     QSharedPointer<IDocumentPresenter> document = _presenter.mainEditorPresenter().documentPresenter();
 
@@ -119,9 +132,11 @@ void CanvasScene::layersUpdated()
     {
         if (!node.isValue()) continue;
         
-        LayerItem* layerItem = new LayerItem(*node.asValue());
+        LayerItem* layerItem = new LayerItem(*node.asValue(), _frameScheduler);
         layerItem->setZValue(z);
+        layerItem->setDraft(_isDraft);
         addItem(layerItem);
+        _layerItems.append(layerItem);
 
         z -= 1.0;
     }
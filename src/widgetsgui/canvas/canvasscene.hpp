@@ -22,6 +22,7 @@ namespace Addle {
 
 class ICanvasPresenter;
 class CanvasItem;
+class CanvasFrameScheduler;
 class ADDLE_WIDGETSGUI_EXPORT CanvasScene : public QGraphicsScene
 {
     Q_OBJECT
@@ -31,6 +32,11 @@ public:
 
     bool event(QEvent* e) override;
 
+    CanvasFrameScheduler& frameScheduler() const { return *_frameScheduler; }
+
+    bool isDraft() const { return _isDraft; }
+    void setDraft(bool draft);
+
 protected:
     void mouseMoveEvent(QGraphicsSceneMouseEvent* mouseEvent);
     void mousePressEvent(QGraphicsSceneMouseEvent* mouseEvent);
@@ -41,6 +47,10 @@ private slots:
     
 private:
     CanvasItem* _canvasItem;
+    CanvasFrameScheduler* _frameScheduler;
+
+    QList<LayerItem*> _layerItems;
+    bool _isDraft = false;
 
     ICanvasPresenter& _presenter;
 };
@@ -7,19 +7,23 @@
  */
 
 #include "layeritem.hpp"
+#include "canvasframescheduler.hpp"
 
 #include "utilities/qobject.hpp"
+#include "utilities/debugging/startuptrace.hpp"
 #include "utils.hpp"
 
 #include <QStyleOptionGraphicsItem>
 
+#include <cmath>
+
 #include "interfaces/presenters/ilayerpresenter.hpp"
 #include "interfaces/rendering/irenderstack.hpp"
 
 using namespace Addle;
 
-LayerItem::LayerItem(ILayerPresenter& presenter)
-    : _presenter(presenter)
+LayerItem::LayerItem(ILayerPresenter& presenter, CanvasFrameScheduler* scheduler)
+    : _presenter(presenter), _scheduler(scheduler), _mipCache(presenter)
 {
     setFlags(
         {
@@ -34,6 +38,12 @@ LayerItem::LayerItem(ILayerPresenter& presenter)
     );
 }
 
+LayerItem::~LayerItem()
+{
+    if (_scheduler)
+        _scheduler->remove(this);
+}
+
 QRectF LayerItem::boundingRect() const
 {
     return _presenter.documentPresenter()->rect();
@@ -42,12 +52,45 @@ QRectF LayerItem::boundingRect() const
 void LayerItem::paint(QPainter* painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
 {
     //assert painter
+
+    // The first paint of a layer marks the end of startup.
+    ADDLE_TRACE_STARTUP_END("LayerItem::paint");
+
+    const QRect area = coarseBoundRect(option->exposedRect);
+
+    if (_isDraft)
+    {
+        const double scale = std::sqrt(qAbs(painter->worldTransform().determinant()));
+        const int level = LayerMipCache::levelFor(scale);
+        if (level > 0)
+        {
+            _mipCache.draw(*painter, area, level);
+            return;
+        }
+    }
     
-    RenderData data(coarseBoundRect(option->exposedRect), painter);
+    RenderData data(area, painter);
     _presenter.renderStack().render(data);
 }
 
+void LayerItem::setDraft(bool draft)
+{
+    if (_isDraft == draft) return;
+
+    _isDraft = draft;
+    _mipCache.setActive(draft);
+    update();
+}
+
 void LayerItem::onRenderChanged(QRect area)
 {
-    update(area);
+    if (area.isNull())
+        area = boundingRect().toAlignedRect();
+
+    _mipCache.invalidate(area);
+    
+    if (_scheduler)
+        _scheduler->invalidate(this, area);
+    else
+        update(area);
 }
\ No newline at end of file
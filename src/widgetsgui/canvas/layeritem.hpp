@@ -12,26 +12,42 @@
 #include "compat.hpp"
 #include <QObject>
 #include <QGraphicsItem>
+#include <QPointer>
+
+#include "layermipcache.hpp"
 
 namespace Addle {
 
 class ILayerPresenter;
+class CanvasFrameScheduler;
 class ADDLE_WIDGETSGUI_EXPORT LayerItem: public QObject, public QGraphicsItem
 {
     Q_OBJECT 
 public:
-    LayerItem(ILayerPresenter& presenter);
-    virtual ~LayerItem() = default; 
+    LayerItem(ILayerPresenter& presenter, CanvasFrameScheduler* scheduler = nullptr);
+    virtual ~LayerItem();
 
     QRectF boundingRect() const;
     void paint(QPainter* painter, const QStyleOptionGraphicsItem *option, QWidget *widget);
 
+    // In draft mode the layer is drawn from a reduced-resolution cache when
+    // zoomed out, for responsiveness during navigation.
+    bool isDraft() const { return _isDraft; }
+    void setDraft(bool draft);
+
 private slots: 
     void onRenderChanged(QRect area);
 
 private: 
 
     ILayerPresenter& _presenter;
+
+    // Changes reported by the render stack are accumulated by the scheduler
+    // and handed back to the item for repaint once per frame.
+    QPointer<CanvasFrameScheduler> _scheduler;
+
+    LayerMipCache _mipCache;
+    bool _isDraft = false;
 };
 
 } // namespace Addle
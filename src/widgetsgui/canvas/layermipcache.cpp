@@ -0,0 +1,232 @@
+/**
+ * Addle source code
+ * @file
+ * @copyright Copyright 2020 Eleanor Hawk
+ * @copyright Modification and distribution permitted under the terms of the
+ * MIT License. See "LICENSE" for full details.
+ */
+
+#include "layermipcache.hpp"
+
+#include <cmath>
+
+#include <QThread>
+
+#include "utilities/render/renderdata.hpp"
+
+#include "interfaces/presenters/ilayerpresenter.hpp"
+#include "interfaces/presenters/idocumentpresenter.hpp"
+#include "interfaces/rendering/irenderstack.hpp"
+
+using namespace Addle;
+
+LayerMipCache::LayerMipCache(ILayerPresenter& presenter)
+    : _presenter(presenter)
+{
+    _releaseTimer.setSingleShot(true);
+    _releaseTimer.setInterval(RELEASE_DELAY);
+    QObject::connect(&_releaseTimer, &QTimer::timeout, [this]() { clear(); });
+
+    _registration = CacheManager::add(
+        QStringLiteral("layer-mip-levels"),
+        CacheManager::Normal,
+        [this]() { return _bytes.loadAcquire(); },
+        [this](qint64) {
+            // The levels belong to the GUI thread. If asked from elsewhere,
+            // they are released there shortly, and nothing is freed yet.
+            if (QThread::currentThread() != _releaseTimer.thread())
+            {
+                QMetaObject::invokeMethod(&_releaseTimer, [this]() { clear(); }, Qt::QueuedConnection);
+                return (qint64)0;
+            }
+
+            const qint64 freed = _bytes.loadAcquire();
+            clear();
+            return freed;
+        }
+    );
+}
+
+int LayerMipCache::levelFor(double scale)
+{
+    if (scale <= 0 || scale >= 0.5) return 0;
+
+    return qBound(0, (int)std::floor(std::log2(1.0 / scale)), MAX_LEVEL);
+}
+
+void LayerMipCache::invalidate(QRect area)
+{
+    for (int n = 1; n <= MAX_LEVEL; ++n)
+    {
+        Level& level = _levels[n];
+        if (level.image.isNull()) continue;
+
+        if (area.isNull())
+            level.dirty = level.documentRect;
+        else
+            level.dirty += area.intersected(level.documentRect);
+    }
+}
+
+void LayerMipCache::clear()
+{
+    for (Level& level : _levels)
+        level = Level();
+
+    _bytes.storeRelease(0);
+}
+
+void LayerMipCache::setActive(bool active)
+{
+    if (active)
+        _releaseTimer.stop();
+    else
+        _releaseTimer.start();
+}
+
+void LayerMipCache::updateBytes()
+{
+    qint64 bytes = 0;
+    for (const Level& level : _levels)
+        bytes += level.image.sizeInBytes();
+
+    _bytes.storeRelease(bytes);
+}
+
+QSize LayerMipCache::levelSize(QRect documentRect, int n)
+{
+    const double factor = 1.0 / (1 << n);
+    return QSize(
+        qMax(1, (int)std::ceil(documentRect.width() * factor)),
+        qMax(1, (int)std::ceil(documentRect.height() * factor))
+    );
+}
+
+int LayerMipCache::baseLevel(QRect documentRect)
+{
+    int n = 1;
+    while (n < MAX_LEVEL)
+    {
+        const QSize size = levelSize(documentRect, n);
+        if ((qint64)size.width() * size.height() * 4 <= MAX_LEVEL_BYTES)
+            break;
+        ++n;
+    }
+    return n;
+}
+
+void LayerMipCache::draw(QPainter& painter, QRect area, int n)
+{
+    // Very large documents use a smaller level than was asked for, rather
+    // than holding a level that is itself as large as a document.
+    const QRect documentRect = _presenter.documentPresenter()->rect();
+    const int base = baseLevel(documentRect);
+    n = qBound(base, n, MAX_LEVEL);
+
+    Level& level = _levels[n];
+    _registration.touch();
+
+    const qint64 bytesBefore = _bytes.loadAcquire();
+    refresh(n, base, area);
+    if (level.image.isNull()) return;
+
+    area = area.intersected(level.documentRect);
+    if (!area.isEmpty())
+    {
+        const double factor = 1.0 / (1 << n);
+        const QRectF source(
+            QPointF(area.topLeft() - level.documentRect.topLeft()) * factor,
+            QSizeF(area.size()) * factor
+        );
+
+        painter.save();
+        painter.setRenderHint(QPainter::SmoothPixmapTransform, false);
+        painter.drawImage(QRectF(area), level.image, source);
+        painter.restore();
+    }
+
+    // Only after drawing, since the manager may release the level.
+    if (_bytes.loadAcquire() > bytesBefore)
+        _registration.changed();
+}
+
+void LayerMipCache::refresh(int n, int base, QRect area)
+{
+    Level& level = _levels[n];
+
+    const QRect documentRect = _presenter.documentPresenter()->rect();
+    if (documentRect.isEmpty()) return;
+
+    if (level.image.isNull() || level.documentRect != documentRect)
+    {
+        level.documentRect = documentRect;
+        level.image = QImage(
+            levelSize(documentRect, n),
+            QImage::Format_ARGB32_Premultiplied
+        );
+        level.dirty = documentRect;
+        updateBytes();
+    }
+
+    const QRegion toRender = level.dirty.intersected(area);
+    if (toRender.isEmpty()) return;
+
+    // Align the refreshed area outward to whole pixels of the level so that
+    // adjacent refreshes don't leave seams.
+    const int align = 1 << n;
+    QRect bound = toRender.boundingRect().translated(-documentRect.topLeft());
+    bound.setLeft((bound.left() / align) * align);
+    bound.setTop((bound.top() / align) * align);
+    bound.setRight(((bound.right() / align) + 1) * align - 1);
+    bound.setBottom(((bound.bottom() / align) + 1) * align - 1);
+    bound = bound.translated(documentRect.topLeft()).intersected(documentRect);
+
+    if (n == base)
+    {
+        // Only the base level is rendered from the layer itself.
+        const double factor = 1.0 / (1 << n);
+
+        QPainter painter(&level.image);
+        painter.setRenderHint(QPainter::SmoothPixmapTransform, true);
+        painter.scale(factor, factor);
+        painter.translate(-documentRect.topLeft());
+        painter.setClipRect(bound);
+
+        painter.setCompositionMode(QPainter::CompositionMode_Source);
+        painter.fillRect(bound, Qt::transparent);
+        painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+
+        _presenter.renderStack().render(RenderData(bound, &painter));
+    }
+    else
+    {
+        // Each level above the base is halved from the one below it, which
+        // touches a quarter as many pixels as rendering the layer again.
+        refresh(n - 1, base, bound);
+
+        const Level& lower = _levels[n - 1];
+        const QRect source = levelRect(documentRect, bound, n - 1);
+        const QRect target = levelRect(documentRect, bound, n);
+
+        const QImage reduced = lower.image.copy(source).scaled(
+            target.size(),
+            Qt::IgnoreAspectRatio,
+            Qt::SmoothTransformation
+        );
+
+        QPainter painter(&level.image);
+        painter.setCompositionMode(QPainter::CompositionMode_Source);
+        painter.drawImage(target.topLeft(), reduced);
+    }
+
+    level.dirty -= bound;
+}
+
+QRect LayerMipCache::levelRect(QRect documentRect, QRect area, int n)
+{
+    const QRect local = area.translated(-documentRect.topLeft());
+    return QRect(
+        QPoint(local.left() >> n, local.top() >> n),
+        QPoint(local.right() >> n, local.bottom() >> n)
+    );
+}
@@ -0,0 +1,104 @@
+/**
+ * Addle source code
+ * @file
+ * @copyright Copyright 2020 Eleanor Hawk
+ * @copyright Modification and distribution permitted under the terms of the
+ * MIT License. See "LICENSE" for full details.
+ */
+
+#ifndef LAYERMIPCACHE_HPP
+#define LAYERMIPCACHE_HPP
+
+#include "compat.hpp"
+#include <QImage>
+#include <QRegion>
+#include <QPainter>
+#include <QTimer>
+#include <QAtomicInteger>
+
+#include "utilities/cachemanager.hpp"
+
+namespace Addle {
+
+class ILayerPresenter;
+
+/**
+ * Lazily renders and caches reduced-resolution copies (mip levels) of a
+ * layer, for fast low-quality drawing while the view is being navigated.
+ *
+ * Level n is the layer scaled by 1/2^n. Only the parts of a level that are
+ * actually drawn are made, and changes to the layer invalidate only the
+ * affected parts of each level. Only the lowest level in use is rendered from
+ * the layer; each level above it is halved from the one before it.
+ *
+ * The levels are only kept while the cache is active, and are released
+ * RELEASE_DELAY milliseconds after it is made inactive, i.e., once navigation
+ * has settled. A level that would be larger than MAX_LEVEL_BYTES is never
+ * made; the next smaller level is drawn instead. The levels are also
+ * registered with CacheManager, which may release them sooner.
+ */
+class ADDLE_WIDGETSGUI_EXPORT LayerMipCache
+{
+public:
+    LayerMipCache(ILayerPresenter& presenter);
+
+    // The mip level appropriate for drawing at `scale` device pixels per
+    // canvas pixel. Level 0 means the layer should be drawn at full quality.
+    static int levelFor(double scale);
+
+    // `area` is in canvas coordinates. A null area invalidates everything.
+    void invalidate(QRect area);
+
+    // Draws `area` of the layer from the given mip level. `painter` is
+    // expected to be transformed to canvas coordinates.
+    void draw(QPainter& painter, QRect area, int level);
+
+    void clear();
+
+    // The cache is made active while the view is being navigated. Once it is
+    // made inactive, its levels are released after RELEASE_DELAY unless it
+    // is made active again in the meantime.
+    void setActive(bool active);
+
+    static constexpr int MAX_LEVEL = 5;
+    static constexpr int RELEASE_DELAY = 5000;
+    static constexpr qint64 MAX_LEVEL_BYTES = 64 * 1024 * 1024;
+
+private:
+    struct Level
+    {
+        QImage image;
+        QRect documentRect;
+        QRegion dirty;
+    };
+
+    static QSize levelSize(QRect documentRect, int n);
+
+    // The pixels of level n covering `area`, which is in canvas coordinates.
+    static QRect levelRect(QRect documentRect, QRect area, int n);
+
+    // The lowest level that fits in MAX_LEVEL_BYTES. This is the level
+    // rendered from the layer.
+    static int baseLevel(QRect documentRect);
+
+    void updateBytes();
+
+    // Brings `area` of level n up to date, and with it the same area of each
+    // level down to `base`.
+    void refresh(int n, int base, QRect area);
+
+    ILayerPresenter& _presenter;
+    Level _levels[MAX_LEVEL + 1];
+
+    QTimer _releaseTimer;
+
+    // The bytes held by the levels, which CacheManager may read from any
+    // thread.
+    QAtomicInteger<qint64> _bytes;
+
+    CacheManager::Registration _registration;
+};
+
+} // namespace Addle
+
+#endif // LAYERMIPCACHE_HPP
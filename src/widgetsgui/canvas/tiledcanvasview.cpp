@@ -0,0 +1,566 @@
+/**
+ * Addle source code
+ * @file
+ * @copyright Copyright 2020 Eleanor Hawk
+ * @copyright Modification and distribution permitted under the terms of the
+ * MIT License. See "LICENSE" for full details.
+ */
+
+#include "tiledcanvasview.hpp"
+
+#include <QPainter>
+#include <QPaintEvent>
+#include <QMouseEvent>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QtGlobal>
+
+#include <cmath>
+
+#include "utils.hpp"
+#include "utilities/guiutils.hpp"
+#include "utilities/debugging/startuptrace.hpp"
+#include "utilities/render/renderdata.hpp"
+
+#include "interfaces/presenters/iviewportpresenter.hpp"
+#include "interfaces/presenters/imaineditorpresenter.hpp"
+#include "interfaces/presenters/idocumentpresenter.hpp"
+#include "interfaces/presenters/ilayerpresenter.hpp"
+#include "interfaces/presenters/icanvaspresenter.hpp"
+#include "interfaces/rendering/irenderstack.hpp"
+
+using namespace Addle;
+
+static inline int floorDiv(int a, int b)
+{
+    return a >= 0 ? a / b : (a + 1) / b - 1;
+}
+
+static inline bool sameLinearPart(const QTransform& t1, const QTransform& t2)
+{
+    const double EPSILON = 1e-9;
+    return qAbs(t1.m11() - t2.m11()) < EPSILON
+        && qAbs(t1.m12() - t2.m12()) < EPSILON
+        && qAbs(t1.m21() - t2.m21()) < EPSILON
+        && qAbs(t1.m22() - t2.m22()) < EPSILON;
+}
+
+TiledCanvasView::TiledCanvasView(IViewPortPresenter& presenter, QWidget* parent)
+    : QWidget(parent), _presenter(presenter)
+{
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    setFocusPolicy(Qt::StrongFocus);
+    setMouseTracking(true);
+
+    _texture = checkerBoardTexture(35, Qt::lightGray, Qt::gray);
+    _fromCanvas = _presenter.fromCanvasTransform();
+
+    connect_interface(
+        &_presenter,
+        SIGNAL(transformsChanged()),
+        this,
+        SLOT(onTransformsChanged()),
+#ifdef Q_OS_LINUX
+        // See ViewPort
+        Qt::ConnectionType::QueuedConnection
+#else
+        Qt::ConnectionType::AutoConnection
+#endif
+    );
+
+    _refineTimer.setSingleShot(true);
+    _refineTimer.setInterval(REFINE_DELAY);
+    connect(&_refineTimer, &QTimer::timeout, this, &TiledCanvasView::onRefineTimeout);
+
+    _registration = CacheManager::add(
+        QStringLiteral("canvas-tiles"),
+        CacheManager::Normal,
+        [this]() { return _tileBytes.loadAcquire(); },
+        [this](qint64) {
+            // Tiles on screen are needed to draw the next frame, so only
+            // those outside the view are released. They belong to the GUI
+            // thread, so if asked from elsewhere they are released there
+            // shortly, and nothing is freed yet.
+            if (QThread::currentThread() != thread())
+            {
+                QMetaObject::invokeMethod(this, [this]() { evictTiles(0); }, Qt::QueuedConnection);
+                return (qint64)0;
+            }
+
+            const qint64 before = _tileBytes.loadAcquire();
+            evictTiles(0);
+            return before - _tileBytes.loadAcquire();
+        }
+    );
+
+    connect_interface(
+        &_presenter,
+        SIGNAL(navigatingChanged(bool)),
+        this,
+        SLOT(onNavigatingChanged(bool))
+    );
+
+    connect_interface(
+        _presenter.mainEditorPresenter(),
+        SIGNAL(documentPresenterChanged(QSharedPointer<IDocumentPresenter>)),
+        this,
+        SLOT(setDocument(QSharedPointer<IDocumentPresenter>))
+    );
+
+    setDocument(_presenter.mainEditorPresenter()->documentPresenter());
+
+    _presenter.setHasFocus(hasFocus());
+
+    connect_interface(
+        &_presenter.mainEditorPresenter()->canvasPresenter(),
+        SIGNAL(cursorChanged(QCursor)),
+        this,
+        SLOT(updateCursor())
+    );
+    updateCursor();
+}
+
+bool TiledCanvasView::isEnabled()
+{
+    return qEnvironmentVariableIsSet(ENABLE_ENV_VARIABLE_NAME)
+        && qgetenv(ENABLE_ENV_VARIABLE_NAME) != "0";
+}
+
+void TiledCanvasView::paintEvent(QPaintEvent* event)
+{
+    // As with LayerItem::paint, the first paint marks the end of startup.
+    ADDLE_TRACE_STARTUP_END("TiledCanvasView::paintEvent");
+
+    QElapsedTimer timer;
+    timer.start();
+
+    bool deferred = false;
+    const qint64 bytesBefore = _tileBytes.loadAcquire();
+
+    const QRect indices = tileIndices(event->rect().translated(_origin));
+    for (int y = indices.top(); y <= indices.bottom(); ++y)
+    {
+        for (int x = indices.left(); x <= indices.right(); ++x)
+        {
+            const QPoint index(x, y);
+            Tile& tile = _tiles[index];
+            if (tile.valid) continue;
+
+            // A tile with nothing to stand in for it is always rendered.
+            // Otherwise rendering is deferred once the budget is spent.
+            const bool hasStandIn = !tile.image.isNull() || !_preview.isNull();
+            if (!hasStandIn || timer.elapsed() < RENDER_BUDGET)
+                renderTile(index, tile);
+            else
+                deferred = true;
+        }
+    }
+
+    QPainter painter(this);
+    drawStore(painter, event->rect());
+
+    updateTileBytes();
+    _registration.touch();
+    if (_tileBytes.loadAcquire() > bytesBefore)
+        _registration.changed();
+
+    if (deferred)
+    {
+        QMetaObject::invokeMethod(this, "update", Qt::QueuedConnection);
+    }
+    else if (!_preview.isNull())
+    {
+        const QRect visible = tileIndices(rect().translated(_origin));
+        bool complete = true;
+        for (int y = visible.top(); complete && y <= visible.bottom(); ++y)
+        {
+            for (int x = visible.left(); complete && x <= visible.right(); ++x)
+                complete = _tiles.value(QPoint(x, y)).valid;
+        }
+
+        if (complete)
+            _preview = QImage();
+        else
+            QMetaObject::invokeMethod(this, "update", Qt::QueuedConnection);
+    }
+}
+
+void TiledCanvasView::resizeEvent(QResizeEvent* event)
+{
+    _presenter.setSize(contentsRect().size());
+    evictTiles();
+}
+
+void TiledCanvasView::moveEvent(QMoveEvent* event)
+{
+    _presenter.setGlobalOffset(mapToGlobal(contentsRect().topLeft()));
+}
+
+void TiledCanvasView::mousePressEvent(QMouseEvent* event)
+{
+    sendMouseEvent(event, CanvasMouseEvent::down);
+}
+
+void TiledCanvasView::mouseMoveEvent(QMouseEvent* event)
+{
+    sendMouseEvent(event, CanvasMouseEvent::move);
+}
+
+void TiledCanvasView::mouseReleaseEvent(QMouseEvent* event)
+{
+    sendMouseEvent(event, CanvasMouseEvent::up);
+}
+
+void TiledCanvasView::enterEvent(QEvent* event)
+{
+    _presenter.mainEditorPresenter()->canvasPresenter().setHasMouse(true);
+}
+
+void TiledCanvasView::leaveEvent(QEvent* event)
+{
+    _presenter.mainEditorPresenter()->canvasPresenter().setHasMouse(false);
+}
+
+void TiledCanvasView::focusInEvent(QFocusEvent* event)
+{
+    _presenter.setHasFocus(true);
+}
+
+void TiledCanvasView::focusOutEvent(QFocusEvent* event)
+{
+    _presenter.setHasFocus(false);
+}
+
+void TiledCanvasView::setDocument(QSharedPointer<IDocumentPresenter> documentPresenter)
+{
+    if (_documentPresenter)
+        qobject_interface_cast(_documentPresenter.data())->disconnect(this);
+
+    _documentPresenter = documentPresenter;
+
+    if (_documentPresenter)
+    {
+        connect_interface(_documentPresenter.data(),
+            SIGNAL(layersChanged()),
+            this,
+            SLOT(onLayersChanged())
+        );
+    }
+
+    onLayersChanged();
+}
+
+void TiledCanvasView::onLayersChanged()
+{
+    for (auto& layer : _layers)
+        qobject_interface_cast(&layer->renderStack())->disconnect(this);
+
+    _layers.clear();
+    _mipCaches.clear();
+
+    if (_documentPresenter)
+    {
+        for (auto& node : noDetach(_documentPresenter->layers()))
+        {
+            if (!node.isValue()) continue;
+
+            // The first layer in the list is the top-most.
+            _layers.prepend(node.asValue());
+            _mipCaches.prepend(QSharedPointer<LayerMipCache>(new LayerMipCache(*node.asValue())));
+
+            connect_interface(
+                &node.asValue()->renderStack(),
+                SIGNAL(changed(QRect)),
+                this, SLOT(onRenderChanged(QRect))
+            );
+        }
+    }
+
+    invalidateAll();
+}
+
+void TiledCanvasView::onTransformsChanged()
+{
+    if (_presenter.isNavigating())
+    {
+        setDraft(true);
+        _refineTimer.start();
+    }
+
+    const QTransform fromCanvas = _presenter.fromCanvasTransform();
+    const QTransform current = _fromCanvas * QTransform::fromTranslate(-_origin.x(), -_origin.y());
+
+    if (fromCanvas == current) return;
+
+    if (sameLinearPart(fromCanvas, current))
+    {
+        const QPointF delta(fromCanvas.dx() - current.dx(), fromCanvas.dy() - current.dy());
+        const QPoint scroll = delta.toPoint();
+
+        if (qAbs(delta.x() - scroll.x()) < 0.01 && qAbs(delta.y() - scroll.y()) < 0.01)
+        {
+            // Pure pan by whole pixels. Tiles remain valid in store space, so
+            // move the origin, scroll the pixels already on screen, and let
+            // Qt repaint only the exposed strips.
+
+            _origin -= scroll;
+            if (!_preview.isNull())
+                _previewTransform *= QTransform::fromTranslate(scroll.x(), scroll.y());
+
+            evictTiles();
+            QWidget::scroll(scroll.x(), scroll.y());
+            return;
+        }
+    }
+
+    takePreview(fromCanvas);
+
+    _tiles.clear();
+    updateTileBytes();
+    _origin = QPoint();
+    _fromCanvas = fromCanvas;
+
+    update();
+}
+
+void TiledCanvasView::onRenderChanged(QRect area)
+{
+    for (int i = 0; i < _layers.size(); ++i)
+    {
+        if (qobject_interface_cast(&_layers[i]->renderStack()) == sender())
+            _mipCaches[i]->invalidate(area);
+    }
+
+    if (area.isNull())
+    {
+        invalidateAll();
+        return;
+    }
+
+    invalidate(coarseBoundRect(_fromCanvas.mapRect(QRectF(area))).adjusted(-1, -1, 1, 1));
+}
+
+void TiledCanvasView::onNavigatingChanged(bool navigating)
+{
+    if (!navigating)
+        onRefineTimeout();
+}
+
+void TiledCanvasView::onRefineTimeout()
+{
+    _refineTimer.stop();
+    setDraft(false);
+}
+
+void TiledCanvasView::setDraft(bool draft)
+{
+    if (_isDraft == draft) return;
+
+    _isDraft = draft;
+
+    for (auto& mipCache : _mipCaches)
+        mipCache->setActive(_isDraft);
+
+    if (!_isDraft)
+    {
+        // Draft tiles are kept on screen as stand-ins until they're refined.
+        for (Tile& tile : _tiles)
+        {
+            if (tile.draft)
+                tile.valid = false;
+        }
+        update();
+    }
+}
+
+void TiledCanvasView::updateCursor()
+{
+    setCursor(_presenter.mainEditorPresenter()->canvasPresenter().cursor());
+}
+
+QRect TiledCanvasView::tileRect(QPoint index) const
+{
+    return QRect(index * TILE_SIZE, QSize(TILE_SIZE, TILE_SIZE));
+}
+
+QRect TiledCanvasView::tileIndices(QRect storeRect) const
+{
+    return QRect(
+        QPoint(floorDiv(storeRect.left(), TILE_SIZE), floorDiv(storeRect.top(), TILE_SIZE)),
+        QPoint(floorDiv(storeRect.right(), TILE_SIZE), floorDiv(storeRect.bottom(), TILE_SIZE))
+    );
+}
+
+void TiledCanvasView::renderTile(QPoint index, Tile& tile)
+{
+    const QRect storeRect = tileRect(index);
+
+    if (tile.image.isNull())
+        tile.image = QImage(TILE_SIZE, TILE_SIZE, QImage::Format_ARGB32_Premultiplied);
+
+    tile.image.fill(palette().color(backgroundRole()));
+    tile.valid = true;
+    tile.draft = false;
+
+    if (!_documentPresenter || _documentPresenter->isEmpty()) return;
+
+    const QTransform ontoTile = _fromCanvas
+        * QTransform::fromTranslate(-storeRect.x(), -storeRect.y());
+
+    const QRect canvasArea = coarseBoundRect(
+            ontoTile.inverted().mapRect(QRectF(tile.image.rect()))
+        ).intersected(_documentPresenter->rect());
+
+    if (canvasArea.isEmpty()) return;
+
+    QPainter painter(&tile.image);
+
+    QPainterPath backgroundPath;
+    backgroundPath.addRect(canvasArea);
+    backgroundPath = ontoTile.map(backgroundPath);
+
+    // The checkerboard is anchored in store space, so it scrolls with the
+    // canvas and lines up across tile seams.
+    const QColor backgroundColor = _documentPresenter->backgroundColor();
+    painter.setBrushOrigin(-storeRect.topLeft());
+    if (backgroundColor.alpha() < 255)
+        painter.fillPath(backgroundPath, _texture);
+    painter.fillPath(backgroundPath, backgroundColor);
+
+    painter.setTransform(ontoTile);
+
+    const int mipLevel = _isDraft ?
+        LayerMipCache::levelFor(std::sqrt(qAbs(ontoTile.determinant()))) : 0;
+
+    for (int i = 0; i < _layers.size(); ++i)
+    {
+        if (mipLevel > 0)
+        {
+            _mipCaches[i]->draw(painter, canvasArea, mipLevel);
+            tile.draft = true;
+            continue;
+        }
+
+        painter.save();
+        _layers[i]->renderStack().render(RenderData(canvasArea, &painter));
+        painter.restore();
+    }
+}
+
+void TiledCanvasView::drawStore(QPainter& painter, QRect widgetRect)
+{
+    painter.fillRect(widgetRect, palette().color(backgroundRole()));
+
+    if (!_preview.isNull())
+    {
+        painter.save();
+        painter.setClipRect(widgetRect);
+        painter.setTransform(_previewTransform);
+        painter.drawImage(QPoint(), _preview);
+        painter.restore();
+    }
+
+    const QRect indices = tileIndices(widgetRect.translated(_origin));
+    for (int y = indices.top(); y <= indices.bottom(); ++y)
+    {
+        for (int x = indices.left(); x <= indices.right(); ++x)
+        {
+            const QPoint index(x, y);
+            auto i = _tiles.constFind(index);
+            if (i == _tiles.constEnd() || i->image.isNull()) continue;
+
+            painter.drawImage(tileRect(index).topLeft() - _origin, i->image);
+        }
+    }
+}
+
+void TiledCanvasView::invalidate(QRect storeRect)
+{
+    const QRect indices = tileIndices(storeRect);
+    for (int y = indices.top(); y <= indices.bottom(); ++y)
+    {
+        for (int x = indices.left(); x <= indices.right(); ++x)
+        {
+            auto i = _tiles.find(QPoint(x, y));
+            if (i != _tiles.end())
+                i->valid = false;
+        }
+    }
+
+    update(storeRect.translated(-_origin));
+}
+
+void TiledCanvasView::invalidateAll()
+{
+    for (Tile& tile : _tiles)
+        tile.valid = false;
+
+    update();
+}
+
+void TiledCanvasView::takePreview(QTransform newFromCanvas)
+{
+    if (size().isEmpty()) return;
+
+    QImage preview(size(), QImage::Format_ARGB32_Premultiplied);
+    {
+        QPainter painter(&preview);
+        drawStore(painter, rect());
+    }
+
+    const QTransform oldOntoCanvas = (
+            _fromCanvas * QTransform::fromTranslate(-_origin.x(), -_origin.y())
+        ).inverted();
+
+    _preview = preview;
+    _previewTransform = oldOntoCanvas * newFromCanvas;
+}
+
+void TiledCanvasView::evictTiles(int margin)
+{
+    const QRect keep = rect().translated(_origin)
+        .adjusted(-margin, -margin, margin, margin);
+
+    for (auto i = _tiles.begin(); i != _tiles.end();)
+    {
+        if (!tileRect(i.key()).intersects(keep))
+            i = _tiles.erase(i);
+        else
+            ++i;
+    }
+
+    updateTileBytes();
+}
+
+void TiledCanvasView::updateTileBytes()
+{
+    qint64 bytes = 0;
+    for (const Tile& tile : noDetach(_tiles))
+        bytes += tile.image.sizeInBytes();
+
+    _tileBytes.storeRelease(bytes);
+}
+
+void TiledCanvasView::sendMouseEvent(QMouseEvent* event, CanvasMouseEvent::Action action)
+{
+    // Map with the transform the user is looking at, which may briefly lag
+    // behind the presenter's.
+    const QTransform ontoCanvas = (
+            _fromCanvas * QTransform::fromTranslate(-_origin.x(), -_origin.y())
+        ).inverted();
+
+    CanvasMouseEvent canvasMouseEvent(
+        action,
+        ontoCanvas.map(event->localPos()),
+        event->button(),
+        event->buttons(),
+        event->flags(),
+        event->source(),
+        event
+    );
+
+    ICanvasPresenter& canvasPresenter = _presenter.mainEditorPresenter()->canvasPresenter();
+    event->setAccepted(
+        qobject_interface_cast(&canvasPresenter)->event(&canvasMouseEvent) && canvasMouseEvent.isAccepted()
+    );
+}
@@ -0,0 +1,152 @@
+/**
+ * Addle source code
+ * @file
+ * @copyright Copyright 2020 Eleanor Hawk
+ * @copyright Modification and distribution permitted under the terms of the
+ * MIT License. See "LICENSE" for full details.
+ */
+
+#ifndef TILEDCANVASVIEW_HPP
+#define TILEDCANVASVIEW_HPP
+
+#include "compat.hpp"
+#include <QWidget>
+#include <QImage>
+#include <QPixmap>
+#include <QHash>
+#include <QList>
+#include <QTransform>
+#include <QTimer>
+#include <QSharedPointer>
+#include <QAtomicInteger>
+
+#include "utilities/hashfunctions.hpp"
+#include "utilities/cachemanager.hpp"
+#include "utilities/canvas/canvasmouseevent.hpp"
+
+#include "layermipcache.hpp"
+
+namespace Addle {
+
+class IViewPortPresenter;
+class IDocumentPresenter;
+class ILayerPresenter;
+
+/**
+ * An alternative to ViewPort and CanvasScene that draws the canvas directly
+ * into a widget, from a backing store of screen-space tiles.
+ *
+ * Tiles are addressed in "store space", which is widget space offset by a
+ * scroll origin. Panning by whole pixels only moves the origin, so tiles
+ * already rendered stay valid and only newly exposed tiles are rendered.
+ *
+ * When the view is zoomed or rotated, a snapshot of the previous frame is
+ * kept as a preview and drawn (transformed) in place of tiles that have not
+ * yet been re-rendered. Tiles are rendered in paintEvent within a time
+ * budget, and the remainder are deferred to following frames.
+ *
+ * While the presenter is navigating, tiles are rendered in draft mode from
+ * reduced-resolution layer caches, and re-rendered at full quality when
+ * navigation ends or the view has been still for a short time.
+ *
+ * The tiles are registered with CacheManager, which may release those that
+ * are off screen.
+ *
+ * Enabled in place of ViewPort by setting the ADDLE_TILED_CANVAS environment
+ * variable.
+ */
+class ADDLE_WIDGETSGUI_EXPORT TiledCanvasView : public QWidget
+{
+    Q_OBJECT
+public:
+    TiledCanvasView(IViewPortPresenter& presenter, QWidget* parent = nullptr);
+    virtual ~TiledCanvasView() = default;
+
+    static bool isEnabled();
+
+    static constexpr const char* ENABLE_ENV_VARIABLE_NAME = "ADDLE_TILED_CANVAS";
+    static constexpr int TILE_SIZE = 128;
+
+    // Time in milliseconds that one paint event may spend rendering tiles
+    // when there is something (a preview or stale tile) to show instead.
+    static constexpr int RENDER_BUDGET = 8;
+
+    static constexpr int REFINE_DELAY = 150;
+
+protected:
+    void paintEvent(QPaintEvent* event) override;
+    void resizeEvent(QResizeEvent* event) override;
+    void moveEvent(QMoveEvent* event) override;
+
+    void mousePressEvent(QMouseEvent* event) override;
+    void mouseMoveEvent(QMouseEvent* event) override;
+    void mouseReleaseEvent(QMouseEvent* event) override;
+
+    void enterEvent(QEvent* event) override;
+    void leaveEvent(QEvent* event) override;
+
+    void focusInEvent(QFocusEvent* event) override;
+    void focusOutEvent(QFocusEvent* event) override;
+
+private slots:
+    void setDocument(QSharedPointer<IDocumentPresenter> documentPresenter);
+    void onLayersChanged();
+    void onTransformsChanged();
+    void onRenderChanged(QRect area);
+    void onNavigatingChanged(bool navigating);
+    void onRefineTimeout();
+    void updateCursor();
+
+private:
+    struct Tile
+    {
+        QImage image;
+        bool valid = false;
+        bool draft = false;
+    };
+
+    QRect tileRect(QPoint index) const;
+    QRect tileIndices(QRect storeRect) const;
+
+    void renderTile(QPoint index, Tile& tile);
+    void drawStore(QPainter& painter, QRect widgetRect);
+
+    void invalidate(QRect storeRect);
+    void invalidateAll();
+    void takePreview(QTransform newFromCanvas);
+    // Drops tiles further than `margin` pixels outside the view.
+    void evictTiles(int margin = TILE_SIZE);
+    void updateTileBytes();
+    void setDraft(bool draft);
+
+    void sendMouseEvent(QMouseEvent* event, CanvasMouseEvent::Action action);
+
+    IViewPortPresenter& _presenter;
+    QSharedPointer<IDocumentPresenter> _documentPresenter;
+
+    // Bottom-most first
+    QList<QSharedPointer<ILayerPresenter>> _layers;
+    QList<QSharedPointer<LayerMipCache>> _mipCaches;
+
+    QHash<QPoint, Tile> _tiles;
+    QPoint _origin;
+    QTransform _fromCanvas;
+
+    QImage _preview;
+    QTransform _previewTransform;
+
+    QPixmap _texture;
+
+    bool _isDraft = false;
+    QTimer _refineTimer;
+
+    // The bytes held by tile images, which CacheManager may read from any
+    // thread.
+    QAtomicInteger<qint64> _tileBytes;
+
+    CacheManager::Registration _registration;
+};
+
+} // namespace Addle
+
+#endif // TILEDCANVASVIEW_HPP
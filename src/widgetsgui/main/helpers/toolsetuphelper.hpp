@@ -44,7 +44,7 @@ public:
         )
     {
         typedef typename ToolBarType::PresenterType PresenterType;
-        auto presenter = _mainEditorPresenter.tools().value(tool).dynamicCast<PresenterType>();
+        auto presenter = _mainEditorPresenter.toolPresenter(tool).dynamicCast<PresenterType>();
 
         OptionAction* selectAction = new OptionAction(tool, _owner);
         selectAction->setText(dynamic_qtTrId({"tools", tool.key(), "name"}));
@@ -25,10 +25,12 @@
 
 #include "colorselector.hpp"
 #include "viewport.hpp"
+#include "canvas/tiledcanvasview.hpp"
 
 #include "utilities/qobject.hpp"
 #include "utilities/presenter/propertybinding.hpp"
 #include "utilities/widgetproperties.hpp"
+#include "utilities/debugging/startuptrace.hpp"
 
 #include "helpers/toolsetuphelper.hpp"
 
@@ -52,6 +54,8 @@ MainEditorWindow::MainEditorWindow(IMainEditorPresenter& presenter)
 
 void MainEditorWindow::setupUi()
 {
+    ADDLE_TRACE_STARTUP("MainEditorWindow::setupUi");
+
     _menuBar = new QMenuBar(this);
     QMainWindow::setMenuBar(_menuBar);
 
@@ -72,7 +76,10 @@ void MainEditorWindow::setupUi()
         BindingConverter::negate()
     );
 
-    _viewPort = new ViewPort(_presenter.viewPortPresenter());
+    if (TiledCanvasView::isEnabled())
+        _viewPort = new TiledCanvasView(_presenter.viewPortPresenter());
+    else
+        _viewPort = new ViewPort(_presenter.viewPortPresenter());
     _viewPortScrollWidget = new ViewPortScrollWidget(_presenter.viewPortPresenter(), this);
     _viewPortScrollWidget->setViewPort(_viewPort);
     QMainWindow::setCentralWidget(_viewPortScrollWidget);
@@ -100,11 +107,66 @@ void MainEditorWindow::setupUi()
         IMainEditorPresenter::Meta::Properties::currentTool
     );
 
+    _action_previousImage = new QAction(this);
+    _action_previousImage->setText(qtTrId("ui.previous-image.name"));
+    _action_previousImage->setToolTip(qtTrId("ui.previous-image.description"));
+    _action_previousImage->setShortcut(QKeySequence(Qt::Key_PageUp));
+    connect_interface(_action_previousImage, SIGNAL(triggered()), &_presenter, SLOT(browsePrevious()));
+
+    _action_nextImage = new QAction(this);
+    _action_nextImage->setText(qtTrId("ui.next-image.name"));
+    _action_nextImage->setToolTip(qtTrId("ui.next-image.description"));
+    _action_nextImage->setShortcut(QKeySequence(Qt::Key_PageDown));
+    connect_interface(_action_nextImage, SIGNAL(triggered()), &_presenter, SLOT(browseNext()));
+
+    _action_edit = new QAction(this);
+    _action_edit->setText(qtTrId("ui.edit.name"));
+    _action_edit->setToolTip(qtTrId("ui.edit.description"));
+    connect(_action_edit, &QAction::triggered, this, &MainEditorWindow::onAction_edit);
+
+    _toolBar_documentActions->addAction(_action_open);
+    _toolBar_documentActions->addAction(_action_previousImage);
+    _toolBar_documentActions->addAction(_action_nextImage);
+    _toolBar_documentActions->addAction(_action_edit);
+
+    ToolSetupHelper setupHelper(
+        this,
+        _presenter,
+        _optionGroup_toolSelection
+    );
+
+    setupHelper.addTool(
+        CoreTools::Navigate,
+        &_action_selectNavigateTool,
+        &_optionsToolBar_navigate
+    );
+
+    _toolBar_editorToolSelection->addAction(_action_selectNavigateTool);
+
+    setCorner(Qt::TopLeftCorner, Qt::LeftDockWidgetArea);
+    setCorner(Qt::BottomLeftCorner, Qt::LeftDockWidgetArea);
+    setCorner(Qt::TopRightCorner, Qt::RightDockWidgetArea);
+    setCorner(Qt::BottomRightCorner, Qt::RightDockWidgetArea);
+
+    connect_interface(&_presenter, SIGNAL(modeChanged(IMainEditorPresenter::Mode)),
+                              this, SLOT(onPresenterModeChanged()));
+    onPresenterModeChanged();
+}
+
+void MainEditorWindow::setupEditorUi()
+{
+    ADDLE_TRACE_STARTUP("MainEditorWindow::setupEditorUi");
+
     _action_new = new QAction(this);
     _action_new->setIcon(ADDLE_ICON("new"));
     _action_new->setToolTip(qtTrId("ui.new.description"));
     connect_interface(_action_new, SIGNAL(triggered()), &_presenter, SLOT(newDocument()));
 
+    _action_save = new QAction(this);
+    _action_save->setIcon(ADDLE_ICON("save"));
+    _action_save->setToolTip(qtTrId("ui.save.description"));
+    connect(_action_save, &QAction::triggered, this, &MainEditorWindow::onAction_save);
+
     _action_undo = new QAction(this);
     _action_undo->setIcon(ADDLE_ICON("undo"));
     _action_undo->setToolTip(qtTrId("ui.undo.description"));
@@ -117,12 +179,22 @@ void MainEditorWindow::setupUi()
     _action_redo->setEnabled(_presenter.canRedo());
     connect_interface(_action_redo, SIGNAL(triggered()), &_presenter, SLOT(redo()));
     
+    // The document actions are laid out again with the editor's among them.
+    _toolBar_documentActions->clear();
+
     _toolBar_documentActions->addAction(_action_new);
     _toolBar_documentActions->addAction(_action_open);
-    _toolBar_documentActions->addSeparator();
+    _toolBar_documentActions->addAction(_action_save);
+    _editorActions.append(_toolBar_documentActions->addSeparator());
     _toolBar_documentActions->addAction(_action_undo);
     _toolBar_documentActions->addAction(_action_redo);
 
+    _toolBar_documentActions->addAction(_action_previousImage);
+    _toolBar_documentActions->addAction(_action_nextImage);
+    _toolBar_documentActions->addAction(_action_edit);
+
+    _editorActions.append({ _action_new, _action_save, _action_undo, _action_redo });
+
     ToolSetupHelper setupHelper(
         this,
         _presenter,
@@ -141,49 +213,53 @@ void MainEditorWindow::setupUi()
         &_optionsToolBar_eraser
     );
 
-    setupHelper.addTool(
-        CoreTools::Navigate,
-        &_action_selectNavigateTool,
-        &_optionsToolBar_navigate
-    );
+    _toolBar_editorToolSelection->clear();
 
-    _toolBar_editorToolSelection->addAction(new QAction(ADDLE_ICON("select-tool"), "", this));
+    auto addEditorAction = [this] (QAction* action) {
+        _toolBar_editorToolSelection->addAction(action);
+        _editorActions.append(action);
+    };
+    auto addEditorSeparator = [this] () {
+        _editorActions.append(_toolBar_editorToolSelection->addSeparator());
+    };
 
-    _toolBar_editorToolSelection->addSeparator();
+    addEditorAction(new QAction(ADDLE_ICON("select-tool"), "", this));
 
-    _toolBar_editorToolSelection->addAction(_action_selectBrushTool);
-    _toolBar_editorToolSelection->addAction(_action_selectEraserTool);
-    _toolBar_editorToolSelection->addAction(new QAction(ADDLE_ICON("fill-tool"), "", this));
+    addEditorSeparator();
 
-    _toolBar_editorToolSelection->addSeparator();
+    addEditorAction(_action_selectBrushTool);
+    addEditorAction(_action_selectEraserTool);
+    addEditorAction(new QAction(ADDLE_ICON("fill-tool"), "", this));
 
-    _toolBar_editorToolSelection->addAction(new QAction(ADDLE_ICON("text-tool"), "", this));
-    _toolBar_editorToolSelection->addAction(new QAction(ADDLE_ICON("shapes-tool"), "", this));
-    _toolBar_editorToolSelection->addAction(new QAction(ADDLE_ICON("stickers-tool"), "", this));
+    addEditorSeparator();
 
-    _toolBar_editorToolSelection->addSeparator();
+    addEditorAction(new QAction(ADDLE_ICON("text-tool"), "", this));
+    addEditorAction(new QAction(ADDLE_ICON("shapes-tool"), "", this));
+    addEditorAction(new QAction(ADDLE_ICON("stickers-tool"), "", this));
 
-    _toolBar_editorToolSelection->addAction(_action_selectNavigateTool);
-    _toolBar_editorToolSelection->addAction(new QAction(ADDLE_ICON("eyedrop-tool"), "", this));
-    _toolBar_editorToolSelection->addAction(new QAction(ADDLE_ICON("measure-tool"), "", this));
+    addEditorSeparator();
 
-    setCorner(Qt::TopLeftCorner, Qt::LeftDockWidgetArea);
-    setCorner(Qt::BottomLeftCorner, Qt::LeftDockWidgetArea);
-    setCorner(Qt::TopRightCorner, Qt::RightDockWidgetArea);
-    setCorner(Qt::BottomRightCorner, Qt::RightDockWidgetArea);
+    _toolBar_editorToolSelection->addAction(_action_selectNavigateTool);
+    addEditorAction(new QAction(ADDLE_ICON("eyedrop-tool"), "", this));
+    addEditorAction(new QAction(ADDLE_ICON("measure-tool"), "", this));
 
     _layersManager = new LayersManager(this);
+    _layersManager->setPresenter(_presenter.documentPresenter());
     addDockWidget(Qt::RightDockWidgetArea, _layersManager);
 
     _colorSelector = new ColorSelector(_presenter.colorSelection(), this);
 
     addDockWidget(Qt::BottomDockWidgetArea, _colorSelector);
+
+    _editorUiIsSetup = true;
 }
 
 void MainEditorWindow::onUndoStateChanged()
 {
     //TODO: replace with PropertyBindings
 
+    if (!_editorUiIsSetup) return;
+
     _action_undo->setEnabled(_presenter.canUndo());
     _action_redo->setEnabled(_presenter.canRedo());
 }
@@ -200,6 +276,18 @@ void MainEditorWindow::onAction_open()
         _presenter.loadDocument(file);
 }
 
+void MainEditorWindow::onAction_save()
+{
+    QUrl file = QFileDialog::getSaveFileUrl(
+        this, 
+        qtTrId("ui.save-document.title"),
+        QUrl::fromLocalFile(QStandardPaths::writableLocation(QStandardPaths::PicturesLocation))
+    );
+
+    if (!file.isEmpty())
+        _presenter.saveDocument(file);
+}
+
 void MainEditorWindow::onPresenterError(QSharedPointer<IErrorPresenter> error)
 {
     QMessageBox* message = new QMessageBox(); 
@@ -253,7 +341,35 @@ void MainEditorWindow::onPresenterEmptyChanged(bool empty)
 
 void MainEditorWindow::onDocumentChanged(QSharedPointer<IDocumentPresenter> document)
 {
-    _layersManager->setPresenter(document);
+    if (_layersManager)
+        _layersManager->setPresenter(document);
+}
+
+void MainEditorWindow::onPresenterModeChanged()
+{
+    const bool editing = _presenter.mode() == IMainEditorPresenter::Editor;
+
+    if (editing && !_editorUiIsSetup)
+        setupEditorUi();
+
+    for (QAction* action : noDetach(_editorActions))
+        action->setVisible(editing);
+
+    if (_editorUiIsSetup)
+    {
+        _layersManager->setVisible(editing);
+        _colorSelector->setVisible(editing);
+    }
+
+    // Hidden actions' shortcuts are also disabled.
+    _action_previousImage->setVisible(!editing);
+    _action_nextImage->setVisible(!editing);
+    _action_edit->setVisible(!editing);
+}
+
+void MainEditorWindow::onAction_edit()
+{
+    _presenter.setMode(IMainEditorPresenter::Editor);
 }
 
 void MainEditorWindow::closeEvent(QCloseEvent* event)
@@ -278,6 +394,8 @@ void MainEditorView::initialize(IMainEditorPresenter& presenter)
 
 void MainEditorView::show()
 {
+    ADDLE_TRACE_STARTUP("MainEditorView::show");
+
     if (!_uiIsSetup)
     {
         _window->setupUi();
@@ -49,6 +49,8 @@ public:
 
 private slots:
     void onAction_open();
+    void onAction_save();
+    void onAction_edit();
 
     void onPresenterError(QSharedPointer<IErrorPresenter> error);
 
@@ -61,11 +63,19 @@ private slots:
 
     void onDocumentChanged(QSharedPointer<IDocumentPresenter> document);
 
+    void onPresenterModeChanged();
+
 protected:
     void closeEvent(QCloseEvent* event);
 
 private:
     void setupUi();
+
+    // Builds the parts of the window that are only used for editing. This is
+    // put off until the presenter is first in Editor mode, so a viewer starts
+    // without them.
+    void setupEditorUi();
+
     Q_SIGNAL void closeEventAccepted();
 
     IMainEditorPresenter& _presenter;
@@ -76,14 +86,23 @@ private:
     //QToolBar* _toolBar_viewerToolSelection;
     QStatusBar* _statusBar;
 
-    ViewPort* _viewPort;
+    QWidget* _viewPort; // ViewPort or TiledCanvasView
     ViewPortScrollWidget* _viewPortScrollWidget;
     ZoomRotateWidget* _zoomRotateWidget;
 
-    QAction* _action_new;
+    QAction* _action_new = nullptr;
     QAction* _action_open;
-    QAction* _action_undo;
-    QAction* _action_redo;
+    QAction* _action_save = nullptr;
+    QAction* _action_undo = nullptr;
+    QAction* _action_redo = nullptr;
+
+    QAction* _action_previousImage;
+    QAction* _action_nextImage;
+    QAction* _action_edit;
+
+    // Actions that are shown only in Editor mode.
+    QList<QAction*> _editorActions;
+    bool _editorUiIsSetup = false;
     
     QAction* _action_close;
 
@@ -121,8 +140,8 @@ private:
 
     QToolBar* _optionsToolBar_currentTool = nullptr;
 
-    LayersManager* _layersManager;
-    ColorSelector* _colorSelector;
+    LayersManager* _layersManager = nullptr;
+    ColorSelector* _colorSelector = nullptr;
 
     friend class MainEditorView;
     friend class ToolSetupHelper;
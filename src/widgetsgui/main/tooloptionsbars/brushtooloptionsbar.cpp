@@ -31,6 +31,13 @@ BrushToolOptionsBar::BrushToolOptionsBar(IBrushToolPresenter& presenter, QWidget
     : ToolOptionBarBase(presenter, parent),
     _presenter(presenter)
 {
+}
+
+void BrushToolOptionsBar::setupUi()
+{
+    // Building the brush selectors builds the brushes' presenters and icons,
+    // so it is put off until the tool is first selected.
+
     _favoriteBrushes = new FavoriteAssetsPicker(_presenter.brushSelection(), this);
     QToolBar::addWidget(_favoriteBrushes);
 
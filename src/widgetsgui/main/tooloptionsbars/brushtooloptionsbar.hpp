@@ -44,6 +44,9 @@ public:
 
     SizeSelectorButton* _button_sizeSelector;
 
+protected:
+    void setupUi() override;
+
 private slots:
     void onBrushChanged();
     void onRefreshPreviews();
@@ -29,7 +29,14 @@ ToolOptionBarBase::ToolOptionBarBase(IToolPresenter& presenter, QWidget* parent)
 void ToolOptionBarBase::onSelectedChanged(bool selected)
 {
     if (selected)
+    {
+        if (!_isSetup)
+        {
+            _isSetup = true;
+            setupUi();
+        }
         emit needsShown();
+    }
     else
         emit needsHidden();
 }
\ No newline at end of file
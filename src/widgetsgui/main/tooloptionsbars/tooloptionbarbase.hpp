@@ -26,6 +26,10 @@ public:
 protected:
     ToolOptionBarBase(IToolPresenter& presenter, QWidget* parent = nullptr);
 
+    // Called once, when the tool is first selected, so that a bar's contents
+    // are built only if it is ever shown.
+    virtual void setupUi() {}
+
 signals:
     void needsShown();
     void needsHidden();
@@ -36,6 +40,8 @@ private slots:
 private:
     IToolPresenter& _presenter;
     QWidget* _owner;
+
+    bool _isSetup = false;
 };
 
 } // namespace Addle
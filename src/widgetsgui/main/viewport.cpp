@@ -69,6 +69,17 @@ ViewPort::ViewPort(IViewPortPresenter& presenter)
 #endif
     );
 
+    _refineTimer.setSingleShot(true);
+    _refineTimer.setInterval(REFINE_DELAY);
+    connect(&_refineTimer, &QTimer::timeout, this, &ViewPort::onRefineTimeout);
+
+    connect_interface(
+        &_presenter,
+        SIGNAL(navigatingChanged(bool)),
+        this,
+        SLOT(onNavigatingChanged(bool))
+    );
+
     connect_interface(
         _presenter.mainEditorPresenter(),
         SIGNAL(documentPresenterChanged(QSharedPointer<IDocumentPresenter>)),
@@ -125,6 +136,25 @@ void ViewPort::onTransformsChanged()
     QGraphicsView::centerOn(_presenter.position());
 
     QGraphicsView::scene()->removeEventFilter(&blocker);
+
+    if (_presenter.isNavigating() && _canvasScene)
+    {
+        _canvasScene->setDraft(true);
+        _refineTimer.start();
+    }
+}
+
+void ViewPort::onNavigatingChanged(bool navigating)
+{
+    if (!navigating)
+        onRefineTimeout();
+}
+
+void ViewPort::onRefineTimeout()
+{
+    _refineTimer.stop();
+    if (_canvasScene)
+        _canvasScene->setDraft(false);
 }
 
 void ViewPort::setDocument(QSharedPointer<IDocumentPresenter> documentPresenter)
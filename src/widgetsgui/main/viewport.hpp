@@ -14,6 +14,7 @@
 #include <QGraphicsView>
 #include <QGraphicsScene>
 #include <QTransform>
+#include <QTimer>
 
 #include <QSharedPointer>
 
@@ -43,10 +44,18 @@ protected:
 private slots:
     void setDocument(QSharedPointer<IDocumentPresenter> documentPresenter);
     void onTransformsChanged();
+    void onNavigatingChanged(bool navigating);
+    void onRefineTimeout();
     void updateCursor();
 
 private:
-    CanvasScene* _canvasScene;
+    // While the presenter is navigating, the scene is drawn in draft mode.
+    // It's refined when navigation ends or the view has been still for this
+    // many milliseconds.
+    static constexpr int REFINE_DELAY = 150;
+
+    CanvasScene* _canvasScene = nullptr;
+    QTimer _refineTimer;
 
     IViewPortPresenter& _presenter;
     QSharedPointer<IDocumentPresenter> _documentPresenter;
@@ -17,8 +17,6 @@
 #include "utilities/presenter/propertybinding.hpp"
 #include "utilities/widgetproperties.hpp"
 
-#include "viewport.hpp"
-
 using namespace Addle;
 
 ViewPortScrollWidget::ViewPortScrollWidget(IViewPortPresenter& presenter, QWidget* parent)
@@ -53,15 +51,13 @@ ViewPortScrollWidget::ViewPortScrollWidget(IViewPortPresenter& presenter, QWidge
     connect_interface(_scrollbar_vertical, SIGNAL(valueChanged(int)), &_presenter, SLOT(scrollY(int)));
 }
 
-void ViewPortScrollWidget::setViewPort(ViewPort* viewPort)
+void ViewPortScrollWidget::setViewPort(QWidget* viewPort)
 {
     _viewPort = viewPort;
-
-    QWidget* viewPortWidget = dynamic_cast<QWidget*>(viewPort);
     //assert
 
-    viewPortWidget->setParent(this);
-    _layout->addWidget(viewPortWidget, 0, 0);
+    _viewPort->setParent(this);
+    _layout->addWidget(_viewPort, 0, 0);
 }
 
 void ViewPortScrollWidget::onScrollStateChanged()
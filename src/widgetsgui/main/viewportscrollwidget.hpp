@@ -19,8 +19,6 @@
 
 namespace Addle {
 
-class ViewPort;
-
 /**
  * It's easier to just make new scroll bars than to get the ones that come 
  * built into QGraphicsView to play nice with the presenter.
@@ -32,8 +30,8 @@ public:
     ViewPortScrollWidget(IViewPortPresenter& presenter, QWidget* parent = nullptr);
     virtual ~ViewPortScrollWidget() = default;
 
-    ViewPort* viewPort() { return _viewPort; }
-    void setViewPort(ViewPort* viewPort);
+    QWidget* viewPort() { return _viewPort; }
+    void setViewPort(QWidget* viewPort);
 
     QSize sizeHint() const { return QSize(640, 480); }
 
@@ -43,7 +41,7 @@ private slots:
 private:
     IViewPortPresenter& _presenter;
 
-    ViewPort* _viewPort = nullptr;
+    QWidget* _viewPort = nullptr;
 
     QGridLayout* _layout;
 
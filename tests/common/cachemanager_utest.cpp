@@ -0,0 +1,206 @@
+/**
+ * Addle test code
+ * @file
+ * @copyright Copyright 2020 Eleanor Hawk
+ * @copyright Modification and distribution permitted under the terms of the
+ * MIT License. See "LICENSE" for full details.
+ */
+
+#include <QtTest/QtTest>
+#include <QtDebug>
+#include <QObject>
+#include <QStringList>
+
+#include "utilities/cachemanager.hpp"
+#include "utilities/image/tilepool.hpp"
+
+using namespace Addle;
+
+namespace {
+
+// A cache that holds a number of bytes, and frees as many as it is asked to,
+// recording its name in `log` whenever it is asked.
+class TestCache
+{
+public:
+    TestCache(const QString& name, CacheManager::Priority priority, qint64 bytes, QStringList& log)
+        : _bytes(bytes),
+        _registration(CacheManager::add(
+            name,
+            priority,
+            [this]() { return _bytes; },
+            [this, name, &log](qint64 requested) {
+                log.append(name);
+                const qint64 freed = qMin(requested, _bytes);
+                _bytes -= freed;
+                return freed;
+            }
+        ))
+    {
+    }
+
+    qint64 bytes() const { return _bytes; }
+
+    void grow(qint64 bytes)
+    {
+        _bytes += bytes;
+        _registration.changed();
+    }
+
+    void touch() const { _registration.touch(); }
+    void reset() { _registration.reset(); }
+
+private:
+    qint64 _bytes;
+    CacheManager::Registration _registration;
+};
+
+const CacheManager::Usage* findUsage(const QList<CacheManager::Usage>& usage, const QString& name)
+{
+    for (const CacheManager::Usage& entry : usage)
+    {
+        if (entry.name == name)
+            return &entry;
+    }
+    return nullptr;
+}
+
+} // namespace
+
+class CacheManager_UTest : public QObject
+{
+    Q_OBJECT
+private slots:
+
+    void initTestCase()
+    {
+        _originalBudget = CacheManager::budget();
+    }
+
+    void init()
+    {
+        // The tile pool is registered as a cache too, and should not take
+        // part in these tests.
+        TilePool::trim();
+        CacheManager::setBudget(1000);
+    }
+
+    void cleanup()
+    {
+        CacheManager::setBudget(_originalBudget);
+    }
+
+    void withinBudget()
+    {
+        QStringList log;
+        TestCache a("a", CacheManager::Normal, 400, log);
+        TestCache b("b", CacheManager::Low, 600, log);
+
+        CacheManager::enforce();
+
+        QVERIFY(log.isEmpty());
+        QCOMPARE(CacheManager::totalBytes(), (qint64)1000);
+    }
+
+    void lowPriorityFirst()
+    {
+        QStringList log;
+        TestCache normal("normal", CacheManager::Normal, 600, log);
+        TestCache high("high", CacheManager::High, 600, log);
+        TestCache low("low", CacheManager::Low, 600, log);
+
+        // The low priority cache goes first, even though it was used last.
+        low.touch();
+        CacheManager::enforce();
+
+        QCOMPARE(log, QStringList({ "low", "normal" }));
+        QCOMPARE(low.bytes(), (qint64)0);
+        QCOMPARE(normal.bytes(), (qint64)400);
+        QCOMPARE(high.bytes(), (qint64)600);
+    }
+
+    void leastRecentlyUsedFirst()
+    {
+        QStringList log;
+        TestCache a("a", CacheManager::Normal, 400, log);
+        TestCache b("b", CacheManager::Normal, 400, log);
+        TestCache c("c", CacheManager::Normal, 400, log);
+
+        c.touch();
+        a.touch();
+
+        // Only as much as is over the budget is evicted.
+        CacheManager::enforce();
+
+        QCOMPARE(log, QStringList({ "b" }));
+        QCOMPARE(b.bytes(), (qint64)200);
+        QCOMPARE(CacheManager::totalBytes(), (qint64)1000);
+
+        log.clear();
+        CacheManager::setBudget(500);
+
+        QCOMPARE(log, QStringList({ "b", "c" }));
+        QCOMPARE(b.bytes(), (qint64)0);
+        QCOMPARE(c.bytes(), (qint64)100);
+        QCOMPARE(a.bytes(), (qint64)400);
+    }
+
+    void changedEnforces()
+    {
+        QStringList log;
+        TestCache a("a", CacheManager::Normal, 500, log);
+        TestCache b("b", CacheManager::Normal, 500, log);
+
+        b.touch();
+        b.grow(300);
+
+        QCOMPARE(log, QStringList({ "a" }));
+        QCOMPARE(a.bytes(), (qint64)200);
+        QCOMPARE(b.bytes(), (qint64)800);
+    }
+
+    void releaseMemory()
+    {
+        QStringList log;
+        TestCache a("a", CacheManager::High, 300, log);
+        TestCache b("b", CacheManager::Low, 200, log);
+
+        CacheManager::releaseMemory();
+
+        QCOMPARE(log, QStringList({ "b", "a" }));
+        QCOMPARE(CacheManager::totalBytes(), (qint64)0);
+
+        const QList<CacheManager::Usage> usage = CacheManager::usage();
+
+        const CacheManager::Usage* usageA = findUsage(usage, "a");
+        QVERIFY(usageA);
+        QCOMPARE(usageA->priority, CacheManager::High);
+        QCOMPARE(usageA->bytes, (qint64)0);
+        QCOMPARE(usageA->evicted, (qint64)300);
+
+        const CacheManager::Usage* usageB = findUsage(usage, "b");
+        QVERIFY(usageB);
+        QCOMPARE(usageB->evicted, (qint64)200);
+    }
+
+    void reset()
+    {
+        QStringList log;
+        TestCache a("a", CacheManager::Normal, 2000, log);
+
+        QVERIFY(findUsage(CacheManager::usage(), "a"));
+
+        a.reset();
+
+        QVERIFY(!findUsage(CacheManager::usage(), "a"));
+        CacheManager::enforce();
+        QVERIFY(log.isEmpty());
+    }
+
+private:
+    qint64 _originalBudget = 0;
+};
+
+QTEST_MAIN(CacheManager_UTest)
+
+#include "cachemanager_utest.moc"
@@ -0,0 +1,70 @@
+/**
+ * Addle test code
+ * @file
+ * @copyright Copyright 2020 Eleanor Hawk
+ * @copyright Modification and distribution permitted under the terms of the
+ * MIT License. See "LICENSE" for full details.
+ */
+
+#include <QtTest/QtTest>
+#include <QtDebug>
+#include <QObject>
+
+#include "utilities/render/dirtyregion.hpp"
+
+using namespace Addle;
+
+class DirtyRegion_UTest : public QObject
+{
+    Q_OBJECT
+private slots:
+
+    void snap()
+    {
+        DirtyRegion dirty(64);
+
+        QVERIFY(dirty.snapToTiles(QRect(10, 10, 4, 4)) == QRect(0, 0, 64, 64));
+        QVERIFY(dirty.snapToTiles(QRect(60, 0, 8, 1)) == QRect(0, 0, 128, 64));
+        QVERIFY(dirty.snapToTiles(QRect(-1, -1, 2, 2)) == QRect(-64, -64, 128, 128));
+        QVERIFY(dirty.snapToTiles(QRect(-64, 0, 64, 64)) == QRect(-64, 0, 64, 64));
+    }
+
+    void merge()
+    {
+        DirtyRegion dirty(64);
+        dirty.add(QRect(1, 1, 2, 2));
+        dirty.add(QRect(5, 5, 2, 2));
+
+        QVERIFY(dirty.region() == QRegion(0, 0, 64, 64));
+    }
+
+    void diagonal()
+    {
+        DirtyRegion dirty(64);
+        for (int i = 0; i < 4; ++i)
+            dirty.add(QRect(i * 64 + 10, i * 64 + 10, 8, 8));
+
+        QRegion region = dirty.region();
+        QVERIFY(region.boundingRect() == QRect(0, 0, 256, 256));
+        QVERIFY(region.rectCount() == 4);
+        QVERIFY(!region.contains(QPoint(200, 10)));
+    }
+
+    void take()
+    {
+        DirtyRegion dirty;
+        QVERIFY(dirty.isEmpty());
+
+        dirty.add(QRect(0, 0, 1, 1));
+        dirty.add(QRect());
+        QVERIFY(!dirty.isEmpty());
+
+        QRegion region = dirty.take();
+        QVERIFY(!region.isEmpty());
+        QVERIFY(dirty.isEmpty());
+    }
+};
+
+QTEST_MAIN(DirtyRegion_UTest)
+
+#include "dirtyregion_utest.moc"
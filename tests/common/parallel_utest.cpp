@@ -0,0 +1,148 @@
+/**
+ * Addle test code
+ * @file
+ * @copyright Copyright 2020 Eleanor Hawk
+ * @copyright Modification and distribution permitted under the terms of the
+ * MIT License. See "LICENSE" for full details.
+ */
+
+#include <QtTest/QtTest>
+#include <QtDebug>
+#include <QObject>
+#include <QAtomicInt>
+#include <QMutex>
+#include <QRegion>
+#include <QSet>
+#include <QThread>
+#include <QVector>
+
+#include <stdexcept>
+
+#include "utilities/parallel.hpp"
+
+using namespace Addle;
+
+class Parallel_UTest : public QObject
+{
+    Q_OBJECT
+private slots:
+
+    void emptyRange()
+    {
+        bool called = false;
+        QVERIFY(parallelFor(5, 5, [&](int) { called = true; }));
+        QVERIFY(parallelFor(5, 0, [&](int) { called = true; }));
+        QVERIFY(!called);
+    }
+
+    void everyIndexOnce_data()
+    {
+        QTest::addColumn<int>("grain");
+
+        QTest::newRow("1") << 1;
+        QTest::newRow("7") << 7;
+        QTest::newRow("64") << 64;
+    }
+
+    void everyIndexOnce()
+    {
+        QFETCH(int, grain);
+
+        const int begin = -13;
+        const int end = 5000;
+
+        QVector<QAtomicInt> hits(end - begin);
+        QVERIFY(parallelFor(begin, end, [&](int i) { hits[i - begin].ref(); }, {}, grain));
+
+        for (const QAtomicInt& count : hits)
+            QCOMPARE(count.loadAcquire(), 1);
+    }
+
+    // The caller's range is made slow, so the other workers run out and must
+    // take from it.
+    void stealing()
+    {
+        const int workers = QThread::idealThreadCount();
+        if (workers < 2)
+            QSKIP("Needs more than one thread");
+
+        const int perWorker = 64;
+        const int count = workers * perWorker;
+
+        QMutex mutex;
+        QSet<Qt::HANDLE> threads;
+
+        QVERIFY(parallelFor(0, count, [&](int i) {
+            if (i >= perWorker) return;
+
+            QThread::msleep(2);
+
+            const QMutexLocker lock(&mutex);
+            threads.insert(QThread::currentThreadId());
+        }));
+
+        QVERIFY(threads.size() > 1);
+    }
+
+    void cancellation()
+    {
+        const int count = 100000;
+        QAtomicInt done;
+
+        const bool finished = parallelFor(
+            0, count,
+            [&](int) { done.ref(); },
+            [&]() { return done.loadAcquire() >= 100; }
+        );
+
+        QVERIFY(!finished);
+        QVERIFY(done.loadAcquire() >= 100);
+        QVERIFY(done.loadAcquire() < count);
+    }
+
+    void exceptionPropagation()
+    {
+        QAtomicInt done;
+
+        QVERIFY_EXCEPTION_THROWN(
+            parallelFor(0, 10000, [&](int i) {
+                if (i == 500) throw std::runtime_error("kernel failed");
+                done.ref();
+            }),
+            std::runtime_error
+        );
+
+        // Nothing more is started once the kernel throws.
+        QVERIFY(done.loadAcquire() < 9999);
+
+        // The helpers have all finished, so the pool is still usable.
+        QAtomicInt after;
+        QVERIFY(parallelFor(0, 100, [&](int) { after.ref(); }));
+        QCOMPARE(after.loadAcquire(), 100);
+    }
+
+    void tilesCoverArea()
+    {
+        const QRect area(-30, 7, 1000, 300);
+
+        QMutex mutex;
+        QRegion covered;
+        bool overlapped = false;
+        bool outside = false;
+
+        QVERIFY(parallelForTiles(area, [&](QRect tile) {
+            const QMutexLocker lock(&mutex);
+            if (covered.intersects(tile)) overlapped = true;
+            if (!area.contains(tile)) outside = true;
+            covered += tile;
+        }, {}, 128));
+
+        QVERIFY(!overlapped);
+        QVERIFY(!outside);
+        QVERIFY(covered == QRegion(area));
+    }
+};
+
+QTEST_MAIN(Parallel_UTest)
+
+#include "parallel_utest.moc"
@@ -0,0 +1,84 @@
+/**
+ * Addle test code
+ * @file
+ * @copyright Copyright 2020 Eleanor Hawk
+ * @copyright Modification and distribution permitted under the terms of the
+ * MIT License. See "LICENSE" for full details.
+ */
+
+#include <QtTest/QtTest>
+#include <QtDebug>
+#include <QObject>
+#include <QByteArray>
+#include <QRandomGenerator>
+
+#include "utilities/image/pixelkernels.hpp"
+
+using namespace Addle;
+
+class PixelKernels_UTest : public QObject
+{
+    Q_OBJECT
+private slots:
+
+    void scalarAlwaysSupported()
+    {
+        const PixelKernels::Table* scalar = PixelKernels::table(PixelKernels::Scalar);
+        QVERIFY(scalar);
+        QVERIFY(scalar->instructionSet == PixelKernels::Scalar);
+        QVERIFY(PixelKernels::table(PixelKernels::get().instructionSet) != nullptr);
+    }
+
+    void xorBytes_data()
+    {
+        QTest::addColumn<int>("instructionSet");
+
+        for (int i = PixelKernels::Scalar; i <= PixelKernels::NEON; ++i)
+            QTest::newRow(PixelKernels::name((PixelKernels::InstructionSet)i)) << i;
+    }
+
+    // Each supported table must agree with the scalar reference, for lengths
+    // and alignments that exercise both the vector loop and the remainder.
+    void xorBytes()
+    {
+        QFETCH(int, instructionSet);
+
+        const PixelKernels::Table* table = PixelKernels::table((PixelKernels::InstructionSet)instructionSet);
+        if (!table)
+            QSKIP("Not supported on this CPU");
+
+        const PixelKernels::Table* scalar = PixelKernels::table(PixelKernels::Scalar);
+
+        QRandomGenerator random(1234);
+        QByteArray source(512, Qt::Uninitialized);
+        QByteArray original(512, Qt::Uninitialized);
+        random.fillRange(reinterpret_cast<quint32*>(source.data()), source.size() / 4);
+        random.fillRange(reinterpret_cast<quint32*>(original.data()), original.size() / 4);
+
+        for (int offset = 0; offset < 4; ++offset)
+        {
+            for (int length = 0; length <= 260; ++length)
+            {
+                QByteArray expected = original;
+                QByteArray actual = original;
+
+                scalar->xorBytes(
+                    reinterpret_cast<uchar*>(expected.data()) + offset,
+                    reinterpret_cast<const uchar*>(source.constData()) + 3,
+                    length
+                );
+                table->xorBytes(
+                    reinterpret_cast<uchar*>(actual.data()) + offset,
+                    reinterpret_cast<const uchar*>(source.constData()) + 3,
+                    length
+                );
+
+                QVERIFY(actual == expected);
+            }
+        }
+    }
+};
+
+QTEST_MAIN(PixelKernels_UTest)
+
+#include "pixelkernels_utest.moc"
@@ -0,0 +1,161 @@
+/**
+ * Addle test code
+ * @file
+ * @copyright Copyright 2020 Eleanor Hawk
+ * @copyright Modification and distribution permitted under the terms of the
+ * MIT License. See "LICENSE" for full details.
+ */
+
+#include <QtTest/QtTest>
+#include <QtDebug>
+#include <QObject>
+#include <QImage>
+
+#include <utility>
+
+#include "utilities/image/tilepool.hpp"
+
+using namespace Addle;
+
+class TilePool_UTest : public QObject
+{
+    Q_OBJECT
+private slots:
+
+    void init()
+    {
+        TilePool::trim();
+    }
+
+    void alignmentAndSize_data()
+    {
+        QTest::addColumn<int>("size");
+
+        QTest::newRow("1") << 1;
+        QTest::newRow("min block") << (int)TilePool::MIN_BLOCK_SIZE;
+        QTest::newRow("min block + 1") << (int)TilePool::MIN_BLOCK_SIZE + 1;
+        QTest::newRow("tile") << 64 * 64 * 4;
+        QTest::newRow("odd") << 100003;
+    }
+
+    void alignmentAndSize()
+    {
+        QFETCH(int, size);
+
+        TilePool::Block block = TilePool::allocate(size);
+        QVERIFY(!block.isNull());
+        QCOMPARE((quintptr)block.data() % TilePool::ALIGNMENT, (quintptr)0);
+        QVERIFY(block.size() >= (std::size_t)size);
+        QVERIFY(block.size() < (std::size_t)size * 2 || block.size() == TilePool::MIN_BLOCK_SIZE);
+    }
+
+    void zeroSize()
+    {
+        QVERIFY(TilePool::allocate(0).isNull());
+    }
+
+    // A block released on this thread is handed back for the next request of
+    // its size class.
+    void reuse()
+    {
+        const TilePool::Stats before = TilePool::stats();
+
+        TilePool::Block first = TilePool::allocate(10000);
+        uchar* const data = first.data();
+        first.reset();
+        QVERIFY(first.isNull());
+
+        TilePool::Block second = TilePool::allocate(12000);
+        QCOMPARE(second.data(), data);
+
+        const TilePool::Stats after = TilePool::stats();
+        QCOMPARE(after.allocations - before.allocations, (qint64)1);
+        QCOMPARE(after.reuses - before.reuses, (qint64)1);
+    }
+
+    void stats()
+    {
+        const TilePool::Stats before = TilePool::stats();
+        QCOMPARE(before.bytesPooled, (qint64)0);
+
+        TilePool::Block block = TilePool::allocate(5000);
+        const qint64 size = (qint64)block.size();
+
+        TilePool::Stats stats = TilePool::stats();
+        QCOMPARE(stats.bytesInUse - before.bytesInUse, size);
+        QCOMPARE(stats.bytesPooled, (qint64)0);
+        QVERIFY(stats.highWaterMark >= stats.bytesInUse);
+
+        block.reset();
+
+        stats = TilePool::stats();
+        QCOMPARE(stats.bytesInUse, before.bytesInUse);
+        QCOMPARE(stats.bytesPooled, size);
+
+        TilePool::trim();
+
+        stats = TilePool::stats();
+        QCOMPARE(stats.bytesPooled, (qint64)0);
+    }
+
+    void moveTransfersOwnership()
+    {
+        const TilePool::Stats before = TilePool::stats();
+
+        TilePool::Block first = TilePool::allocate(5000);
+        uchar* const data = first.data();
+
+        TilePool::Block second(std::move(first));
+        QVERIFY(first.isNull());
+        QCOMPARE(second.data(), data);
+
+        first = std::move(second);
+        QVERIFY(second.isNull());
+        QCOMPARE(first.data(), data);
+
+        first.reset();
+        QCOMPARE(TilePool::stats().bytesInUse, before.bytesInUse);
+    }
+
+    // Requests larger than the largest size class go straight back to the
+    // heap when released.
+    void largeNotPooled()
+    {
+        const std::size_t largest = TilePool::MIN_BLOCK_SIZE << (TilePool::SIZE_CLASSES - 1);
+
+        TilePool::Block block = TilePool::allocate(largest + 1);
+        QVERIFY(!block.isNull());
+        QCOMPARE((quintptr)block.data() % TilePool::ALIGNMENT, (quintptr)0);
+        QVERIFY(block.size() >= largest + 1);
+
+        block.reset();
+        QCOMPARE(TilePool::stats().bytesPooled, (qint64)0);
+    }
+
+    void image()
+    {
+        const TilePool::Stats before = TilePool::stats();
+
+        {
+            QImage image = TilePool::image(QSize(33, 17), QImage::Format_ARGB32_Premultiplied);
+            QVERIFY(!image.isNull());
+            QCOMPARE(image.size(), QSize(33, 17));
+            QCOMPARE(image.format(), QImage::Format_ARGB32_Premultiplied);
+            QCOMPARE((quintptr)image.constBits() % TilePool::ALIGNMENT, (quintptr)0);
+            QVERIFY(TilePool::stats().bytesInUse > before.bytesInUse);
+
+            // A copy shares the block, so it is only released with the last
+            // copy.
+            QImage copy = image;
+            image = QImage();
+            QVERIFY(TilePool::stats().bytesInUse > before.bytesInUse);
+        }
+
+        QCOMPARE(TilePool::stats().bytesInUse, before.bytesInUse);
+        QVERIFY(TilePool::image(QSize(), QImage::Format_ARGB32).isNull());
+    }
+};
+
+QTEST_MAIN(TilePool_UTest)
+
+#include "tilepool_utest.moc"